@@ -51,97 +51,38 @@
  
 #include "board_diag.h"
 
-/* Declare one global variable to capture the output of the buttons (SW0-SW3),
- * when they are pressed.
- */
- 
-volatile int edge_capture;
-
 /* *********************************************************************
  * Menu related functions 
  * *********************************************************************
- * A valid STDOUT device must be defined for these functions to work.
- *  - a JTAG UART is the recommended STDOUT device.
- */
-
-/* void MenuBegin( char *title )
- * 
- * Function to set the Menu "header".
+ * Each menu is a list of entries expanded by MENU_DEFINE into a const
+ * table and a pre-rendered screen; see menu.h.  An entry whose peripheral
+ * is missing from system.h is left out of both.
  */
 
-static void MenuBegin( char *title )
-{
-  printf("\n\n");
-  printf("----------------------------------\n");
-  printf("Nios II Board Diagnostics\n");
-  printf("----------------------------------\n");
-  printf(" %s\n",title);
-}
-
-/**********************************************************************
- * static void MenuItem( char letter, char *string )
- * 
- * Function to define a menu entry.
- *  - Maps a character (defined by 'letter') to a description string
- *    (defined by 'string').
- *
- **********************************************************************/
-
-static void MenuItem( char letter, char *name )
-{
-  printf("     %c:  %s\n" ,letter, name);
-}
-
 /******************************************************************
 *  Function: GetInputString
 *
-*  Purpose: Parses an input string for the character '\n'.  Then
-*           returns the string, minus any '\r' characters it 
-*           encounters.
+*  Purpose: Waits for the next line from the console and returns
+*           it with its '\n' and a NUL terminator, minus any '\r'
+*           characters, truncated to fit 'size'.  Animations and
+*           the UART keep running while it waits.  'stream' must
+*           be stdin.  At the end of a redirected input (host
+*           build) it returns "q", so every menu unwinds.
 *
 ******************************************************************/
 void GetInputString( char* entry, int size, FILE * stream )
 {
-  int i;
-  int ch = 0;
-  
-  for(i = 0; (ch != '\n') && (i < size); )
-  {
-    if( (ch = getc(stream)) != '\r')
-    {
-      entry[i] = ch;
-      i++;
-    }
-  }
-}
-
-/* void MenuEnd(char lowLetter, char highLetter)
- * 
- * Function which defines the menu exit/end conditions.
- *  In this context, the character 'q' always means 'exit'.
- *    The code grabs input from STDIN (via the GetInputString function)
- *    and continues until either a 'q' or a character outside of the 
- *    range, enclosed by 'lowLetter' and 'highLetter', is reached.
- */
-
-static int MenuEnd( char lowLetter, char highLetter )
-{
-  static char entry[4];
-  static char ch;
+  int len;
 
-  printf("     q:  Exit\n");
-  printf("----------------------------------\n");
-  printf("\nSelect Choice (%c-%c): [Followed by <enter>]",lowLetter,highLetter);
-  
-  GetInputString( entry, sizeof(entry), stdin );
-  if(sscanf(entry, "%c\n", &ch))
+  (void) stream;
+  len = console_read_line( entry, size - 1 );
+  if (len == CONSOLE_EOF)
   {
-    if( ch >= 'A' && ch <= 'Z' )
-      ch += 'a' - 'A';
-    if( ch == 27 )
-      ch = 'q';        
+    entry[0] = 'q';
+    len = 1;
   }
-  return ch;
+  entry[len] = '\n';
+  entry[len + 1] = '\0';
 }
 
 #ifdef JTAG_UART_NAME
@@ -154,28 +95,16 @@ static int MenuEnd( char lowLetter, char highLetter )
  * 
  ******************************************************************************/
 
+#define JTAG_UART_MENU(X) \
+  X(ALWAYS, a, "Send Lots",     UARTSendLots) \
+  X(ALWAYS, b, "Receive Chars", UARTReceiveChars) \
+  X(ALWAYS, c, "Benchmark",     DoUARTBenchMenu)
+
+MENU_DEFINE(jtag_uart_menu, "JTAG UART Menu", JTAG_UART_MENU);
+
 static void DoJTAGUARTMenu( void )
 {
-  static char ch;  
-  
-  while (1)
-  {
-    MenuBegin( "JTAG UART Menu" );
-    MenuItem( 'a', "Send Lots" );
-    MenuItem( 'b', "Receive Chars" );
-    ch = MenuEnd('a', 'b');
-
-    switch (ch)
-    {
-      MenuCase('a', UARTSendLots);
-      MenuCase('b', UARTReceiveChars);
-    }
-    
-    if (ch == 'q')
-    {
-      break;
-    }
-  }
+  menu_run(&jtag_uart_menu);
 }
 
 #endif
@@ -190,97 +119,70 @@ static void DoJTAGUARTMenu( void )
  * 
  ******************************************************************************/
 
+#define SEVEN_SEG_MENU(X) \
+  X(ALWAYS, a, "Count From 0 to FF.",          SevenSegCount) \
+  X(ALWAYS, b, "Control Individual Segments.", SevenSegControl) \
+  X(ALWAYS, c, "Show Text.",                   SevenSegText)
+
+MENU_DEFINE(seven_seg_menu, "Seven Segment Menu", SEVEN_SEG_MENU);
+
 static void DoSevenSegMenu( void )
 {
-  static char ch;
-
-  while(1)
-  {
-    MenuBegin("Seven Segment Menu");
-    MenuItem('a', "Count From 0 to FF.");
-    MenuItem('b', "Control Individual Segments.");
-    ch = MenuEnd('a', 'b');
-  
-    switch(ch)
-    {
-      MenuCase('a', SevenSegCount);
-      MenuCase('b', SevenSegControl);
-    }
-    
-    if ( ch == 'q' )
-    {
-      break;
-    }
-  }
+  menu_run(&seven_seg_menu);
 }
 
 #endif
 
 /*******************************************************************************
  * 
- * Generates the top level menu for this diagnostics program.
+ * static void DoPerfMenu( void )
+ * 
+ * Generates the performance measurement menu.
  * 
  ******************************************************************************/
 
-static char TopMenu( void )
+#define PERF_MENU(X) \
+  X(ALWAYS, a, "Timer Accuracy",       TimerAccuracy) \
+  X(ALWAYS, b, "Input Latency",        InputLatency) \
+  X(ALWAYS, c, "LED Animations",       LEDAnimations) \
+  X(ALWAYS, d, "PIO Write Coalescing", PIOCoalescing) \
+  X(ALWAYS, e, "LCD Update Cost",      LCDUpdateCost) \
+  X(ALWAYS, f, "Task Scheduler",       SchedulerStats) \
+  X(ALWAYS, g, "Debounce Stress",      DebounceStress) \
+  X(ALWAYS, h, "Bus Profiler",         DoBusProfMenu) \
+  X(ALWAYS, i, "Timing Stress",        TimingStress) \
+  X(ALWAYS, j, "Formatter Cost",       FormatterCost) \
+  X(ALWAYS, k, "Red LED Counter",      RedLEDCounter) \
+  X(ALWAYS, l, "CPU Load",             CPULoad) \
+  X(LCD_DISPLAY, m, "LCD Fast Path",    LCDFastPath) \
+  X(ALWAYS, n, "LED Brightness",       LEDBrightness)
+
+MENU_DEFINE(perf_menu, "Performance Menu", PERF_MENU);
+
+static void DoPerfMenu( void )
 {
-  static char ch;
-  
-  /* Output the top-level menu to STDOUT */
+  menu_run(&perf_menu);
+}
 
-  while (1)
-  {
-    MenuBegin("Main Menu");
-#ifdef LED_PIO_NAME
-    MenuItem( 'a', "Test LEDs" );
-#endif
-#ifdef LCD_DISPLAY_NAME
-    MenuItem( 'b', "LCD Display Test");
-#endif
-#ifdef BUTTON_PIO_NAME
-    MenuItem( 'c', "Button/Switch Test");
-#endif
-#ifdef SEVEN_SEG_PIO_NAME
-    MenuItem( 'd', "Seven Segment Menu" );
-#endif
-#ifdef JTAG_UART_NAME
-    MenuItem( 'e', "JTAG UART Menu" );
-#endif  
-#ifdef KEY_NAME
-    MenuItem( 'f', "Project Modification" );
-#endif
-    ch = MenuEnd('a', 'f');
+/*******************************************************************************
+ * 
+ * The top level menu for this diagnostics program, run from main().
+ * 
+ ******************************************************************************/
 
-  
-    switch(ch)
-    {
-#ifdef LED_PIO_NAME
-      MenuCase('a',TestLEDs);
-#endif
-#ifdef LCD_DISPLAY_NAME
-      MenuCase('b',TestLCD);
-#endif
-#ifdef BUTTON_PIO_NAME
-      MenuCase('c',TestButtons);
-#endif
-#ifdef SEVEN_SEG_PIO_NAME
-      MenuCase('d',DoSevenSegMenu);
-#endif
-#ifdef JTAG_UART_NAME
-      MenuCase('e',DoJTAGUARTMenu);
-#endif
-#ifdef KEY_NAME
-    MenuCase( 'f',Test_Func);
-#endif
-      case 'q':	break;
-      default:	printf("\n -ERROR: %c is an invalid entry.  Please try again\n", ch); break;
-    }
-    
-    if (ch == 'q' )
-      break;
-  }
-  return( ch );
-}
+#define TOP_MENU(X) \
+  X(LED_PIO,       a, "Test LEDs",               TestLEDs) \
+  X(LCD_DISPLAY,   b, "LCD Display Test",        TestLCD) \
+  X(BUTTON_PIO,    c, "Button/Switch Test",      TestButtons) \
+  X(SEVEN_SEG_PIO, d, "Seven Segment Menu",      DoSevenSegMenu) \
+  X(JTAG_UART,     e, "JTAG UART Menu",          DoJTAGUARTMenu) \
+  X(KEY,           f, "Project Modification",    Test_Func) \
+  X(ALWAYS,        g, "Performance Menu",        DoPerfMenu) \
+  X(ALWAYS,        h, "Command Console",         CommandConsole) \
+  X(ALWAYS,        i, "Self-Test (no operator)", SelfTest) \
+  X(ONCHIP_MEM,    j, "On-Chip Memory Test",     MemoryTest)
+
+MENU_DEFINE(top_menu, "Main Menu", TOP_MENU);
 
 /* ********************************************************************
  * 
@@ -305,7 +207,7 @@ static void TestLEDs(void)
   
   /* Turn the LEDs on. */
   led = 0xff;
-  IOWR_ALTERA_AVALON_PIO_DATA(LED_PIO_BASE, led);
+  pio_shadow_write(PIO_OUT_LED, led);
   printf( "\nAll LEDs should now be on.\n" );
   printf( "\tPlease press 'q' [Followed by <enter>] to exit this test.\n" );
   
@@ -317,7 +219,7 @@ static void TestLEDs(void)
   
   /* Turn the LEDs off and exit. */
   led = 0x0;
-  IOWR_ALTERA_AVALON_PIO_DATA(LED_PIO_BASE, led);
+  pio_shadow_write(PIO_OUT_LED, led);
   printf(".....Exiting LED Test.\n");
 }
 #endif
@@ -338,7 +240,7 @@ static void TestLCD( void )
   static char ch;
   static char entry[4];
   
-  lcd = fopen("/dev/lcd_display", "w");
+  lcd = lcd_fb_stream();
   
   /* Write some simple text to the LCD. */
   if (lcd != NULL )
@@ -355,12 +257,8 @@ static void TestLCD( void )
     sscanf( entry, "%c\n", &ch );
   } while ( ch != 'q' );
 
-  /* Send the command sequence to clear the LCD. */
-  if (lcd != NULL )
-  {
-    fprintf(lcd, "%c%s", ESC, CLEAR_LCD_STRING);
-  }
-  fclose( lcd );
+  /* Clear the LCD and bring the framebuffer back in step with it. */
+  lcd_fb_reset();
 
   return;
 }
@@ -373,91 +271,6 @@ static void TestLCD( void )
  * Button/Switch PIO Functions                      
  *********************************************/
 
-/*******************************************************************
- * static void handle_button_interrupts( void* context, alt_u32 id)*
- *                                                                 *  
- * Handle interrupts from the buttons.                             *
- * This interrupt event is triggered by a button/switch press.     *
- * This handler sets *context to the value read from the button    *
- * edge capture register.  The button edge capture register        *
- * is then cleared and normal program execution resumes.           *
- * The value stored in *context is used to control program flow    *
- * in the rest of this program's routines.                         *
- *                                                                 *
- * Provision is made here for systems that might have either the   *
- * legacy or enhanced interrupt API active, or for the Nios II IDE *
- * which does not support enhanced interrupts. For systems created *
- * using the Nios II softawre build tools, the enhanced API is     *
- * recommended for new designs.                                    *
- ******************************************************************/
-#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
-static void handle_button_interrupts(void* context)
-#else
-static void handle_button_interrupts(void* context, alt_u32 id)
-#endif
-{
-  /* Cast context to edge_capture's type.
-   * It is important to keep this volatile,
-   * to avoid compiler optimization issues.
-   */
-  volatile int* edge_capture_ptr = (volatile int*) context;
-  /* Store the value in the Button's edge capture register in *context. */
-  *edge_capture_ptr = IORD_ALTERA_AVALON_PIO_EDGE_CAP(BUTTON_PIO_BASE);
-  /* Reset the Button's edge capture register. */
-  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(BUTTON_PIO_BASE, 0);
-  
-  /* 
-   * Read the PIO to delay ISR exit. This is done to prevent a spurious
-   * interrupt in systems with high processor -> pio latency and fast
-   * interrupts.
-   */
-  IORD_ALTERA_AVALON_PIO_EDGE_CAP(BUTTON_PIO_BASE);
-}
-
-/* Initialize the button_pio. */
-
-static void init_button_pio()
-{
-  /* Recast the edge_capture pointer to match the alt_irq_register() function
-  * prototype. */
-  void* edge_capture_ptr = (void*) &edge_capture;
-  /* Enable all 4 button interrupts. */
-  IOWR_ALTERA_AVALON_PIO_IRQ_MASK(BUTTON_PIO_BASE, 0xf);
-  /* Reset the edge capture register. */
-  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(BUTTON_PIO_BASE, 0x0);
-  
-  /* 
-   * Register the interrupt handler. 
-   * Provision is made here for systems that might have either the 
-   * legacy or enhanced interrupt API active, or for the Nios II IDE
-   * which does not support enhanced interrupts. For systems created using
-   * the Nios II softawre build tools, the enhanced API is recommended
-   * for new designs.
-   */
-#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
-  alt_ic_isr_register(BUTTON_PIO_IRQ_INTERRUPT_CONTROLLER_ID, BUTTON_PIO_IRQ, 
-    handle_button_interrupts, edge_capture_ptr, 0x0);
-#else
-  alt_irq_register( BUTTON_PIO_IRQ, edge_capture_ptr, 
-    handle_button_interrupts);
-#endif
-}
-
-/* Tear down the button_pio. */
-
-static void disable_button_pio()
-{
-  /* Disable interrupts from the button_pio PIO component. */
-  IOWR_ALTERA_AVALON_PIO_IRQ_MASK(BUTTON_PIO_BASE, 0x0);
-  /* Un-register the IRQ handler by passing a null handler. */
-#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
-  alt_ic_isr_register(BUTTON_PIO_IRQ_INTERRUPT_CONTROLLER_ID, BUTTON_PIO_IRQ, 
-    NULL, NULL, NULL);
-#else
-  alt_irq_register( BUTTON_PIO_IRQ, NULL, NULL );
-#endif
-}
-
 /*******************************************************************************
  * 
  * static void TestButtons( void )
@@ -465,8 +278,8 @@ static void disable_button_pio()
  * Generates a loop that exits when all buttons/switches have been pressed, 
  * at least, once.
  * 
- * NOTE:  Buttons/Switches are not debounced.  A single press of a
- * button may result in multiple messages.
+ * Presses come from the debounced button driver, so a bouncing contact
+ * gives one message per press.
  * 
  ******************************************************************************/
 
@@ -475,100 +288,47 @@ static void TestButtons( void )
 {
   alt_u8 buttons_tested;
   alt_u8 all_tested;
-  /* Variable which holds the last value of edge_capture to avoid 
-   * "double counting" button/switch presses
-   */
-  int last_tested;
-  /* Initialize the Buttons/Switches (SW0-SW3) */
-  init_button_pio();
+  struct button_event ev;
+
   /* Initialize the variables which keep track of which buttons have been tested. */
   buttons_tested = 0x0;
   all_tested = 0xf;
 
-  /* Initialize edge_capture to avoid any "false" triggers from
-   * a previous run.
-   */
-   
-  edge_capture = 0;
-  
-  /* Set last_tested to a value that edge_capture can never equal
-   * to avoid accidental equalities in the while() loop below.
+  /* Discard presses queued before the test started to avoid any "false"
+   * triggers from a previous run.
    */
-    
-  last_tested = 0xffff;
+  buttons_flush();
 
   /* Print a quick message stating what is happening */
   
-  printf("\nA loop will be run until all buttons/switches have been pressed.\n\n");
-  printf("\n\tNOTE:  Once a button press has been detected, for a particular button,\n\tany further presses will be ignored!\n\n");
+  fmt_puts("\nA loop will be run until all buttons/switches have been pressed.\n\n");
+  fmt_puts("\n\tNOTE:  Once a button press has been detected, for a particular button,\n\tany further presses will be ignored!\n\n");
   
   /* Loop until all buttons have been pressed.
    * This happens when buttons_tested == all_tested.
+   * Presses arrive debounced, one event per switch, so switches thrown
+   * together are all counted and contact bounce is not.
    */
   
   while (  buttons_tested != all_tested )
   { 
-    if (last_tested == edge_capture)
+    if (!buttons_get(&ev))
     {
+      timer_idle();
       continue;
     }
-    else
+    if (ev.source != INPUT_SRC_SWITCH || ev.type != BUTTON_PRESS ||
+        ev.bit >= 4 || (buttons_tested & (1 << ev.bit)))
     {
-      last_tested = edge_capture;
-      switch (edge_capture)
-      {
-        case 0x1:
-          if (buttons_tested & 0x1)
-          {
-            continue;
-          }
-          else
-          {
-            printf("\nButton 1 (SW0) Pressed.\n");
-            buttons_tested = buttons_tested | 0x1;
-          } 
-          break;
-        case 0x2:
-          if (buttons_tested & 0x2)
-          {
-            continue;
-          } 
-          else
-          {
-            printf("\nButton 2 (SW1) Pressed.\n");
-            buttons_tested = buttons_tested | 0x2;
-          }
-          break;
-        case 0x4:
-          if (buttons_tested & 0x4)
-          {
-            continue;
-          }
-          else
-          {
-            printf("\nButton 3 (SW2) Pressed.\n");
-            buttons_tested = buttons_tested | 0x4;
-          }
-          break;
-        case 0x8:
-          if (buttons_tested & 0x8)
-          {
-            continue;
-          }
-          else
-          {
-            printf("\nButton 4 (SW3) Pressed.\n");
-            buttons_tested = buttons_tested | 0x8;
-          }
-          break;
-      }
+      continue;
     }
+    fmt_print("\nButton %d (SW%d) Pressed.\n", ev.bit + 1, ev.bit);
+    buttons_tested = buttons_tested | (1 << ev.bit);
   }
-  /* Disable the button pio. */
-  disable_button_pio();
 
-  printf ("\nAll Buttons (SW0-SW3) were pressed, at least, once.\n");
-  usleep(2000000);
+  fmt_puts("\nAll Buttons (SW0-SW3) were pressed, at least, once.\n");
+  fmt_flush();
+  wait(2000000);
   return;
 }
 
@@ -592,14 +352,11 @@ static void TestButtons( void )
  
 static void sevenseg_set_hex(alt_u8 hex)
 {
-  static alt_u8 segments[16] = {
+  char text[SEG_TEXT_DIGITS + 1];
 
-	  0x40, 0x79, 0x24, 0x30, 0x19, 0x12, 0x02, 0x78, 0x00, 0x18, /* 0-9 */
-	  0x08, 0x03, 0x46, 0x21, 0x06, 0x0E };                       /* a-f */
-
-    alt_u32 data = segments[hex & 15] | (segments[(hex >> 4) & 15] << 7);
-
-  IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_BASE, data);
+  /* The two digits go where they always have: the right of seven_seg_pio. */
+  snprintf(text, sizeof(text), "  %02X", hex);
+  seg_text_show(text);
 }
 
 /*******************************************
@@ -615,7 +372,7 @@ static void SevenSegCount( void )
   for (count = 0; count <= 0xff; count++)
   {
     sevenseg_set_hex( count );
-    usleep(50000);
+    wait(50000);
   }
 }
 
@@ -634,8 +391,9 @@ static void SevenSegControl(void)
   static char ch;
   
   /* Turn all segments off at start of test. */
+  seg_text_clear();
   bits = 0xffff;
-  IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_BASE, bits);
+  pio_shadow_write(PIO_OUT_SEG, bits);
 
   printf("\n");
   printf("\n");
@@ -667,9 +425,44 @@ static void SevenSegControl(void)
     else if(ch == 'H')
       keyBit = 1 << 15;
     bits ^= keyBit;
-    IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_BASE, bits);
+    pio_shadow_write(PIO_OUT_SEG, bits);
   }
   while( ch != 'q' );
+
+  /* The segments were driven directly; make the next text rewrite them. */
+  seg_text_invalidate();
+}
+
+/******************************************
+ * static void SevenSegText(void)
+ * 
+ * Shows each line typed on the Seven Segment
+ * Display, scrolling it if it is longer than
+ * eight characters.  An empty line exits.
+ * 
+ ******************************************/
+
+static void SevenSegText(void)
+{
+  char entry[SEG_TEXT_MAX + 2];
+  char* end;
+
+  printf("\nEnter text to display; an empty line exits this test.\n");
+  while (1)
+  {
+    memset(entry, 0, sizeof(entry));
+    GetInputString( entry, sizeof(entry) - 1, stdin);
+    if ((end = strchr(entry, '\n')) != NULL)
+    {
+      *end = '\0';
+    }
+    if (entry[0] == '\0')
+    {
+      break;
+    }
+    seg_text_show(entry);
+  }
+  seg_text_clear();
 }
 
 #endif
@@ -687,7 +480,9 @@ static void SevenSegControl(void)
  * Function which sends blocks/lots of text over the UART
  * 
  * For now, it is hardcoded to send 100 lines with 80 
- * characters per line.
+ * characters per line.  Each line is built whole and
+ * queued on the buffered UART path, and the achieved
+ * throughput is reported at the end.
  * 
  ****************************************************/
 
@@ -695,8 +490,11 @@ static void UARTSendLots( void )
 {
   char entry[4];
   static char ch;
+  char line[81];
   int i,j;
   int mix = 0;
+  struct uart_tx_stats st;
+  alt_u64 us;
 
   printf("\n\nPress character (and <enter>), or <space> (and <enter>) for mix: ");
   GetInputString( entry, sizeof(entry), stdin);
@@ -716,6 +514,8 @@ static void UARTSendLots( void )
   
   /* The loop that sends the block of text. */
   
+  fflush(stdout);
+  uart_tx_reset_stats();
   for(i = 0; i < 100; i++)
   {
     for(j = 0; j < 80; j++)
@@ -726,11 +526,25 @@ static void UARTSendLots( void )
         if(ch >= 127)
           ch = 33;
       }
-      printf("%c", ch);
+      line[j] = ch;
     }
-    printf("\n");
+    line[80] = '\n';
+    uart_tx_write(line, sizeof(line));
   }
-  printf("\n");
+  uart_tx_write("\n", 1);
+  uart_tx_flush();
+
+  /* Report on the same path so the summary follows the text. */
+  uart_tx_get_stats(&st);
+  us = (st.last_cycles - st.first_cycles) / timer_cycles_per_us();
+  j = snprintf(line, sizeof(line), "%lu bytes to the driver in %lu us (%lu bytes/s)\n",
+    (unsigned long) st.sent, (unsigned long) us,
+    (unsigned long)(us ? (alt_u64) st.sent * 1000000 / us : 0));
+  uart_tx_write(line, j);
+  j = snprintf(line, sizeof(line), "%lu stalls, %lu driver calls would block\n\n",
+    (unsigned long) st.stalls, (unsigned long) st.would_block);
+  uart_tx_write(line, j);
+  uart_tx_flush();
 }
 
 /*************************************************
@@ -749,218 +563,1403 @@ static void UARTReceiveChars(void)
   static char ch;
   static char chP;
 
-  printf("\n\nEnter a character (followed by <enter>); \n\tPress 'q' (followed by <enter>) to exit this test.\n\n");
+  fmt_puts("\n\nEnter a character (followed by <enter>); \n\tPress 'q' (followed by <enter>) to exit this test.\n\n");
   
   do
   {
     GetInputString( entry, sizeof(entry), stdin );
     sscanf( entry, "%c\n", &ch );
     chP = ch >= 32 ? ch : '.';
-    printf("\'%c\' 0x%02x %d\n",chP,ch,ch);
+    fmt_print("\'%c\' 0x%02x %d\n", chP, ch, ch);
   }
   while( ch != 'q' );
+  fmt_flush();
+}
+
+/*************************************************
+ *
+ * JTAG UART benchmarks
+ *
+ * Each test needs tools/uart_peer.py on the host
+ * end of the link and prints one BENCH line.  The
+ * block size applies to both bandwidth tests.
+ *
+ ************************************************/
+
+static int bench_block = 256;
+
+static void UARTBenchBanner( void )
+{
+  fmt_print("\n(block size %d bytes, %d bytes per bandwidth test)", bench_block,
+    UART_BENCH_TOTAL);
+}
+
+#define UART_BENCH_MENU(X) \
+  X(ALWAYS, a, "TX Bandwidth", UARTBenchTX) \
+  X(ALWAYS, b, "RX Bandwidth", UARTBenchRX) \
+  X(ALWAYS, c, "Echo Latency", UARTBenchEcho) \
+  X(ALWAYS, d, "Block Size",   UARTBenchBlockSize) \
+  X(ALWAYS, e, "Run All",      UARTBenchAll)
+
+MENU_DEFINE_BANNER(uart_bench_menu, "JTAG UART Benchmark", UART_BENCH_MENU,
+                   UARTBenchBanner);
+
+static void DoUARTBenchMenu( void )
+{
+  menu_run(&uart_bench_menu);
+}
+
+static void UARTBenchTX( void )
+{
+  uart_bench_tx(bench_block, UART_BENCH_TOTAL);
+}
+
+static void UARTBenchRX( void )
+{
+  uart_bench_rx(bench_block, UART_BENCH_TOTAL);
+}
+
+static void UARTBenchEcho( void )
+{
+  uart_bench_echo(UART_BENCH_MAX_SAMPLES);
+}
+
+static void UARTBenchBlockSize( void )
+{
+  char entry[8];
+  int block = 0;
+
+  printf("\nBlock size in bytes (1-%d): ", UART_BENCH_MAX_BLOCK);
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%d", &block );
+  if (block >= 1 && block <= UART_BENCH_MAX_BLOCK)
+  {
+    bench_block = block;
+  }
+  else
+  {
+    printf("Out of range; block size stays %d.\n", bench_block);
+  }
+}
+
+static void UARTBenchAll( void )
+{
+  UARTBenchTX();
+  UARTBenchRX();
+  UARTBenchEcho();
 }
 
 #endif
 
 
 
-alt_u32 seven_seg_title_1 = 0x00000000;
-alt_u32 seven_seg_title_2 = 0x00000000;
+/* KEY and switch levels for the Test_Func behaviours, one snapshot for all. */
+static struct input_snapshot test_in;
+
+/*
+ * The Test_Func behaviours as scheduler tasks: the keys pick the LED
+ * animation (played by the led_anim tick engine) or the red LED count
+ * (stepped by red_count), SW7 drives the seven-segment text and SW10 the
+ * LCD.  Each step is short and returns, so a switch is never waiting
+ * behind an LED sweep.  They read the inputs from the per-tick snapshot,
+ * not the event queue; the keys task discards the queue each time it runs.
+ */
+
+#define TEST_COUNT_HZ    5      /* the 200 ms steps the count always had */
+#define TEST_COUNT_LIMIT 257    /* 0 to 256 */
+
+static int test_scan;                       /* KEY[0] scanner selected */
+static int test_count;                      /* KEY[1] count selected */
+static int test_exit;                       /* KEY[3] seen */
+
+static void KeysTask( void* context )
+{
+  int scan = 0;
+  int count = 0;
+
+  (void) context;
+  // latch KEY and the switches once; the seven segment and LCD tasks use the same snapshot
+  input_events_snapshot(&test_in);
+  // the snapshot replaces the event queue as this test's input: its edges and
+  // levels cover both sources, so the queued events are dropped rather than
+  // left to fill the ring (edge latency is noted from the snapshot below)
+  input_events_flush();
+  if(test_in.current[INPUT_SRC_KEY] == 0xE) // swimming pattern with a fading tail when we press key[0] which is "1110"
+    scan = 1;
+  else if (test_in.current[INPUT_SRC_KEY] == 0xD) //red leds count to 256 if KEY[1] is pressed.
+    count = 1;
+
+  // the timer tick runs the scanner and steps the count; only start or stop them here
+  if(scan != test_scan || count != test_count){
+    test_scan = scan;
+    test_count = count;
+    red_count_stop();
+    led_bam_stop();
+    led_anim_show(0x00000000); // turn off all the leds
+    if(test_scan)
+      led_bam_scan(led_bam_flicker_free_bits());
+    else if(test_count)
+      red_count_start(RED_COUNT_UP, TEST_COUNT_HZ, TEST_COUNT_LIMIT);
+  }
+  if(test_in.current[INPUT_SRC_KEY] == 0x7) //USE KEY[3] FOR EXIT
+    test_exit = 1;
+  input_events_note_snapshot_reaction(&test_in);
+}
+
+static void SevenSegTask( void* context )
+{
+  (void) context;
+  if((test_in.current[INPUT_SRC_SWITCH] & 0x00080) == 0x00080) // if SW7 pressed display the ECEN-723 on seven segment display
+    seg_text_show("ECEN-723");
+  else
+    seg_text_clear(); // clear both sets of seven segment displays
+}
+
+static void LCDTask( void* context )
+{
+  (void) context;
+  modified_LCD();
+}
+
+static struct sched_task test_tasks[] = {
+  { .name = "keys",  .step = KeysTask,     .period = 10 },
+  { .name = "seg7",  .step = SevenSegTask, .period = 50 },
+  { .name = "lcd",   .step = LCDTask,      .period = 100 },
+};
+
+#define TEST_NUM_TASKS ((int)(sizeof(test_tasks) / sizeof(test_tasks[0])))
+
+static void StartTestTasks( void )
+{
+  int i;
+
+  input_events_flush();
+  input_events_snapshot(&test_in);
+  test_scan = 0;
+  test_count = 0;
+  test_exit = 0;
+  for (i = 0; i < TEST_NUM_TASKS; i++)
+  {
+    sched_add(&test_tasks[i]);
+  }
+}
+
+static void StopTestTasks( void )
+{
+  int i;
+
+  for (i = 0; i < TEST_NUM_TASKS; i++)
+  {
+    sched_remove(&test_tasks[i]);
+  }
+  red_count_stop();
+  led_bam_stop();
+  led_anim_show(0x00000000);
+}
 
 #ifdef KEY_NAME
 
+static int TestFuncDone( void )
+{
+  return test_exit;
+}
+
+/* What the input snapshot cost over a Test_Func run, and how fast it was acted on. */
+static void TestInputReport( void )
+{
+  struct input_snapshot_stats st;
+  struct input_latency lat;
+  alt_u32 per_tick;
+
+  input_events_snapshot_stats(&st);
+  input_events_latency(&lat);
+  per_tick = st.frames ? (alt_u32)((alt_u64) st.reads * 100 / st.frames) : 0;
+  fmt_print("BENCH input_snapshot ticks=%lu takes=%lu reads=%lu reads_per_tick=%lu.%02lu "
+    "reactions=%lu latency_min_us=%lu latency_avg_us=%lu latency_max_us=%lu\n",
+    (unsigned long) st.frames, (unsigned long) st.takes, (unsigned long) st.reads,
+    (unsigned long)(per_tick / 100), (unsigned long)(per_tick % 100),
+    (unsigned long) lat.count, (unsigned long) lat.min_us,
+    (unsigned long)(lat.count ? lat.total_us / lat.count : 0),
+    (unsigned long) lat.max_us);
+  fmt_flush();
+}
+
 static void Test_Func( void )
 {
 	/* Instruction for User*/
-	printf("\n Press KEY[0]. All LEDs alternate swimming motion from right to left and back like Knight Rider car\n");
+	printf("\n Press KEY[0]. All LEDs alternate swimming motion from right to left and back like Knight Rider car, with a fading tail\n");
 	printf("\n Press KEY[1]. The Red Leds count from 0 to 256\n");
 	printf("\n Press SW7. Display /*ECEN-723*/ on the eight 7-segment displays when SW7 is in the ON position\n");
 	printf("\n Press SW10. The message /*Pittsburgh Steelers*/ displays on the LCD Display using two lines when SW10 is in ON position \n");
 	printf("\n Press KEY[3] to exit this test.\n");
 
-
-	/* decleration of variables */
-	alt_u32 bit_mask = 0x20000000;
-	int delay = 10000;
-	int cnt = 0;
-	alt_u32 bit_mask_1 = 0x00000000;// 32-bit bit mask
-	alt_u32 led = 0x00000000;
-
-
-
-
-
-
-
-// Press Either KEY [0] or KEY [1] to show some output or KEY[3 for exit]
-  while(IORD_ALTERA_AVALON_PIO_DATA(KEY_BASE) != 0x7) //USE KEY[3] FOR EXIT
-  {	// swimming pattern when we press key[0] which is "1110"
-	  if(IORD_ALTERA_AVALON_PIO_DATA(KEY_BASE) == 0xE){ // if KEY[0] is pressed than it enters into this if statement
-			// Going from left to right 
-		  	bit_mask = 0x20000000;
-		    for(int i = 0; i<26; i++) // total 26 Leds = 8 (Green Leds) + 18 (Red Leds)
-		    {
-		    	if(IORD_ALTERA_AVALON_PIO_DATA(KEY_BASE) != 0xE)
-		    	{
-					IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, 0x00000000);
-					led = 0x00000000;
-					break;
-				}
-		    	led = led|(bit_mask>>(i));
-		    	IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-		    	wait(delay);
-		    	led = led|(bit_mask>>(i+1));
-		    	IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-		    	wait(delay);
-		    	led = led|(bit_mask>>(i+2));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				wait(delay);
-				led = led|(bit_mask>>(i+3));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				wait(delay);
-				led = led|(bit_mask>>(i+4));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				led = led|(bit_mask>>(i+5));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				led = led&(~bit_mask>>(i));
-				IOWR_ALTERA_AVALON_PIO_DATA(LED_PIO_BASE, led);
-		    }
-
-			// going from right to left
-		    bit_mask = 0x00000001;
-		    for(int i = 0; i<26; i++)
-			{
-				if(IORD_ALTERA_AVALON_PIO_DATA(KEY_BASE) != 0xE)
-				{
-					//turn off all leds
-					IOWR_ALTERA_AVALON_PIO_DATA(LED_PIO_BASE, 0x00000000);
-					led = 0x00000000;
-					break;
-				}
-				led = led|(bit_mask<<(i));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				wait(delay);
-				led = led|(bit_mask<<(i+1));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				wait(delay);
-				led = led|(bit_mask<<(i+2));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				wait(delay);
-				led = led|(bit_mask<<(i+3));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				wait(delay);
-				led = led|(bit_mask<<(i+4));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				led = led|(bit_mask>>(i+5));
-				IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, led);
-				led = led&(~bit_mask<<(i));
-				IOWR_ALTERA_AVALON_PIO_DATA(LED_PIO_BASE, led);
-			}
-
-	  }
-	  else if (IORD_ALTERA_AVALON_PIO_DATA(KEY_BASE) == 0xD)  //red leds count to 256 if KEY[1] is pressed.
-	  {
-		  	  	  if(cnt >= 256)
-		  	  	  {;}   //leds are off.
-		  else
-		  {
-		    for(cnt = 1; cnt<=256; cnt++) // leds are starting the count from 0
-		    {
-		    	if(IORD_ALTERA_AVALON_PIO_DATA(KEY_BASE) != 0xD) //if key[1] is not pressed
-				{
-					IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, 0x00000000);
-					cnt = 0;
-					break;
-				}
-		    	bit_mask_1 = (bit_mask_1 | cnt)<<8;
-		    	count_red_led(bit_mask_1);
-		    	bit_mask_1 = 0x00000000;
-		    	wait(delay*20);
-		    }
-		  }
-	  }
-	  else {
-		  IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, 0x00000000);// turn off all the leds
-		        cnt = 0;
-	  	  }
-	  if((IORD_ALTERA_AVALON_PIO_DATA(BUTTON_PIO_BASE)& 0x00080) == 0x00080){ // if SW7 pressed display the ECEN-723 on seven segment display
-		  seven_seg_title_1 = (((((((seven_seg_title_1|0x06)<<7)|0x46)<<7)|0x06)<<7)|0x48>>7); // ECEN
-	  		IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_BASE, seven_seg_title_1);
-	  		seven_seg_title_2 = ((((((seven_seg_title_1|0x3F)<<7)|0x78)<<7)|0x24)<<7)|0x30; // - 723
-	  		IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_1_BASE, seven_seg_title_2);
-	  	}
-	  else{
-		  IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_BASE, 0xfffffff); // clear the first set of seven segment display
-		  IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_1_BASE, 0xfffffff); // clear the second set of seven segment display
-	  	  }
-
-	  modified_LCD();
-  }
+	// the keys, seven segment and LCD tasks run side by side until KEY[3]
+	input_events_reset_snapshot_stats();
+	input_events_reset_latency();
+	StartTestTasks();
+	sched_run(TestFuncDone);
+	StopTestTasks();
+	TestInputReport();
 }
 #endif
 
 
 
+/* Wait for 'a' microseconds on the timer service. */
 static void wait (int a)
 {
-	for (int b=0; b<a; b++);
+	timer_delay_us(a);
 }
 
-
-static void count_red_led(alt_u32 cnt)
-{
-#ifdef RED_LED_BASE
-    IOWR_ALTERA_AVALON_PIO_DATA(
-    		RED_LED_BASE,
-        cnt
-        );
-#endif
-}
+/* Draw the SW10 message; lcd_fb only sends what differs from the display. */
 static void modified_LCD( void )
 {
-  FILE *lcddisplay;
-  lcddisplay = fopen("/dev/lcd_display", "w");
-  if((IORD_ALTERA_AVALON_PIO_DATA(BUTTON_PIO_BASE)& 0x00400) == 0x00400){ // if SW10 pressed
-// use the same logic that has been use for lcd-display test in Actual Board Diagnostics.
-	if (lcddisplay != NULL )
-		{
-		  fprintf(lcddisplay, "\nPittsburgh\n");
-		  fprintf(lcddisplay, "Steelers\n");
-		}
-  }
-  else{ 
- 	  		// send the command sequence to clear the LCD.
-			if (lcddisplay != NULL )
- 	  		  {
- 	  		    fprintf(lcddisplay, "%c%s", ESC, CLEAR_LCD_STRING);
- 	  		  }
- 		  	  fclose( lcddisplay );
- 	  	  }
+  if((test_in.current[INPUT_SRC_SWITCH] & 0x00400) == 0x00400){ // if SW10 pressed
+	  lcd_fb_puts(0, "Pittsburgh");
+	  lcd_fb_puts(1, "Steelers");
+  }
+  else{
+	  lcd_fb_clear();
+  }
+  lcd_fb_update();
   return;
 }
 
-int main()
+/*******************************************************************************
+ * 
+ * static void TimerAccuracy( void )
+ * 
+ * Requests a range of delays from the timer service and reports how long
+ * each one really took in timer cycles, with the HAL tick count as a
+ * cross-check.
+ * 
+ ******************************************************************************/
+
+static void TimerAccuracy( void )
 {
-	 int ch;
-	//turn off all seven seg displays
-	IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_BASE, 0xfffffff);
-	IOWR_ALTERA_AVALON_PIO_DATA(SEVEN_SEG_PIO_1_BASE, 0xfffffff);
-	IOWR_ALTERA_AVALON_PIO_DATA(RED_LED_BASE, 0x0000000);
-  /* Declare variable for received character. */
- 
-  
-  while (1)
+  static const alt_u32 delays[] = { 10, 100, 1000, 10000, 100000 };
+  alt_u32 i;
+  alt_u64 start;
+  alt_u64 cycles;
+  alt_u32 ticks;
+  long error;
+
+  printf("\n  requested(us)  measured(cycles)  error(cycles)  ticks\n");
+  for (i = 0; i < sizeof(delays) / sizeof(delays[0]); i++)
   {
-    ch = TopMenu();
-    if (ch == 'q')
-    {
-      printf( "\nExiting from Board Diagnostics.\n");
-      /* Send EOT to nios2-terminal on the other side of the link. */
-      printf( "%c", EOT );
-      break;
-    }
+    ticks = alt_nticks();
+    start = timer_now_cycles();
+    timer_delay_us(delays[i]);
+    cycles = timer_now_cycles() - start;
+    ticks = alt_nticks() - ticks;
+    error = (long)(cycles - (alt_u64) delays[i] * timer_cycles_per_us());
+    printf("  %13lu  %16lu  %13ld  %5lu\n", (unsigned long) delays[i],
+      (unsigned long) cycles, error, (unsigned long) ticks);
+  }
+}
+
+/*******************************************************************************
+ * 
+ * static void InputLatency( void )
+ * 
+ * Reports the press-to-reaction time of the input events acted on since the
+ * last report: from the edge being captured to the test that consumed it
+ * reacting.  The counters are then cleared.
+ * 
+ ******************************************************************************/
+
+static void InputLatency( void )
+{
+  struct input_latency lat;
+
+  input_events_latency(&lat);
+  printf("\nInput events handled: %lu (dropped: %lu)\n",
+    (unsigned long) lat.count, (unsigned long) input_events_dropped());
+  if (lat.count)
+  {
+    printf("Press-to-reaction (us): min %lu  avg %lu  max %lu\n",
+      (unsigned long) lat.min_us, (unsigned long)(lat.total_us / lat.count),
+      (unsigned long) lat.max_us);
   }
+  input_events_reset_latency();
+}
+
+/*******************************************************************************
+ * 
+ * static void LEDAnimations( void )
+ * 
+ * Plays one pass (at most 64 frames) of each built-in LED animation and
+ * reports the frames shown, the PIO writes they cost and the ticks taken
+ * against the sum of the frame dwell times.
+ * 
+ ******************************************************************************/
+
+static void LEDAnimations( void )
+{
+  static const struct led_anim* const anims[] =
+  {
+    &led_anim_sweep, &led_anim_bounce, &led_anim_count, &led_anim_center
+  };
+  struct led_anim_stats st;
+  struct pio_shadow_stats green, red;
+  alt_u32 dwell;
+  unsigned int i, f, frames;
+
+  printf("\n%-12s %8s %8s %10s %10s\n",
+    "animation", "frames", "writes", "ticks", "expected");
+  for (i = 0; i < sizeof(anims) / sizeof(anims[0]); i++)
+  {
+    frames = anims[i]->count < 64 ? anims[i]->count : 64;
+    dwell = 0;
+    for (f = 0; f < frames; f++)
+    {
+      dwell += anims[i]->frames[f].dwell;
+    }
+
+    led_anim_reset_stats();
+    pio_shadow_reset_stats();
+    led_anim_play(anims[i]);
+    /* Stop as soon as the frame after the last one measured is shown. */
+    do
+    {
+      wait(timer_tick_us());
+      led_anim_get_stats(&st);
+    }
+    while (led_anim_current() != NULL && st.frames <= frames);
+    pio_shadow_get_stats(PIO_OUT_LED, &green);
+    pio_shadow_get_stats(PIO_OUT_RED, &red);
+    led_anim_show(0x00000000);
+
+    printf("%-12s %8lu %8lu %10lu %10lu\n", anims[i]->name,
+      (unsigned long) frames, (unsigned long)(green.issued + red.issued),
+      (unsigned long) st.ticks, (unsigned long) dwell);
+  }
+}
+
+/*******************************************************************************
+ * 
+ * static void PIOCoalescing( void )
+ * 
+ * Replays the output writes of 1000 Test_Func loop passes, one pass every
+ * 100 us, with the shadow registers in write-through and in coalescing
+ * mode, and reports how many writes reached the bus in each.  The switches
+ * "change" every 250 passes; in between every pass rewrites the same values.
+ * 
+ ******************************************************************************/
+
+static void PIOCoalescing( void )
+{
+  static const char* const names[PIO_OUT_NUM] =
+  {
+    "led_pio", "red_led", "seven_seg_pio", "seven_seg_pio_1"
+  };
+  struct pio_shadow_stats st;
+  alt_u64 start;
+  alt_u32 us;
+  int mode, pass, id;
+
+  for (mode = 1; mode >= 0; mode--)
+  {
+    pio_shadow_set_write_through(mode);
+    pio_shadow_reset_stats();
+    start = timer_now_cycles();
+    for (pass = 0; pass < 1000; pass++)
+    {
+      if ((pass / 250) & 1)
+      {
+        pio_shadow_write(PIO_OUT_SEG, seg_text_encode4("ECEN"));
+        pio_shadow_write(PIO_OUT_SEG_1, seg_text_encode4("-723"));
+      }
+      else
+      {
+        pio_shadow_write(PIO_OUT_SEG, 0xfffffff);
+        pio_shadow_write(PIO_OUT_SEG_1, 0xfffffff);
+      }
+      pio_shadow_write(PIO_OUT_RED, 0x0000000);
+      pio_shadow_write(PIO_OUT_LED, 0x00);
+      wait(100);
+    }
+    pio_shadow_flush();
+    us = (alt_u32)((timer_now_cycles() - start) / timer_cycles_per_us());
+
+    printf("\n%s: %lu us\n", mode ? "write-through" : "coalescing",
+      (unsigned long) us);
+    printf("%-16s %10s %10s %10s\n", "pio", "requested", "issued", "suppressed");
+    for (id = 0; id < PIO_OUT_NUM; id++)
+    {
+      pio_shadow_get_stats(id, &st);
+      printf("%-16s %10lu %10lu %10lu\n", names[id],
+        (unsigned long) st.requested, (unsigned long) st.issued,
+        (unsigned long)(st.requested - st.issued));
+    }
+  }
+  seg_text_invalidate();
+  seg_text_clear();
+}
+
+/*******************************************************************************
+ * 
+ * static void LCDUpdateCost( void )
+ * 
+ * Runs 100 Test_Func passes with SW10 on, then off, then on, through the
+ * LCD framebuffer and reports the bytes sent per pass, next to what the old
+ * full-text fprintf path would have sent.
+ * 
+ ******************************************************************************/
+
+static void LCDUpdateCost( void )
+{
+  static const char* const phase[] = { "SW10 on", "SW10 off", "SW10 on" };
+  struct lcd_fb_stats st;
+  alt_u32 saved = test_in.current[INPUT_SRC_SWITCH];
+  alt_u32 full;
+  int p, pass;
+
+  /* "\nPittsburgh\n" "Steelers\n" or ESC "[2J" per pass. */
+  printf("\nLCD renderer RAM: %lu bytes\n", (unsigned long) lcd_fb_footprint());
+  printf("%-10s %8s %8s %10s %10s\n",
+    "phase", "passes", "sends", "bytes", "old bytes");
+  for (p = 0; p < 3; p++)
+  {
+    test_in.current[INPUT_SRC_SWITCH] = (p == 1) ? 0 : 0x00400;
+    full = (p == 1) ? 1 + strlen(CLEAR_LCD_STRING) : 21;
+    lcd_fb_reset_stats();
+    for (pass = 0; pass < 100; pass++)
+    {
+      modified_LCD();
+    }
+    lcd_fb_get_stats(&st);
+    printf("%-10s %8d %8lu %10lu %10lu\n", phase[p], pass,
+      (unsigned long) st.sends, (unsigned long) st.bytes,
+      (unsigned long)(full * pass));
+  }
+  test_in.current[INPUT_SRC_SWITCH] = saved;
+  lcd_fb_clear();
+  lcd_fb_update();
+}
+
+/*******************************************************************************
+ * 
+ * static void SchedulerStats( void )
+ * 
+ * Runs the Test_Func tasks for two seconds at the current key and switch
+ * settings, then again next to a task that burns 25 ms of CPU every 100 ms,
+ * and reports per-task CPU time and deadline misses for each run.
+ * 
+ ******************************************************************************/
+
+static alt_u32 sched_stop_at;
+
+static int SchedulerRunDone( void )
+{
+  return (alt_32)(sched_ticks() - sched_stop_at) >= 0;
+}
+
+static void HogTask( void* context )
+{
+  alt_u64 until = timer_now_cycles() + 25000 * timer_cycles_per_us();
+
+  (void) context;
+  while (timer_now_cycles() < until)
+  {
+  }
+}
+
+static void SchedulerStats( void )
+{
+  static struct sched_task hog = { .name = "hog", .step = HogTask, .period = 100 };
+  struct sched_task* t;
+  alt_u32 per_us = timer_cycles_per_us();
+  int run, i, n;
+
+  for (run = 0; run < 2; run++)
+  {
+    StartTestTasks();
+    if (run)
+    {
+      sched_add(&hog);
+    }
+    sched_stop_at = sched_ticks() + 2000;
+    sched_run(SchedulerRunDone);
+
+    printf("\n%s, 2000 ticks of %lu us\n", run ? "with a 25 ms hog" : "Test_Func tasks",
+      (unsigned long) timer_tick_us());
+    printf("%-6s %7s %9s %6s %7s %10s %8s %9s\n", "task", "period", "deadline",
+      "runs", "misses", "cpu_us", "max_us", "max_late");
+    n = TEST_NUM_TASKS + run;
+    for (i = 0; i < n; i++)
+    {
+      t = (i < TEST_NUM_TASKS) ? &test_tasks[i] : &hog;
+      printf("%-6s %7lu %9lu %6lu %7lu %10lu %8lu %9lu\n", t->name,
+        (unsigned long) t->period, (unsigned long) t->deadline,
+        (unsigned long) t->stats.runs, (unsigned long) t->stats.misses,
+        (unsigned long)(t->stats.cycles / per_us),
+        (unsigned long)(t->stats.max_cycles / per_us),
+        (unsigned long) t->stats.max_late);
+    }
+    if (run)
+    {
+      sched_remove(&hog);
+    }
+    StopTestTasks();
+  }
+  seg_text_clear();
+  lcd_fb_clear();
+  lcd_fb_update();
+}
+
+/*******************************************************************************
+ * 
+ * static void DebounceStress( void )
+ * 
+ * Counts debounced button events for a set time at a chosen debounce time
+ * and prints one BENCH line with the raw edge and event rates.  On the host
+ * build, tools/bounce_replay.py feeds recorded bounce waveforms through
+ * the input script and turns these lines into false-trigger rates.
+ * 
+ ******************************************************************************/
+
+static void DebounceStress( void )
+{
+  char entry[12];
+  unsigned int ms = BUTTON_DEBOUNCE_MS;
+  unsigned int secs = 10;
+  struct button_event ev;
+  struct button_stats st;
+  alt_u32 bounces = 0;
+  alt_u64 start, us;
+
+  printf("\nDebounce time in ms [%d]: ", BUTTON_DEBOUNCE_MS);
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &ms );
+  printf("Run time in seconds [10]: ");
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &secs );
+
+  buttons_set_debounce_ms(ms);
+  buttons_flush();
+  buttons_reset_stats();
+  start = timer_now_us();
+  while ((us = timer_now_us() - start) < (alt_u64) secs * 1000000)
+  {
+    while (buttons_get(&ev))
+    {
+      bounces += ev.bounces;
+    }
+    timer_idle();
+  }
+  buttons_get_stats(&st);
+  buttons_set_debounce_ms(BUTTON_DEBOUNCE_MS);
+
+  printf("\nBENCH debounce ms=%u us=%lu raw_edges=%lu presses=%lu releases=%lu "
+    "longs=%lu glitches=%lu bounces=%lu dropped=%lu raw_per_s=%lu events_per_s=%lu\n",
+    ms, (unsigned long) us, (unsigned long) st.raw_edges,
+    (unsigned long) st.presses, (unsigned long) st.releases,
+    (unsigned long) st.longs, (unsigned long) st.glitches,
+    (unsigned long) bounces, (unsigned long) st.dropped,
+    (unsigned long)((alt_u64) st.raw_edges * 1000000 / us),
+    (unsigned long)((alt_u64)(st.presses + st.releases + st.longs) * 1000000 / us));
+}
+
+/*******************************************************************************
+ * 
+ * static void DoBusProfMenu( void )
+ * 
+ * Starts, stops and shows the Avalon access profiler, or profiles the
+ * Test_Func tasks for two seconds at the current key and switch settings.
+ * Needs a build with BUS_PROF defined; see bus_prof.h.
+ * 
+ ******************************************************************************/
+
+#define BUS_PROF_MENU(X) \
+  X(ALWAYS, a, "Start (clears the counts)", bus_prof_start) \
+  X(ALWAYS, b, "Stop",                      bus_prof_stop) \
+  X(ALWAYS, c, "Show",                      bus_prof_dump) \
+  X(ALWAYS, d, "Profile Test_Func Tasks",   BusProfTasks)
+
+MENU_DEFINE(bus_prof_menu, "Bus Profiler", BUS_PROF_MENU);
+
+static void DoBusProfMenu( void )
+{
+  if (!bus_prof_available())
+  {
+    bus_prof_dump();
+    return;
+  }
+  menu_run(&bus_prof_menu);
+}
+
+static void BusProfTasks( void )
+{
+  StartTestTasks();
+  bus_prof_start();
+  sched_stop_at = sched_ticks() + 2000;
+  sched_run(SchedulerRunDone);
+  bus_prof_stop();
+  StopTestTasks();
+  seg_text_clear();
+  lcd_fb_clear();
+  lcd_fb_update();
+  bus_prof_dump();
+}
+
+/*******************************************************************************
+ * 
+ * static void TimingStress( void )
+ * 
+ * Runs the timing stress patterns for the time asked for, with a progress
+ * line every second, and prints one BENCH line per path; see stress.h.
+ * 
+ ******************************************************************************/
+
+static void TimingStress( void )
+{
+  char entry[12];
+  unsigned int secs = 10;
+
+  printf("\nRun time in seconds [10]: ");
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &secs );
+
+  stress_run(secs * 1000, 1000);
+  stress_report();
+}
+
+/*******************************************************************************
+ * 
+ * static void FormatterCost( void )
+ * 
+ * Formats three typical output lines 1000 times each with snprintf() and
+ * with fmt_format(), checks that both give the same text, and prints the
+ * CPU cycles per line for each.
+ * 
+ ******************************************************************************/
+
+#define FMT_COST_PASSES 1000
+#define FMT_COST_MENU   "     %c:  %s\n"
+#define FMT_COST_BENCH  "BENCH memtest algo=%s bytes=%lu us=%lu mb_per_s=%lu.%02lu errors=%lu status=%s\n"
+#define FMT_COST_TABLE  "%-16s 0x%08lx %8lu %8lu %5lu\n"
+
+static int FormatterLine( int line, int use_fmt, char* buf, int size, alt_u32 n )
+{
+  switch (line)
+  {
+    case 0:
+      return use_fmt ?
+        fmt_format(buf, size, FMT_COST_MENU, 'a' + (int)(n & 7), "Timer Accuracy") :
+        snprintf(buf, size, FMT_COST_MENU, 'a' + (int)(n & 7), "Timer Accuracy");
+    case 1:
+      return use_fmt ?
+        fmt_format(buf, size, FMT_COST_BENCH, "march_c-", (unsigned long) n * 4801,
+          (unsigned long) n * 37, (unsigned long) n % 100, (unsigned long) n % 7,
+          (unsigned long) 0, "pass") :
+        snprintf(buf, size, FMT_COST_BENCH, "march_c-", (unsigned long) n * 4801,
+          (unsigned long) n * 37, (unsigned long) n % 100, (unsigned long) n % 7,
+          (unsigned long) 0, "pass");
+    default:
+      return use_fmt ?
+        fmt_format(buf, size, FMT_COST_TABLE, "seven_seg_pio_1", (unsigned long) 0x81040,
+          (unsigned long) n, (unsigned long) n * 3, (unsigned long) n % 64) :
+        snprintf(buf, size, FMT_COST_TABLE, "seven_seg_pio_1", (unsigned long) 0x81040,
+          (unsigned long) n, (unsigned long) n * 3, (unsigned long) n % 64);
+  }
+}
+
+static void FormatterCost( void )
+{
+  static const char* const names[] = { "menu_item", "bench_line", "table_row" };
+  char a[128], b[128];
+  alt_u64 start;
+  alt_u32 cycles[2];
+  alt_u32 n;
+  int line, use_fmt, same;
+
+  printf("\n");
+  for (line = 0; line < 3; line++)
+  {
+    for (use_fmt = 0; use_fmt < 2; use_fmt++)
+    {
+      start = timer_now_cycles();
+      for (n = 0; n < FMT_COST_PASSES; n++)
+      {
+        FormatterLine(line, use_fmt, a, sizeof(a), n);
+      }
+      cycles[use_fmt] = (alt_u32)((timer_now_cycles() - start) / FMT_COST_PASSES);
+    }
+    same = 1;
+    for (n = 0; n < FMT_COST_PASSES && same; n += 97)
+    {
+      FormatterLine(line, 0, a, sizeof(a), n);
+      FormatterLine(line, 1, b, sizeof(b), n);
+      same = strcmp(a, b) == 0;
+    }
+    printf("BENCH fmt line=%s printf_cycles=%lu fmt_cycles=%lu match=%s\n",
+      names[line], (unsigned long) cycles[0], (unsigned long) cycles[1],
+      same ? "yes" : "no");
+  }
+}
+
+/*******************************************************************************
+ * 
+ * static void RedLEDCounter( void )
+ * 
+ * Counts on all 18 red LEDs in the mode and at the rate asked for, for the
+ * time asked for, and prints the requested against the achieved rate; see
+ * red_count.h.
+ * 
+ ******************************************************************************/
+
+static void RedLEDCounter( void )
+{
+  char entry[12];
+  char name[8];
+  unsigned int hz = RED_COUNT_MAX_HZ;
+  unsigned int secs = 5;
+  int mode = RED_COUNT_UP;
+
+  printf("\nMode, up, down or gray [up]: ");
+  GetInputString( entry, sizeof(entry), stdin );
+  if (sscanf( entry, "%7s", name ) == 1 && (mode = red_count_mode(name)) < 0)
+  {
+    printf("\n -ERROR: %s is not a counting mode\n", name);
+    return;
+  }
+  printf("\nSteps per second [%u]: ", hz);
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &hz );
+  printf("\nRun time in seconds [%u]: ", secs);
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &secs );
+
+  led_bam_stop();
+  led_anim_show(0x00000000);
+  red_count_start(mode, hz, 0);
+  wait(secs * 1000000);
+  red_count_stop();
+  red_count_report();
+  led_anim_show(0x00000000);
+}
+
+/*******************************************************************************
+ * 
+ * static void CPULoad( void )
+ * 
+ * Runs a synthetic load for the time asked for: in every 10 ms, the CPU
+ * spins for the percentage asked for and idles for the rest.  Then prints
+ * where the time went over the run, and the rolling figures; see
+ * cpu_load.h.  At 0% this is the headroom left with only the tick hooks
+ * and the idle polling running.
+ * 
+ ******************************************************************************/
+
+#define CPU_LOAD_SLOT_US 10000
+
+static void CPULoad( void )
+{
+  char entry[12];
+  unsigned int pct = 0;
+  unsigned int secs = 5;
+  struct cpu_load_sample a, b, run;
+  alt_u64 slot, busy, end, t;
+
+  printf("\nBusy load in percent [0]: ");
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &pct );
+  printf("\nRun time in seconds [%u]: ", secs);
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &secs );
+  if (pct > 100)
+  {
+    pct = 100;
+  }
+
+  slot = (alt_u64) CPU_LOAD_SLOT_US * timer_cycles_per_us();
+  busy = slot * pct / 100;
+  cpu_load_total(&a);
+  end = timer_now_cycles() + (alt_u64) secs * 1000000 * timer_cycles_per_us();
+  while ((t = timer_now_cycles()) < end)
+  {
+    /* Spin, counted as busy, then idle out the rest of the slot. */
+    while (timer_now_cycles() < t + busy)
+    {
+    }
+    timer_delay_until(t + slot < end ? t + slot : end);
+  }
+  cpu_load_total(&b);
+  cpu_load_diff(&a, &b, &run);
+
+  fmt_print("\nload=%u%% for %u s\n", pct, secs);
+  cpu_load_print("run", &run);
+  cpu_load_report();
+}
+
+#ifdef LCD_DISPLAY_NAME
+
+/*******************************************************************************
+ * 
+ * static void LCDFastPath( void )
+ * 
+ * Rewrites every character on the LCD LCD_PATH_SCREENS times through the
+ * HAL's stdio device, then through the direct register driver, reads the
+ * last screen back to check it, and prints one BENCH line per path with
+ * the characters per second and the time a full-screen update takes.  On
+ * the direct path it then loads the CGRAM with a bar graph and shows it.
+ * 
+ ******************************************************************************/
+
+#define LCD_PATH_SCREENS 16
+
+static void LCDFastPath( void )
+{
+  /* Every character differs between the two screens. */
+  static const char* const screens[2][LCD_FB_ROWS] =
+  {
+    { "ABCDEFGHIJKLMNOP", "abcdefghijklmnop" },
+    { "0123456789!#$%&*", "QRSTUVWXYZ@[]^_=" },
+  };
+  static const char* const paths[] = { "stdio", "direct" };
+  static const char bars[] = "Bars \x08\x09\x0a\x0b\x0c\x0d\x0e\x0f";
+  alt_u8 glyph[LCD_16207_GLYPH_ROWS];
+  struct lcd_16207_stats hw;
+  struct lcd_fb_stats st;
+  char back[LCD_FB_COLS];
+  alt_u64 start, t, total, worst, us[2] = { 0, 0 };
+  alt_u32 per_us = timer_cycles_per_us();
+  alt_u32 chars = LCD_PATH_SCREENS * LCD_FB_ROWS * LCD_FB_COLS;
+  int was = lcd_fb_direct();
+  int path, i, row, ok;
+
+  for (path = 0; path < 2; path++)
+  {
+    if (lcd_fb_set_direct(path) < 0)
+    {
+      fmt_print("\n%s path not available\n", paths[path]);
+      continue;
+    }
+    lcd_fb_reset_stats();
+    lcd_16207_reset_stats();
+    total = worst = 0;
+    for (i = 0; i < LCD_PATH_SCREENS; i++)
+    {
+      lcd_fb_puts(0, screens[i & 1][0]);
+      lcd_fb_puts(1, screens[i & 1][1]);
+      start = timer_now_cycles();
+      lcd_fb_update();
+      t = timer_now_cycles() - start;
+      total += t;
+      if (t > worst)
+      {
+        worst = t;
+      }
+    }
+    lcd_fb_get_stats(&st);
+    lcd_16207_get_stats(&hw);
+    us[path] = total / per_us;
+
+    /* Read the glass back; this leaves the HAL's cursor stale, reset below. */
+    ok = lcd_16207_ready();
+    for (row = 0; ok && row < LCD_FB_ROWS; row++)
+    {
+      lcd_16207_read(row, 0, back, LCD_FB_COLS);
+      ok = memcmp(back, screens[(i - 1) & 1][row], LCD_FB_COLS) == 0;
+    }
+
+    fmt_print("\nBENCH lcd_path path=%s cpu_hz=%lu chars=%lu bytes=%lu us=%lu "
+      "chars_per_s=%lu\n", paths[path], (unsigned long) ALT_CPU_FREQ,
+      (unsigned long) chars, (unsigned long) st.bytes, (unsigned long) us[path],
+      (unsigned long)(us[path] ? (alt_u64) chars * 1000000 / us[path] : 0));
+    fmt_print("BENCH lcd_path path=%s screen_us=%lu screen_max_us=%lu "
+      "status_polls=%lu timeouts=%lu verify=%s\n", paths[path],
+      (unsigned long)(us[path] / LCD_PATH_SCREENS), (unsigned long)(worst / per_us),
+      (unsigned long) hw.polls, (unsigned long) hw.timeouts,
+      !lcd_16207_ready() ? "skipped" : ok ? "pass" : "fail");
+  }
+  if (us[0] && us[1])
+  {
+    fmt_print("direct path is %lu.%02lux the stdio path\n",
+      (unsigned long)(us[0] / us[1]), (unsigned long)(us[0] * 100 / us[1] % 100));
+  }
+
+  lcd_fb_set_direct(was);
+  if (lcd_fb_direct())
+  {
+    /* Glyph k lights the bottom k + 1 rows: an eight-step bar graph. */
+    for (i = 0; i < LCD_16207_GLYPHS; i++)
+    {
+      for (row = 0; row < LCD_16207_GLYPH_ROWS; row++)
+      {
+        glyph[row] = (row >= LCD_16207_GLYPH_ROWS - 1 - i) ? 0x1f : 0x00;
+      }
+      lcd_16207_define_glyph(i, glyph);
+    }
+    lcd_fb_puts(0, "CGRAM glyphs");
+    lcd_fb_puts(1, bars);
+    lcd_fb_update();
+    fmt_print("The LCD shows the eight CGRAM glyphs as a bar graph.\n");
+  }
+  fmt_flush();
+}
+
+#endif
+
+/*******************************************************************************
+ * 
+ * static void LEDBrightness( void )
+ * 
+ * Ramps the brightness along the LED strip, from off at the first LED to
+ * full at the last, at the depth and for the time asked for, then prints
+ * the refresh rate, the PIO writes per period and the cost of a slot
+ * change; see led_bam.h.
+ * 
+ ******************************************************************************/
+
+/* Brightness rising along the strip, from off at LED 0 to full at the last. */
+static void bam_ramp( alt_u8 ramp[LED_STRIP_BITS] )
+{
+  int i;
+
+  for (i = 0; i < LED_STRIP_BITS; i++)
+  {
+    ramp[i] = (alt_u8)(i * 255 / (LED_STRIP_BITS - 1));
+  }
+}
+
+static void LEDBrightness( void )
+{
+  char entry[12];
+  unsigned int bits = led_bam_flicker_free_bits();
+  unsigned int secs = 2;
+  alt_u8 ramp[LED_STRIP_BITS];
+
+  printf("\nBits per LED, 1-%d [%u]: ", LED_BAM_MAX_BITS, bits);
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &bits );
+  printf("\nRun time in seconds [%u]: ", secs);
+  GetInputString( entry, sizeof(entry), stdin );
+  sscanf( entry, "%u", &secs );
+
+  bam_ramp(ramp);
+  red_count_stop();
+  led_anim_show(0x00000000);
+  led_bam_set(ramp);
+  led_bam_start(bits);
+  wait(secs * 1000000);
+  led_bam_stop();
+  printf("\n");
+  led_bam_report();
+}
+
+/*******************************************************************************
+ * 
+ * static void SelfTest( void )
+ * 
+ * Runs every compiled-in peripheral test without asking for input and
+ * streams the JSON results on the JTAG UART; see selftest.h.
+ * 
+ ******************************************************************************/
+
+static void SelfTest( void )
+{
+  int failed;
+
+  printf("\nRunning %d tests; results follow as JSON lines.\n", selftest_count());
+  failed = selftest_run_all();
+  printf("Self-test %s.\n", failed ? "FAILED" : "passed");
+}
+
+#ifdef ONCHIP_MEM_BASE
+
+/*******************************************************************************
+ * 
+ * static void MemoryTest( void )
+ * 
+ * Runs every memory test algorithm over the part of onchip_mem the program
+ * is not using and prints one BENCH line per algorithm.  What was in that
+ * part is lost.
+ * 
+ ******************************************************************************/
+
+static void MemoryTest( void )
+{
+  struct memtest_result r;
+  alt_u32 base, len;
+  int algo;
+
+  if (memtest_region(&base, &len) < 0)
+  {
+    printf("\nNo free on-chip memory to test.\n");
+    return;
+  }
+  printf("\nTesting 0x%08lx-0x%08lx (%lu bytes) of %s\n", (unsigned long) base,
+    (unsigned long)(base + len - 1), (unsigned long) len, ONCHIP_MEM_NAME);
+  for (algo = 0; algo < MEMTEST_NUM_ALGOS; algo++)
+  {
+    memtest_run(algo, base, len, &r);
+    memtest_report(algo, &r);
+  }
+}
+
+#endif
+
+/*******************************************************************************
+ * 
+ * Command console
+ * 
+ * Typed commands with arguments, read without blocking: the loop keeps
+ * draining input events and idling (which tops up the UART) between
+ * lines, and the LED animations and seven-segment scroll carry on from
+ * the timer tick while a command is being typed.
+ * 
+ ******************************************************************************/
+
+static int console_running;
+
+/* Glue argv[first..argc-1] back together with single spaces. */
+static void join_args( char* out, int size, int argc, char** argv, int first )
+{
+  int len = 0;
+  int i;
+
+  out[0] = '\0';
+  for (i = first; i < argc && len < size - 1; i++)
+  {
+    len += snprintf(&out[len], size - len, i > first ? " %s" : "%s", argv[i]);
+  }
+}
+
+static int CmdHelp( int argc, char** argv );
+
+static int CmdLed( int argc, char** argv )
+{
+  alt_u32 leds;
+
+  if (argc != 2 || console_parse_u32(argv[1], &leds) < 0)
+  {
+    return CONSOLE_USAGE;
+  }
+  red_count_stop();
+  led_bam_stop();
+  led_anim_show(leds);
+  return CONSOLE_OK;
+}
+
+static int CmdAnim( int argc, char** argv )
+{
+  static const struct
+  {
+    const char* name;
+    const struct led_anim* anim;
+  } anims[] = {
+    { "sweep",  &led_anim_sweep },
+    { "bounce", &led_anim_bounce },
+    { "count",  &led_anim_count },
+    { "center", &led_anim_center },
+  };
+  unsigned int i;
+
+  if (argc != 2)
+  {
+    return CONSOLE_USAGE;
+  }
+  red_count_stop();
+  led_bam_stop();
+  if (strcmp(argv[1], "stop") == 0)
+  {
+    led_anim_show(0);
+    return CONSOLE_OK;
+  }
+  for (i = 0; i < sizeof(anims) / sizeof(anims[0]); i++)
+  {
+    if (strcmp(argv[1], anims[i].name) == 0)
+    {
+      led_anim_play(anims[i].anim);
+      return CONSOLE_OK;
+    }
+  }
+  return CONSOLE_USAGE;
+}
+
+static int CmdSeg( int argc, char** argv )
+{
+  char text[SEG_TEXT_MAX + 1];
+
+  join_args(text, sizeof(text), argc, argv, 1);
+  seg_text_show(text);
+  return CONSOLE_OK;
+}
+
+static int CmdLcd( int argc, char** argv )
+{
+  char text[2 * LCD_FB_COLS + 4];
+  char* second;
+
+  join_args(text, sizeof(text), argc, argv, 1);
+  second = strchr(text, '/');
+  if (second != NULL)
+  {
+    *second++ = '\0';
+    while (*second == ' ')
+      second++;
+  }
+  lcd_fb_clear();
+  lcd_fb_puts(0, text);
+  lcd_fb_puts(1, second != NULL ? second : "");
+  lcd_fb_update();
+  return CONSOLE_OK;
+}
+
+#ifdef JTAG_UART_NAME
+static int CmdBench( int argc, char** argv )
+{
+  alt_u32 block = bench_block;
+
+  if (argc < 2 || argc > 3 || strcmp(argv[1], "uart") != 0 ||
+      (argc == 3 && (console_parse_u32(argv[2], &block) < 0 ||
+                     block < 1 || block > UART_BENCH_MAX_BLOCK)))
+  {
+    return CONSOLE_USAGE;
+  }
+  uart_bench_tx(block, UART_BENCH_TOTAL);
+  uart_bench_rx(block, UART_BENCH_TOTAL);
+  uart_bench_echo(UART_BENCH_MAX_SAMPLES);
+  return CONSOLE_OK;
+}
+#endif
+
+static int CmdSelfTest( int argc, char** argv )
+{
+  (void) argc;
+  (void) argv;
+  selftest_run_all();
+  return CONSOLE_OK;
+}
+
+static int CmdStress( int argc, char** argv )
+{
+  alt_u32 secs = 10;
+
+  if (argc > 2 || (argc == 2 && console_parse_u32(argv[1], &secs) < 0))
+  {
+    return CONSOLE_USAGE;
+  }
+  stress_run(secs * 1000, 1000);
+  stress_report();
+  return CONSOLE_OK;
+}
+
+static int CmdCount( int argc, char** argv )
+{
+  alt_u32 hz = RED_COUNT_MAX_HZ;
+  alt_u32 limit = 0;
+  int mode;
+
+  if (argc == 2 && strcmp(argv[1], "stop") == 0)
+  {
+    red_count_stop();
+    red_count_report();
+    return CONSOLE_OK;
+  }
+  if (argc < 2 || argc > 4 || (mode = red_count_mode(argv[1])) < 0 ||
+      (argc > 2 && console_parse_u32(argv[2], &hz) < 0) ||
+      (argc > 3 && console_parse_u32(argv[3], &limit) < 0))
+  {
+    return CONSOLE_USAGE;
+  }
+  led_anim_stop();
+  led_bam_stop();
+  red_count_start(mode, hz, limit);
+  return CONSOLE_OK;
+}
+
+static int CmdBam( int argc, char** argv )
+{
+  alt_u8 ramp[LED_STRIP_BITS];
+  alt_u32 bits = led_bam_flicker_free_bits();
+
+  if (argc == 2 && strcmp(argv[1], "stop") == 0)
+  {
+    led_bam_stop();
+    led_bam_report();
+    return CONSOLE_OK;
+  }
+  if (argc < 2 || argc > 3 ||
+      (argc == 3 && (console_parse_u32(argv[2], &bits) < 0 ||
+                     bits < 1 || bits > LED_BAM_MAX_BITS)))
+  {
+    return CONSOLE_USAGE;
+  }
+  red_count_stop();
+  led_anim_stop();
+  if (strcmp(argv[1], "scan") == 0)
+  {
+    led_bam_scan(bits);
+  }
+  else if (strcmp(argv[1], "ramp") == 0)
+  {
+    bam_ramp(ramp);
+    led_bam_set(ramp);
+    led_bam_start(bits);
+  }
+  else
+  {
+    return CONSOLE_USAGE;
+  }
+  return CONSOLE_OK;
+}
+
+static int CmdTrace( int argc, char** argv )
+{
+  struct io_trace_stats st;
+
+  if (argc > 2)
+  {
+    return CONSOLE_USAGE;
+  }
+  if (argc == 1)
+  {
+    io_trace_get_stats(&st);
+    printf("trace %s, %lu records in %lu of %u bytes, %lu dropped\n",
+      !io_trace_available() ? "not built in" :
+      io_trace_running() ? "running" : "stopped",
+      (unsigned long) st.records, (unsigned long) st.bytes,
+      (unsigned) IO_TRACE_BYTES, (unsigned long) st.dropped);
+  }
+  else if (strcmp(argv[1], "start") == 0)
+    io_trace_start();
+  else if (strcmp(argv[1], "stop") == 0)
+    io_trace_stop();
+  else if (strcmp(argv[1], "clear") == 0)
+    io_trace_clear();
+  else if (strcmp(argv[1], "dump") == 0)
+    io_trace_dump();
+  else
+    return CONSOLE_USAGE;
+  return CONSOLE_OK;
+}
+
+static int CmdLoad( int argc, char** argv )
+{
+  (void) argv;
+  if (argc != 1)
+  {
+    return CONSOLE_USAGE;
+  }
+  cpu_load_report();
+  return CONSOLE_OK;
+}
+
+static int CmdQuit( int argc, char** argv )
+{
+  (void) argc;
+  (void) argv;
+  console_running = 0;
+  return CONSOLE_OK;
+}
+
+static const struct console_cmd console_cmds[] = {
+  { "help",  "",                "list the commands",               CmdHelp },
+  { "led",   "<value>",         "show a 26-bit LED pattern",       CmdLed },
+  { "anim",  "<name>|stop",     "sweep, bounce, count or center",  CmdAnim },
+  { "seg",   "<text>",          "text on the seven-segment digits", CmdSeg },
+  { "lcd",   "<line1>[/line2]", "text on the LCD",                 CmdLcd },
+#ifdef JTAG_UART_NAME
+  { "bench", "uart [block]",    "run the JTAG UART benchmarks",    CmdBench },
+#endif
+  { "selftest", "",             "run the self-test, JSON results", CmdSelfTest },
+  { "stress", "[seconds]",      "timing stress, read-back checked", CmdStress },
+  { "count", "<mode> [hz [n]]",  "red LEDs count up, down or gray; stop", CmdCount },
+  { "bam",   "<mode> [bits]",   "LED brightness: ramp, scan; stop", CmdBam },
+  { "trace", "[action]",         "write trace: start, stop, clear, dump", CmdTrace },
+  { "load",  "",                "CPU busy, idle, io_wait and isr shares", CmdLoad },
+  { "quit",  "",                "back to the main menu",           CmdQuit },
+};
+
+#define CONSOLE_NUM_CMDS ((int)(sizeof(console_cmds) / sizeof(console_cmds[0])))
+
+static int CmdHelp( int argc, char** argv )
+{
+  (void) argc;
+  (void) argv;
+  console_help(console_cmds, CONSOLE_NUM_CMDS);
+  return CONSOLE_OK;
+}
+
+static void CommandConsole( void )
+{
+  char line[CONSOLE_LINE_MAX];
+  int len;
+
+  printf("\nCommand console; 'help' lists the commands, 'quit' leaves.\n");
+  console_running = 1;
+  printf("> ");
+  fflush(stdout);
+  while (console_running)
+  {
+    /* Other work goes on until a whole line has arrived; nothing here
+       reacts to raw edges, so keep their queue from filling. */
+    input_events_flush();
+    len = console_get_line(line, sizeof(line));
+    if (len == CONSOLE_EOF)
+    {
+      break;
+    }
+    if (len < 0)
+    {
+      timer_idle();
+      continue;
+    }
+    if (console_dispatch(line, console_cmds, CONSOLE_NUM_CMDS) == CONSOLE_UNKNOWN)
+    {
+      printf("unknown command; try 'help'\n");
+    }
+    if (console_running)
+    {
+      printf("> ");
+      fflush(stdout);
+    }
+  }
+}
+
+/* Idle work: keep the UART output moving and collect console input. */
+static void idle_poll( void )
+{
+  uart_tx_poll();
+  console_poll();
+}
+
+int main()
+{
+#ifdef BOARD_DIAG_BATCH
+  int failed;
+#endif
+
+	timer_init();
+	cpu_load_init();
+	io_trace_init();
+	sched_init();
+	input_events_init();
+	buttons_init();
+	led_anim_init();
+	red_count_init();
+	led_bam_init();
+	seg_text_init(); //turn off all seven seg displays
+	pio_shadow_init();
+	lcd_fb_init();
+	uart_tx_init();
+	console_init();
+	timer_set_idle_hook(idle_poll);
+
+#ifdef BOARD_DIAG_BATCH
+  /* Production test: no menu, no operator; the exit status is the failures. */
+  failed = selftest_run_all();
+  printf( "%c", EOT );
+  return( failed ? 1 : 0 );
+#endif
+
+  menu_run(&top_menu);
+  printf( "\nExiting from Board Diagnostics.\n");
+  /* Send EOT to nios2-terminal on the other side of the link. */
+  printf( "%c", EOT );
   return( 0 );
 }
 /******************************************************************************
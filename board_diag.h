@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ * board_diag.h
+ *
+ * Common includes, definitions and prototypes for board_diag.c.
+ *
+ * The Nios II HAL headers (system.h, alt_types.h, io.h, the peripheral
+ * register headers and sys/alt_irq.h) come from the BSP when building for
+ * the board.  For the Linux host build the stand-ins in host/ are used
+ * instead; see README.md.
+ *
+ ******************************************************************************/
+
+#ifndef __BOARD_DIAG_H__
+#define __BOARD_DIAG_H__
+
+/* Include Files */
+#include <stdio.h>
+#include <errno.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+
+#include "system.h"
+#include "qsys_map.h"
+#include "alt_types.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_irq.h"
+#include "sys/alt_alarm.h"
+
+#include "timer_service.h"
+#include "cpu_load.h"
+#include "input_events.h"
+#include "led_anim.h"
+#include "led_bam.h"
+#include "red_count.h"
+#include "pio_shadow.h"
+#include "lcd_16207.h"
+#include "lcd_fb.h"
+#include "seg_text.h"
+#include "uart_tx.h"
+#include "uart_bench.h"
+#include "console.h"
+#include "sched.h"
+#include "buttons.h"
+#include "selftest.h"
+#include "memtest.h"
+#include "stress.h"
+#include "fmt.h"
+#include "menu.h"
+#include "bus_prof.h"
+#include "io_trace.h"
+
+/* Defines */
+#define EOT               0x4
+#define ESC               27
+#define ESC_TOP_LEFT      "[1;0H"
+#define ESC_BOTTOM_LEFT   "[2;0H"
+#define ESC_CLEAR         "K"
+#define ESC_COL2_INDENT5  "[2;5H"
+#define CLEAR_LCD_STRING  "[2J"
+
+/* Function Prototypes */
+void GetInputString( char* entry, int size, FILE * stream );
+
+#ifdef LED_PIO_NAME
+static void TestLEDs( void );
+#endif
+
+#ifdef LCD_DISPLAY_NAME
+static void TestLCD( void );
+#endif
+
+#ifdef BUTTON_PIO_NAME
+static void TestButtons( void );
+#endif
+
+#ifdef SEVEN_SEG_PIO_NAME
+static void DoSevenSegMenu( void );
+static void SevenSegCount( void );
+static void SevenSegControl( void );
+static void SevenSegText( void );
+#endif
+
+#ifdef JTAG_UART_NAME
+static void DoJTAGUARTMenu( void );
+static void UARTSendLots( void );
+static void UARTReceiveChars( void );
+static void DoUARTBenchMenu( void );
+static void UARTBenchBanner( void );
+static void UARTBenchTX( void );
+static void UARTBenchRX( void );
+static void UARTBenchEcho( void );
+static void UARTBenchBlockSize( void );
+static void UARTBenchAll( void );
+#endif
+
+#ifdef KEY_NAME
+static void Test_Func( void );
+#endif
+
+static void DoPerfMenu( void );
+static void TimerAccuracy( void );
+static void InputLatency( void );
+static void LEDAnimations( void );
+static void PIOCoalescing( void );
+static void LCDUpdateCost( void );
+static void SchedulerStats( void );
+static void DebounceStress( void );
+static void DoBusProfMenu( void );
+static void BusProfTasks( void );
+static void TimingStress( void );
+static int  FormatterLine( int line, int use_fmt, char* buf, int size, alt_u32 n );
+static void FormatterCost( void );
+static void RedLEDCounter( void );
+static void CPULoad( void );
+#ifdef LCD_DISPLAY_NAME
+static void LCDFastPath( void );
+#endif
+static void LEDBrightness( void );
+
+static void SelfTest( void );
+#ifdef ONCHIP_MEM_BASE
+static void MemoryTest( void );
+#endif
+static void CommandConsole( void );
+static void idle_poll( void );
+
+static void wait( int a );
+static void modified_LCD( void );
+
+#endif /* __BOARD_DIAG_H__ */
@@ -0,0 +1,335 @@
+/******************************************************************************
+ *
+ * bus_prof.c
+ *
+ * Avalon access profiler.  See bus_prof.h.
+ *
+ * The timestamp is the sys_clk_timer down counter latched through its
+ * snapshot register.  An access takes a few cycles, far less than the
+ * timer period, so two snapshots are at most one reload apart.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "io.h"
+#include "altera_avalon_timer_regs.h"
+#include "sys/alt_irq.h"
+
+#define BUS_PROF_IMPL
+#include "bus_prof.h"
+
+#ifdef BUS_PROF
+
+#define BUS_PROF_TIMER      SYS_CLK_TIMER_BASE
+#define BUS_PROF_CALIBRATE  64
+
+static const struct
+{
+  const char* name;
+  alt_u32 base;
+} bus_prof_names[] =
+{
+#ifdef KEY_BASE
+  { "key", KEY_BASE },
+#endif
+#ifdef BUTTON_PIO_BASE
+  { "button_pio", BUTTON_PIO_BASE },
+#endif
+#ifdef LED_PIO_BASE
+  { "led_pio", LED_PIO_BASE },
+#endif
+#ifdef RED_LED_BASE
+  { "red_led", RED_LED_BASE },
+#endif
+#ifdef SEVEN_SEG_PIO_BASE
+  { "seven_seg_pio", SEVEN_SEG_PIO_BASE },
+#endif
+#ifdef SEVEN_SEG_PIO_1_BASE
+  { "seven_seg_pio_1", SEVEN_SEG_PIO_1_BASE },
+#endif
+#ifdef LCD_DISPLAY_BASE
+  { "lcd_display", LCD_DISPLAY_BASE },
+#endif
+#ifdef JTAG_UART_BASE
+  { "jtag_uart", JTAG_UART_BASE },
+#endif
+#ifdef SYSID_BASE
+  { "sysid", SYSID_BASE },
+#endif
+};
+
+#define BUS_PROF_NUM_NAMES ((int)(sizeof(bus_prof_names) / sizeof(bus_prof_names[0])))
+
+volatile int bus_prof_on;
+
+static struct bus_prof_slave bus_prof_slaves[BUS_PROF_MAX_SLAVES];
+static int bus_prof_count;
+static alt_u32 bus_prof_period;
+static alt_u32 bus_prof_bracket;
+static alt_u32 bus_prof_lost;           /* accesses to slaves beyond the table */
+
+static alt_u32 bus_prof_stamp( void )
+{
+  BUS_PROF_IOWR(BUS_PROF_TIMER, ALTERA_AVALON_TIMER_SNAPL_REG, 0);
+  return (BUS_PROF_IORD(BUS_PROF_TIMER, ALTERA_AVALON_TIMER_SNAPL_REG) & 0xffff) |
+         (BUS_PROF_IORD(BUS_PROF_TIMER, ALTERA_AVALON_TIMER_SNAPH_REG) << 16);
+}
+
+/* Cycles from snapshot t0 to snapshot t1 of the down counter. */
+static alt_u32 bus_prof_elapsed( alt_u32 t0, alt_u32 t1 )
+{
+  return t1 <= t0 ? t0 - t1 : t0 + bus_prof_period - t1;
+}
+
+static struct bus_prof_slave* bus_prof_slave( alt_u32 base )
+{
+  struct bus_prof_slave* s;
+  int i;
+
+  for (i = 0; i < bus_prof_count; i++)
+  {
+    if (bus_prof_slaves[i].base == base)
+    {
+      return &bus_prof_slaves[i];
+    }
+  }
+  if (bus_prof_count == BUS_PROF_MAX_SLAVES)
+  {
+    return NULL;
+  }
+  s = &bus_prof_slaves[bus_prof_count++];
+  s->base = base;
+  s->name = NULL;
+  s->reads = 0;
+  s->writes = 0;
+  s->cycles = 0;
+  s->min = 0xffffffff;
+  s->max = 0;
+  for (i = 0; i < BUS_PROF_BUCKETS; i++)
+  {
+    s->hist[i] = 0;
+  }
+  for (i = 0; i < BUS_PROF_NUM_NAMES; i++)
+  {
+    if (bus_prof_names[i].base == base)
+    {
+      s->name = bus_prof_names[i].name;
+    }
+  }
+  return s;
+}
+
+/* Interrupts are disabled. */
+static void bus_prof_record( alt_u32 base, int write, alt_u32 t0, alt_u32 t1 )
+{
+  struct bus_prof_slave* s = bus_prof_slave(base);
+  alt_u32 cycles = bus_prof_elapsed(t0, t1);
+  int bucket = 0;
+
+  if (s == NULL)
+  {
+    bus_prof_lost++;
+    return;
+  }
+  cycles = cycles > bus_prof_bracket ? cycles - bus_prof_bracket : 0;
+  if (write)
+    s->writes++;
+  else
+    s->reads++;
+  s->cycles += cycles;
+  if (cycles < s->min)
+    s->min = cycles;
+  if (cycles > s->max)
+    s->max = cycles;
+  while ((cycles >> bucket) != 0 && bucket < BUS_PROF_BUCKETS - 1)
+  {
+    bucket++;
+  }
+  s->hist[bucket]++;
+}
+
+alt_u32 bus_prof_rd_timed( alt_u32 base, alt_u32 reg )
+{
+  alt_irq_context irq;
+  alt_u32 t0, t1, value;
+
+  irq = alt_irq_disable_all();
+  t0 = bus_prof_stamp();
+  value = BUS_PROF_IORD(base, reg);
+  t1 = bus_prof_stamp();
+  bus_prof_record(base, 0, t0, t1);
+  alt_irq_enable_all(irq);
+  return value;
+}
+
+void bus_prof_wr_timed( alt_u32 base, alt_u32 reg, alt_u32 data )
+{
+  alt_irq_context irq;
+  alt_u32 t0, t1;
+
+  irq = alt_irq_disable_all();
+  t0 = bus_prof_stamp();
+  BUS_PROF_IOWR(base, reg, data);
+  t1 = bus_prof_stamp();
+  bus_prof_record(base, 1, t0, t1);
+  alt_irq_enable_all(irq);
+}
+
+void bus_prof_reset( void )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  bus_prof_count = 0;
+  bus_prof_lost = 0;
+  alt_irq_enable_all(irq);
+}
+
+void bus_prof_start( void )
+{
+  alt_irq_context irq;
+  alt_u32 t0, t1, d;
+  int i;
+
+  bus_prof_period = ((BUS_PROF_IORD(BUS_PROF_TIMER, ALTERA_AVALON_TIMER_PERIODH_REG) << 16) |
+                     (BUS_PROF_IORD(BUS_PROF_TIMER, ALTERA_AVALON_TIMER_PERIODL_REG) & 0xffff)) + 1;
+
+  /* The fastest empty bracket is the cost of the timestamps alone. */
+  bus_prof_bracket = 0xffffffff;
+  for (i = 0; i < BUS_PROF_CALIBRATE; i++)
+  {
+    irq = alt_irq_disable_all();
+    t0 = bus_prof_stamp();
+    t1 = bus_prof_stamp();
+    alt_irq_enable_all(irq);
+    d = bus_prof_elapsed(t0, t1);
+    if (d < bus_prof_bracket)
+    {
+      bus_prof_bracket = d;
+    }
+  }
+  bus_prof_reset();
+  bus_prof_on = 1;
+}
+
+void bus_prof_stop( void )
+{
+  bus_prof_on = 0;
+}
+
+int bus_prof_available( void )
+{
+  return 1;
+}
+
+alt_u32 bus_prof_overhead( void )
+{
+  return bus_prof_bracket;
+}
+
+int bus_prof_get( struct bus_prof_slave* out, int max )
+{
+  alt_irq_context irq;
+  int i, n;
+
+  irq = alt_irq_disable_all();
+  n = bus_prof_count < max ? bus_prof_count : max;
+  for (i = 0; i < n; i++)
+  {
+    out[i] = bus_prof_slaves[i];
+  }
+  alt_irq_enable_all(irq);
+  return n;
+}
+
+void bus_prof_dump( void )
+{
+  static const char* const labels[BUS_PROF_BUCKETS] =
+  {
+    "0", "1", "2-3", "4-7", "8-15", "16-31", "32-63", "64-127", "128-255", "256+"
+  };
+  struct bus_prof_slave slaves[BUS_PROF_MAX_SLAVES];
+  struct bus_prof_slave* s;
+  alt_u32 n, avg10;
+  int count, i, b;
+
+  count = bus_prof_get(slaves, BUS_PROF_MAX_SLAVES);
+  printf("\nBus profile (%s), latency in CPU cycles less %lu for the timestamps\n",
+    bus_prof_on ? "running" : "stopped", (unsigned long) bus_prof_bracket);
+  printf("%-16s %-10s %8s %8s %5s %7s %5s\n",
+    "slave", "base", "reads", "writes", "min", "avg", "max");
+  for (i = 0; i < count; i++)
+  {
+    s = &slaves[i];
+    n = s->reads + s->writes;
+    avg10 = n ? (alt_u32)(s->cycles * 10 / n) : 0;
+    printf("%-16s 0x%08lx %8lu %8lu %5lu %5lu.%lu %5lu\n",
+      s->name != NULL ? s->name : "?", (unsigned long) s->base,
+      (unsigned long) s->reads, (unsigned long) s->writes,
+      (unsigned long) s->min, (unsigned long)(avg10 / 10),
+      (unsigned long)(avg10 % 10), (unsigned long) s->max);
+  }
+  if (bus_prof_lost)
+  {
+    printf("(%lu accesses to further slaves not recorded)\n",
+      (unsigned long) bus_prof_lost);
+  }
+
+  printf("\n%-16s", "cycles");
+  for (b = 0; b < BUS_PROF_BUCKETS; b++)
+  {
+    printf(" %7s", labels[b]);
+  }
+  printf("\n");
+  for (i = 0; i < count; i++)
+  {
+    s = &slaves[i];
+    printf("%-16s", s->name != NULL ? s->name : "?");
+    for (b = 0; b < BUS_PROF_BUCKETS; b++)
+    {
+      printf(" %7lu", (unsigned long) s->hist[b]);
+    }
+    printf("\n");
+  }
+}
+
+#else
+
+void bus_prof_start( void )
+{
+}
+
+void bus_prof_stop( void )
+{
+}
+
+void bus_prof_reset( void )
+{
+}
+
+int bus_prof_available( void )
+{
+  return 0;
+}
+
+alt_u32 bus_prof_overhead( void )
+{
+  return 0;
+}
+
+int bus_prof_get( struct bus_prof_slave* out, int max )
+{
+  (void) out;
+  (void) max;
+  return 0;
+}
+
+void bus_prof_dump( void )
+{
+  printf("\nThe bus profiler is not built in; rebuild with -DBUS_PROF.\n");
+}
+
+#endif /* BUS_PROF */
@@ -0,0 +1,109 @@
+/******************************************************************************
+ *
+ * bus_prof.h
+ *
+ * Avalon access profiler: per-slave access counts and latency histograms.
+ *
+ * Built with BUS_PROF defined, this header takes over IORD and IOWR in
+ * every file that includes it after io.h and the register headers, so the
+ * drivers' IORD_ALTERA_AVALON_PIO_DATA() and friends are profiled without
+ * being rewritten.  Each access then costs one load and a not-taken branch
+ * while profiling is stopped.  Built without BUS_PROF it changes nothing.
+ *
+ * While profiling runs, each access is bracketed by two sys_clk_timer
+ * snapshots with interrupts disabled, and the time the empty bracket takes
+ * (measured by bus_prof_start()) is subtracted.  Latencies are in CPU
+ * cycles and go into log2 buckets per slave base address; the slaves in
+ * system.h are known by name.
+ *
+ * timer_service reads the same timer and is not profiled.  The JTAG UART,
+ * and the LCD when written through /dev/lcd_display, are accessed inside
+ * the HAL drivers and are not seen either; lcd_16207's accesses are.
+ *
+ ******************************************************************************/
+
+#ifndef __BUS_PROF_H__
+#define __BUS_PROF_H__
+
+#include "alt_types.h"
+
+#define BUS_PROF_MAX_SLAVES 16
+#define BUS_PROF_BUCKETS    10  /* 0, 1, 2-3, 4-7, ... 128-255, 256 and up */
+
+struct bus_prof_slave
+{
+  const char* name;     /* from system.h, or NULL */
+  alt_u32 base;
+  alt_u32 reads;
+  alt_u32 writes;
+  alt_u64 cycles;       /* sum of the latencies */
+  alt_u32 min;
+  alt_u32 max;
+  alt_u32 hist[BUS_PROF_BUCKETS];
+};
+
+/* Calibrate, clear and start collecting. */
+void bus_prof_start( void );
+void bus_prof_stop( void );
+void bus_prof_reset( void );
+
+/* 1 if the profiler is compiled in. */
+int bus_prof_available( void );
+
+/* Cycles the timestamp bracket itself takes; subtracted from every sample. */
+alt_u32 bus_prof_overhead( void );
+
+/* Slaves seen so far, in order of first access; returns the count. */
+int bus_prof_get( struct bus_prof_slave* out, int max );
+
+/* Print the table and histograms on stdout. */
+void bus_prof_dump( void );
+
+#ifdef BUS_PROF
+
+#include "io.h"
+
+/* The HAL's own IORD/IOWR, for the profiler's use once they are replaced. */
+#ifdef BOARD_DIAG_HOST
+#define BUS_PROF_IORD(b, r)    host_hal_read((b), (r))
+#define BUS_PROF_IOWR(b, r, d) host_hal_write((b), (r), (d))
+#else
+#define BUS_PROF_IORD(b, r)    __builtin_ldwio(__IO_CALC_ADDRESS_NATIVE((b), (r)))
+#define BUS_PROF_IOWR(b, r, d) __builtin_stwio(__IO_CALC_ADDRESS_NATIVE((b), (r)), (d))
+#endif
+
+extern volatile int bus_prof_on;
+
+alt_u32 bus_prof_rd_timed( alt_u32 base, alt_u32 reg );
+void bus_prof_wr_timed( alt_u32 base, alt_u32 reg, alt_u32 data );
+
+static ALT_INLINE alt_u32 ALT_ALWAYS_INLINE bus_prof_rd( alt_u32 base, alt_u32 reg )
+{
+  if (__builtin_expect(bus_prof_on, 0))
+  {
+    return bus_prof_rd_timed(base, reg);
+  }
+  return BUS_PROF_IORD(base, reg);
+}
+
+static ALT_INLINE void ALT_ALWAYS_INLINE bus_prof_wr( alt_u32 base, alt_u32 reg,
+                                                      alt_u32 data )
+{
+  if (__builtin_expect(bus_prof_on, 0))
+  {
+    bus_prof_wr_timed(base, reg, data);
+    return;
+  }
+  BUS_PROF_IOWR(base, reg, data);
+}
+
+#ifndef BUS_PROF_IMPL
+#undef IORD
+#undef IOWR
+#define IORD(BASE, REGNUM)       bus_prof_rd((BASE), (REGNUM))
+#define IOWR(BASE, REGNUM, DATA) bus_prof_wr((BASE), (REGNUM), (DATA))
+#endif
+
+#endif /* BUS_PROF */
+
+#endif /* __BUS_PROF_H__ */
@@ -0,0 +1,270 @@
+/******************************************************************************
+ *
+ * buttons.c
+ *
+ * Debounced button and switch events.  See buttons.h.
+ *
+ * The edge hook and the tick hook both run in interrupt context, and Nios II
+ * interrupts do not nest, so the per-bit state needs no locking.  Events go
+ * to the main loop through a single-producer/single-consumer ring laid out
+ * like the one in input_events.c.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "input_events.h"
+#include "buttons.h"
+
+#define BUTTON_QUEUE_MASK (BUTTON_EVENT_QUEUE_SIZE - 1)
+
+#if (BUTTON_EVENT_QUEUE_SIZE & BUTTON_QUEUE_MASK) != 0
+#error "BUTTON_EVENT_QUEUE_SIZE must be a power of two"
+#endif
+
+#define BUTTON_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+#define BUTTON_WIDTH_MASK(w) ((alt_u32)((1ULL << (w)) - 1))
+
+struct button_bit
+{
+  alt_u64 first_edge;   /* timestamp of the burst's first edge */
+  alt_u32 last_edge;    /* button_ticks at the burst's latest edge */
+  alt_u32 press_tick;   /* button_ticks when the press was accepted */
+  alt_u8  edges;        /* edges in the burst */
+};
+
+struct button_source
+{
+  alt_u32 mask;
+  alt_u32 active_low;
+  alt_u32 raw;          /* latest level, 1 = pressed */
+  volatile alt_u32 stable;      /* debounced level, 1 = pressed */
+  alt_u32 burst;        /* bits with edges not yet settled */
+  alt_u32 long_sent;    /* pressed bits already reported as long */
+  struct button_bit bits[32];
+};
+
+static struct button_source button_src[INPUT_NUM_SRC] =
+{
+#ifdef KEY_BASE
+  { .mask = BUTTON_WIDTH_MASK(KEY_DATA_WIDTH),
+    .active_low = BUTTON_WIDTH_MASK(KEY_DATA_WIDTH) },
+#else
+  { .mask = 0 },
+#endif
+#ifdef BUTTON_PIO_BASE
+  { .mask = BUTTON_WIDTH_MASK(BUTTON_PIO_DATA_WIDTH), .active_low = 0 },
+#else
+  { .mask = 0 },
+#endif
+};
+
+static struct button_event button_ring[BUTTON_EVENT_QUEUE_SIZE];
+static volatile alt_u32 button_head;
+static volatile alt_u32 button_tail;
+static alt_u32 button_ticks;
+static alt_u32 button_debounce_ticks;
+static alt_u32 button_long_ticks;
+static struct button_stats button_stats;
+
+static alt_u32 button_ms_to_ticks( alt_u32 ms )
+{
+  alt_u32 tick_us = timer_tick_us();
+
+  return (ms * 1000 + tick_us - 1) / tick_us;
+}
+
+/* Producer side: interrupt context only. */
+
+static void button_push( alt_u64 timestamp, int source, int bit, int type,
+                         int bounces )
+{
+  alt_u32 head = button_head;
+  struct button_event* ev;
+
+  if (head - button_tail >= BUTTON_EVENT_QUEUE_SIZE)
+  {
+    button_stats.dropped++;
+    return;
+  }
+  ev = &button_ring[head & BUTTON_QUEUE_MASK];
+  ev->timestamp = timestamp;
+  ev->source = source;
+  ev->bit = bit;
+  ev->type = type;
+  ev->bounces = bounces;
+  BUTTON_BARRIER();
+  button_head = head + 1;
+}
+
+/* Edge hook: note every raw edge against its bit's burst. */
+
+static void button_edge( const struct input_event* ev )
+{
+  struct button_source* src = &button_src[ev->source];
+  struct button_bit* b;
+  alt_u32 changed = (ev->rising | ev->falling) & src->mask;
+  alt_u32 pulses = ev->rising & ev->falling;
+  int i;
+
+  src->raw = (ev->state ^ src->active_low) & src->mask;
+  for (i = 0; changed != 0; i++, changed >>= 1)
+  {
+    if ((changed & 1) == 0)
+    {
+      continue;
+    }
+    b = &src->bits[i];
+    if ((src->burst & (1u << i)) == 0)
+    {
+      src->burst |= 1u << i;
+      b->first_edge = ev->timestamp;
+      b->edges = 0;
+    }
+    /* A pulse shorter than the sampling is two edges. */
+    b->edges += (pulses & (1u << i)) ? 2 : 1;
+    if (b->edges > 250)
+    {
+      b->edges = 250;
+    }
+    b->last_edge = button_ticks;
+    button_stats.raw_edges++;
+  }
+}
+
+/* Tick hook: settle quiet bursts and time long presses. */
+
+static void button_tick( void* context )
+{
+  struct button_source* src;
+  struct button_bit* b;
+  alt_u32 bit;
+  int id, i;
+
+  (void) context;
+  button_ticks++;
+  for (id = 0; id < INPUT_NUM_SRC; id++)
+  {
+    src = &button_src[id];
+    for (i = 0; i < 32 && ((src->burst | (src->stable & ~src->long_sent)) >> i); i++)
+    {
+      bit = 1u << i;
+      b = &src->bits[i];
+      if ((src->burst & bit) && button_ticks - b->last_edge > button_debounce_ticks)
+      {
+        src->burst &= ~bit;
+        if ((src->raw ^ src->stable) & bit)
+        {
+          src->stable ^= bit;
+          if (src->stable & bit)
+          {
+            b->press_tick = button_ticks;
+            src->long_sent &= ~bit;
+            button_stats.presses++;
+            button_push(b->first_edge, id, i, BUTTON_PRESS, b->edges - 1);
+          }
+          else
+          {
+            button_stats.releases++;
+            button_push(b->first_edge, id, i, BUTTON_RELEASE, b->edges - 1);
+          }
+        }
+        else
+        {
+          button_stats.glitches++;
+        }
+      }
+      if ((src->stable & ~src->long_sent & bit) &&
+          button_ticks - b->press_tick >= button_long_ticks)
+      {
+        src->long_sent |= bit;
+        button_stats.longs++;
+        button_push(timer_now_cycles(), id, i, BUTTON_LONG, 0);
+      }
+    }
+  }
+}
+
+void buttons_init( void )
+{
+  int id;
+
+  button_debounce_ticks = button_ms_to_ticks(BUTTON_DEBOUNCE_MS);
+  button_long_ticks = button_ms_to_ticks(BUTTON_LONG_MS);
+  for (id = 0; id < INPUT_NUM_SRC; id++)
+  {
+    button_src[id].raw = (input_events_state(id) ^ button_src[id].active_low) &
+                         button_src[id].mask;
+    button_src[id].stable = button_src[id].raw;
+    /* Whatever is already held at start-up does not count as long. */
+    button_src[id].long_sent = button_src[id].stable;
+  }
+  input_events_set_edge_hook(button_edge);
+  timer_add_tick_hook(button_tick, NULL);
+}
+
+void buttons_set_debounce_ms( alt_u32 ms )
+{
+  button_debounce_ticks = button_ms_to_ticks(ms);
+}
+
+void buttons_set_long_ms( alt_u32 ms )
+{
+  button_long_ticks = button_ms_to_ticks(ms);
+}
+
+/* Consumer side: main loop only. */
+
+int buttons_get( struct button_event* ev )
+{
+  alt_u32 tail = button_tail;
+
+  if (tail == button_head)
+  {
+    return 0;
+  }
+  BUTTON_BARRIER();
+  *ev = button_ring[tail & BUTTON_QUEUE_MASK];
+  BUTTON_BARRIER();
+  button_tail = tail + 1;
+  return 1;
+}
+
+void buttons_flush( void )
+{
+  button_tail = button_head;
+}
+
+alt_u32 buttons_pressed( int source )
+{
+  return button_src[source].stable;
+}
+
+void buttons_get_stats( struct button_stats* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  *out = button_stats;
+  alt_irq_enable_all(irq);
+}
+
+void buttons_reset_stats( void )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  button_stats.raw_edges = 0;
+  button_stats.presses = 0;
+  button_stats.releases = 0;
+  button_stats.longs = 0;
+  button_stats.glitches = 0;
+  button_stats.dropped = 0;
+  alt_irq_enable_all(irq);
+}
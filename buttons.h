@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ * buttons.h
+ *
+ * Debounced press, release and long-press events for every bit of the key
+ * and button_pio (switch) PIOs.
+ *
+ * Raw edges come from input_events, timestamped where they are captured
+ * (handle_button_interrupts, or the tick sampler for a PIO without an edge
+ * interrupt).  Each bit then runs its own state machine on the system clock
+ * tick: a burst of edges is only accepted once the bit has been quiet for
+ * the debounce time, and only if it settled at the other level; a burst that
+ * settles back where it started is counted as a glitch and reported to no
+ * one.  A press held for the long-press time also yields one BUTTON_LONG.
+ *
+ * KEY is active low and the switches active high; both are reported as
+ * 'pressed' (key down, switch on).  Event timestamps are those of the first
+ * edge of the burst, so press-to-reaction latency includes the debounce
+ * time.
+ *
+ ******************************************************************************/
+
+#ifndef __BUTTONS_H__
+#define __BUTTONS_H__
+
+#include "alt_types.h"
+
+/* Ring capacity; must be a power of two. */
+#define BUTTON_EVENT_QUEUE_SIZE 64
+
+#define BUTTON_DEBOUNCE_MS 10   /* default settle time */
+#define BUTTON_LONG_MS     1000 /* default long-press time */
+
+#define BUTTON_PRESS   0
+#define BUTTON_RELEASE 1
+#define BUTTON_LONG    2
+
+struct button_event
+{
+  alt_u64 timestamp;    /* timer_now_cycles() of the burst's first edge */
+  alt_u8  source;       /* INPUT_SRC_KEY or INPUT_SRC_SWITCH */
+  alt_u8  bit;          /* bit number within the PIO */
+  alt_u8  type;         /* BUTTON_PRESS, BUTTON_RELEASE or BUTTON_LONG */
+  alt_u8  bounces;      /* extra edges filtered out of the burst */
+};
+
+struct button_stats
+{
+  alt_u32 raw_edges;    /* single-bit edges seen */
+  alt_u32 presses;
+  alt_u32 releases;
+  alt_u32 longs;
+  alt_u32 glitches;     /* bursts that settled back where they started */
+  alt_u32 dropped;      /* events lost because the ring was full */
+};
+
+/* Hook into input_events and the tick.  Call after input_events_init(). */
+void buttons_init( void );
+
+/* Settle time; 0 accepts every sampled level change as it is seen. */
+void buttons_set_debounce_ms( alt_u32 ms );
+void buttons_set_long_ms( alt_u32 ms );
+
+/* Pop the oldest event.  Returns 1 if one was available, 0 if empty. */
+int buttons_get( struct button_event* ev );
+
+/* Discard everything queued so far. */
+void buttons_flush( void );
+
+/* Debounced 'pressed' bits of a source. */
+alt_u32 buttons_pressed( int source );
+
+void buttons_get_stats( struct button_stats* out );
+void buttons_reset_stats( void );
+
+#endif /* __BUTTONS_H__ */
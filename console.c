@@ -0,0 +1,249 @@
+/******************************************************************************
+ *
+ * console.c
+ *
+ * Non-blocking line input and command dispatch on stdin.  See console.h.
+ *
+ * Like uart_tx, everything here runs in the main loop (the idle hook
+ * included), never in interrupt context, so the ring needs no locking.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "alt_types.h"
+
+#include "timer_service.h"
+#include "console.h"
+
+#define CONSOLE_MASK (CONSOLE_RING_SIZE - 1)
+
+#if (CONSOLE_RING_SIZE & CONSOLE_MASK) != 0
+#error "CONSOLE_RING_SIZE must be a power of two"
+#endif
+
+static char console_ring[CONSOLE_RING_SIZE];
+static alt_u32 console_head;    /* next byte to store */
+static alt_u32 console_tail;    /* next byte to parse */
+
+/* The line being assembled from the ring. */
+static char console_line[CONSOLE_LINE_MAX];
+static int console_len;
+static int console_long;        /* current line overflowed console_line */
+static int console_eof;         /* read() has reported end of input */
+
+static struct console_stats console_stats;
+
+int console_init( void )
+{
+  int flags = fcntl(STDIN_FILENO, F_GETFL);
+
+  if (flags < 0 || fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK) < 0)
+  {
+    return -1;
+  }
+  return 0;
+}
+
+void console_poll( void )
+{
+  char buf[32];
+  int n, i;
+
+  while (!console_eof && (n = read(STDIN_FILENO, buf, sizeof(buf))) >= 0)
+  {
+    if (n == 0)
+    {
+      console_eof = 1;
+      break;
+    }
+    console_stats.bytes += n;
+    for (i = 0; i < n; i++)
+    {
+      if (console_head - console_tail == CONSOLE_RING_SIZE)
+      {
+        console_stats.dropped += n - i;
+        break;
+      }
+      console_ring[console_head & CONSOLE_MASK] = buf[i];
+      console_head++;
+    }
+  }
+}
+
+/* Hand out the assembled line and start the next one. */
+static int console_take_line( char* buf, int size )
+{
+  int len;
+
+  len = console_len < size - 1 ? console_len : size - 1;
+  memcpy(buf, console_line, len);
+  buf[len] = '\0';
+  if (console_long)
+  {
+    console_stats.truncated++;
+  }
+  console_len = 0;
+  console_long = 0;
+  console_stats.lines++;
+  return len;
+}
+
+int console_get_line( char* buf, int size )
+{
+  char ch;
+
+  console_poll();
+  while (console_tail != console_head)
+  {
+    ch = console_ring[console_tail & CONSOLE_MASK];
+    console_tail++;
+
+    if (ch == '\n')
+    {
+      return console_take_line(buf, size);
+    }
+    if (ch == '\r')
+    {
+      continue;
+    }
+    if (ch == '\b' || ch == 0x7f)
+    {
+      if (console_len > 0)
+      {
+        console_len--;
+      }
+      continue;
+    }
+    if (console_len < CONSOLE_LINE_MAX - 1)
+    {
+      console_line[console_len++] = ch;
+    }
+    else
+    {
+      console_long = 1;
+    }
+  }
+  if (console_eof)
+  {
+    /* A last line without a newline still counts. */
+    if (console_len > 0 || console_long)
+    {
+      return console_take_line(buf, size);
+    }
+    return CONSOLE_EOF;
+  }
+  return -1;
+}
+
+int console_read_line( char* buf, int size )
+{
+  int len;
+
+  while ((len = console_get_line(buf, size)) == -1)
+  {
+    timer_idle();
+  }
+  return len;
+}
+
+void console_flush( void )
+{
+  console_poll();
+  console_tail = console_head;
+  console_len = 0;
+  console_long = 0;
+}
+
+static int console_split( char* line, char** argv )
+{
+  int argc = 0;
+
+  while (argc < CONSOLE_MAX_ARGS)
+  {
+    while (*line == ' ' || *line == '\t')
+    {
+      line++;
+    }
+    if (*line == '\0')
+    {
+      break;
+    }
+    argv[argc++] = line;
+    while (*line != '\0' && *line != ' ' && *line != '\t')
+    {
+      line++;
+    }
+    if (*line != '\0')
+    {
+      *line++ = '\0';
+    }
+  }
+  return argc;
+}
+
+int console_dispatch( char* line, const struct console_cmd* table, int count )
+{
+  char* argv[CONSOLE_MAX_ARGS];
+  int argc;
+  int i;
+
+  argc = console_split(line, argv);
+  if (argc == 0)
+  {
+    return CONSOLE_EMPTY;
+  }
+  for (i = 0; i < count; i++)
+  {
+    if (strcmp(argv[0], table[i].name) == 0)
+    {
+      if (table[i].handler(argc, argv) == CONSOLE_USAGE)
+      {
+        printf("usage: %s %s\n", table[i].name, table[i].args);
+        return CONSOLE_USAGE;
+      }
+      return CONSOLE_OK;
+    }
+  }
+  return CONSOLE_UNKNOWN;
+}
+
+void console_help( const struct console_cmd* table, int count )
+{
+  int i;
+
+  for (i = 0; i < count; i++)
+  {
+    printf("  %-6s %-16s %s\n", table[i].name, table[i].args, table[i].help);
+  }
+}
+
+int console_parse_u32( const char* text, alt_u32* out )
+{
+  char* end;
+  unsigned long v;
+
+  if (text == NULL || *text == '\0' || *text == '-')
+  {
+    return -1;
+  }
+  errno = 0;
+  v = strtoul(text, &end, 0);
+  if (*end != '\0' || errno != 0 || v > 0xFFFFFFFFUL)
+  {
+    return -1;
+  }
+  *out = (alt_u32) v;
+  return 0;
+}
+
+void console_get_stats( struct console_stats* out )
+{
+  *out = console_stats;
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ * console.h
+ *
+ * Non-blocking line input and command dispatch on stdin (the JTAG UART).
+ *
+ * stdin is switched to non-blocking mode and drained into a RAM ring by
+ * console_poll(), which never waits; it runs from the timer idle hook and
+ * from every console call.  Lines are assembled from the ring on demand, so
+ * the main loop can look for a command, find none, and go on with its other
+ * work.  A complete line can be split into whitespace-separated arguments
+ * and handed to a handler from a constant command table:
+ *
+ *   led 0x3ff
+ *   seg ECEN-723
+ *   bench uart 4096
+ *
+ * Backspace and DEL edit the line being assembled; '\r' is ignored.
+ *
+ ******************************************************************************/
+
+#ifndef __CONSOLE_H__
+#define __CONSOLE_H__
+
+#include "alt_types.h"
+
+/* Ring size; must be a power of two. */
+#define CONSOLE_RING_SIZE 256
+
+#define CONSOLE_LINE_MAX  128   /* longest line kept, terminator included */
+#define CONSOLE_MAX_ARGS  8
+
+/* console_get_line() result once stdin has ended (host build only) */
+#define CONSOLE_EOF       -2
+
+/* console_dispatch() results */
+#define CONSOLE_OK        0
+#define CONSOLE_EMPTY     1     /* blank line */
+#define CONSOLE_UNKNOWN   -1    /* no such command */
+#define CONSOLE_USAGE     -2    /* handler rejected its arguments */
+
+struct console_cmd
+{
+  const char* name;
+  const char* args;     /* argument synopsis for the help text */
+  const char* help;
+  /* Return CONSOLE_OK, or CONSOLE_USAGE to have the synopsis printed. */
+  int (*handler)( int argc, char** argv );
+};
+
+struct console_stats
+{
+  alt_u32 bytes;        /* bytes read from stdin */
+  alt_u32 lines;        /* complete lines handed out */
+  alt_u32 dropped;      /* bytes lost to a full ring */
+  alt_u32 truncated;    /* lines longer than CONSOLE_LINE_MAX - 1 */
+};
+
+/* Put stdin into non-blocking mode.  Returns 0, or -1 if that failed. */
+int console_init( void );
+
+/* Move whatever input has arrived into the ring.  Never waits. */
+void console_poll( void );
+
+/*
+ * If a complete line has arrived, copy it (without the newline, truncated
+ * to size - 1 and NUL-terminated) and return its length; otherwise return
+ * -1 at once.  Once stdin has ended and every line has been taken, returns
+ * CONSOLE_EOF; the JTAG UART never ends, but a redirected host stdin does.
+ */
+int console_get_line( char* buf, int size );
+
+/*
+ * As console_get_line(), but idles (timer_idle()) until a line arrives.
+ * Returns the length or CONSOLE_EOF.
+ */
+int console_read_line( char* buf, int size );
+
+/* Discard buffered input, including a partly typed line. */
+void console_flush( void );
+
+/*
+ * Split 'line' in place and run the matching handler from 'table'.  Returns
+ * one of the CONSOLE_ results; on CONSOLE_USAGE the synopsis was printed.
+ */
+int console_dispatch( char* line, const struct console_cmd* table, int count );
+
+/* Print one line per command in 'table'. */
+void console_help( const struct console_cmd* table, int count );
+
+/* Parse a decimal, 0x hex or 0 octal number; returns 0, or -1 if invalid. */
+int console_parse_u32( const char* text, alt_u32* out );
+
+void console_get_stats( struct console_stats* out );
+
+#endif /* __CONSOLE_H__ */
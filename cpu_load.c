@@ -0,0 +1,266 @@
+/******************************************************************************
+ *
+ * cpu_load.c
+ *
+ * CPU utilisation accounting.  See cpu_load.h.
+ *
+ * 'stamp' is the time the main-loop state was last charged up to and
+ * 'isr_stamp' the interrupt total at that moment; charging the state
+ * takes the interrupt time since then out of the elapsed time, so each
+ * cycle is counted once.  All of it is updated with interrupts disabled.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "fmt.h"
+#include "cpu_load.h"
+
+#define CPU_LOAD_WINDOW_TICKS (CPU_LOAD_WINDOW_MS * SYS_CLK_TIMER_TICKS_PER_SEC / 1000)
+
+static const char* const cpu_load_names[] = { "busy", "idle", "io_wait", "isr" };
+
+static int cpu_load_on;
+static int cpu_load_state;
+static alt_u64 cpu_load_stamp;
+static alt_u64 cpu_load_isr_total;
+static alt_u64 cpu_load_isr_stamp;
+static alt_u32 cpu_load_ticks;
+static volatile int cpu_load_roll;
+
+static struct cpu_load_sample cpu_load_cur;         /* the open window */
+static struct cpu_load_sample cpu_load_closed;      /* every closed window */
+static struct cpu_load_sample cpu_load_hist[CPU_LOAD_WINDOWS];
+static int cpu_load_head;                           /* next slot in the history */
+static int cpu_load_count;
+
+/* Charge the main-loop state with the time up to 'now'.  Interrupts off. */
+
+static void cpu_load_charge( alt_u64 now )
+{
+  alt_u64 span = now - cpu_load_stamp;
+  alt_u64 isr = cpu_load_isr_total - cpu_load_isr_stamp;
+
+  if (span > isr)
+  {
+    cpu_load_cur.cycles[cpu_load_state] += span - isr;
+  }
+  cpu_load_stamp = now;
+  cpu_load_isr_stamp = cpu_load_isr_total;
+}
+
+static void cpu_load_add( struct cpu_load_sample* to, const struct cpu_load_sample* s )
+{
+  int i;
+
+  for (i = 0; i < CPU_LOAD_STATES; i++)
+  {
+    to->cycles[i] += s->cycles[i];
+  }
+}
+
+/* Tick hook: ask the end of this interrupt to close the window. */
+
+static void cpu_load_tick( void* context )
+{
+  (void) context;
+  if (++cpu_load_ticks >= CPU_LOAD_WINDOW_TICKS)
+  {
+    cpu_load_ticks = 0;
+    cpu_load_roll = 1;
+  }
+}
+
+void cpu_load_init( void )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  cpu_load_state = CPU_LOAD_BUSY;
+  cpu_load_stamp = timer_now_cycles();
+  cpu_load_isr_stamp = cpu_load_isr_total;
+  cpu_load_on = 1;
+  alt_irq_enable_all(irq);
+  timer_add_tick_hook(cpu_load_tick, NULL);
+}
+
+int cpu_load_enter( int state )
+{
+  alt_irq_context irq;
+  int prev = cpu_load_state;
+
+  if (!cpu_load_on || state <= prev)
+  {
+    return prev;
+  }
+  irq = alt_irq_disable_all();
+  cpu_load_charge(timer_now_cycles());
+  cpu_load_state = state;
+  alt_irq_enable_all(irq);
+  return prev;
+}
+
+void cpu_load_leave( int prev )
+{
+  alt_irq_context irq;
+
+  if (!cpu_load_on || prev == cpu_load_state)
+  {
+    return;
+  }
+  irq = alt_irq_disable_all();
+  cpu_load_charge(timer_now_cycles());
+  cpu_load_state = prev;
+  alt_irq_enable_all(irq);
+}
+
+alt_u64 cpu_load_isr_begin( void )
+{
+  return timer_now_cycles();
+}
+
+void cpu_load_isr_end( alt_u64 begin )
+{
+  alt_u64 now = timer_now_cycles();
+
+  cpu_load_cur.cycles[CPU_LOAD_ISR] += now - begin;
+  cpu_load_isr_total += now - begin;
+  if (cpu_load_roll && cpu_load_on)
+  {
+    cpu_load_roll = 0;
+    cpu_load_charge(now);
+    cpu_load_hist[cpu_load_head] = cpu_load_cur;
+    cpu_load_head = (cpu_load_head + 1) % CPU_LOAD_WINDOWS;
+    if (cpu_load_count < CPU_LOAD_WINDOWS)
+    {
+      cpu_load_count++;
+    }
+    cpu_load_add(&cpu_load_closed, &cpu_load_cur);
+    memset(&cpu_load_cur, 0, sizeof(cpu_load_cur));
+  }
+}
+
+void cpu_load_total( struct cpu_load_sample* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  if (cpu_load_on)
+  {
+    cpu_load_charge(timer_now_cycles());
+  }
+  *out = cpu_load_closed;
+  cpu_load_add(out, &cpu_load_cur);
+  alt_irq_enable_all(irq);
+}
+
+int cpu_load_recent( int windows, struct cpu_load_sample* out )
+{
+  alt_irq_context irq;
+  int i;
+
+  memset(out, 0, sizeof(*out));
+  irq = alt_irq_disable_all();
+  if (windows > cpu_load_count)
+  {
+    windows = cpu_load_count;
+  }
+  for (i = 1; i <= windows; i++)
+  {
+    cpu_load_add(out, &cpu_load_hist[(cpu_load_head + CPU_LOAD_WINDOWS - i) % CPU_LOAD_WINDOWS]);
+  }
+  alt_irq_enable_all(irq);
+  return windows;
+}
+
+void cpu_load_diff( const struct cpu_load_sample* a, const struct cpu_load_sample* b,
+                    struct cpu_load_sample* out )
+{
+  int i;
+
+  for (i = 0; i < CPU_LOAD_STATES; i++)
+  {
+    out->cycles[i] = b->cycles[i] - a->cycles[i];
+  }
+}
+
+alt_u64 cpu_load_cycles( const struct cpu_load_sample* s )
+{
+  alt_u64 sum = 0;
+  int i;
+
+  for (i = 0; i < CPU_LOAD_STATES; i++)
+  {
+    sum += s->cycles[i];
+  }
+  return sum;
+}
+
+alt_u32 cpu_load_permille( const struct cpu_load_sample* s, int state )
+{
+  alt_u64 sum = cpu_load_cycles(s);
+
+  if (sum == 0)
+  {
+    return 0;
+  }
+  return (alt_u32)((s->cycles[state] * 1000 + sum / 2) / sum);
+}
+
+const char* cpu_load_state_name( int state )
+{
+  if (state < 0 || state >= CPU_LOAD_STATES)
+  {
+    return NULL;
+  }
+  return cpu_load_names[state];
+}
+
+void cpu_load_print( const char* span, const struct cpu_load_sample* s )
+{
+  alt_u32 per_ms = timer_cycles_per_us() * 1000;
+  alt_u32 pm;
+  int i;
+
+  fmt_print("BENCH cpu_load span=%s ms=%lu", span,
+    (unsigned long)((cpu_load_cycles(s) + per_ms / 2) / per_ms));
+  for (i = 0; i < CPU_LOAD_STATES; i++)
+  {
+    pm = cpu_load_permille(s, i);
+    fmt_print(" %s=%lu.%lu", cpu_load_names[i], (unsigned long)(pm / 10),
+      (unsigned long)(pm % 10));
+  }
+  fmt_putc('\n');
+}
+
+void cpu_load_report( void )
+{
+  static const struct
+  {
+    const char* span;
+    int windows;
+  } spans[] =
+  {
+    { "window", 1 },
+    { "1s",     1000 / CPU_LOAD_WINDOW_MS },
+    { "5s",     5000 / CPU_LOAD_WINDOW_MS },
+  };
+  struct cpu_load_sample s;
+  int i;
+
+  for (i = 0; i < (int)(sizeof(spans) / sizeof(spans[0])); i++)
+  {
+    if (cpu_load_recent(spans[i].windows, &s) > 0)
+    {
+      cpu_load_print(spans[i].span, &s);
+    }
+  }
+  cpu_load_total(&s);
+  cpu_load_print("all", &s);
+  fmt_flush();
+}
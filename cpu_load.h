@@ -0,0 +1,92 @@
+/******************************************************************************
+ *
+ * cpu_load.h
+ *
+ * Where the CPU's time goes: busy, idle, waiting on I/O or in interrupt
+ * handlers, measured with timer_now_cycles().
+ *
+ * Main-loop time is in one of three states, set by the code that knows:
+ *
+ *   idle     timer_idle() and the timer service's delays; the idle hook's
+ *            polling of the UART and the console counts as idle, since
+ *            Nios II has no wait-for-interrupt to do instead
+ *   io_wait  blocked on a device: uart_tx stalls and flushes, stdout and
+ *            LCD flushes, lcd_16207's busy-flag polls, the UART
+ *            benchmark's transfers
+ *   busy     everything else
+ *
+ * A wait that idles counts as I/O wait: entering a state only takes effect
+ * when it outranks the current one (busy < idle < io_wait).  Interrupt
+ * handlers bracketed with cpu_load_isr_begin() and cpu_load_isr_end() (the
+ * system clock tick with all its hooks, and the input PIO interrupt) count
+ * as isr and are taken out of the state they interrupted.  The HAL's JTAG
+ * UART interrupt is not bracketed and counts toward the state it
+ * interrupts.
+ *
+ * Time is collected in windows of CPU_LOAD_WINDOW_MS, closed from the
+ * tick; the last CPU_LOAD_WINDOWS are kept for rolling figures, and the
+ * totals since start-up.
+ *
+ ******************************************************************************/
+
+#ifndef __CPU_LOAD_H__
+#define __CPU_LOAD_H__
+
+#include "alt_types.h"
+
+#define CPU_LOAD_BUSY     0
+#define CPU_LOAD_IDLE     1
+#define CPU_LOAD_IO_WAIT  2
+#define CPU_LOAD_ISR      3
+#define CPU_LOAD_STATES   4
+
+#define CPU_LOAD_WINDOW_MS  100
+#define CPU_LOAD_WINDOWS    50
+
+struct cpu_load_sample
+{
+  alt_u64 cycles[CPU_LOAD_STATES];
+};
+
+/* Start accounting, in the busy state.  Call once right after timer_init(). */
+void cpu_load_init( void );
+
+/*
+ * Main loop only: enter 'state' (idle or io_wait) and return the state to
+ * hand back to cpu_load_leave() when the wait is over.
+ */
+int cpu_load_enter( int state );
+void cpu_load_leave( int prev );
+
+/* Interrupt handlers: bracket the handler's body. */
+alt_u64 cpu_load_isr_begin( void );
+void cpu_load_isr_end( alt_u64 begin );
+
+/* Cycles in each state since cpu_load_init(), up to now. */
+void cpu_load_total( struct cpu_load_sample* out );
+
+/*
+ * Cycles in each state over the last 'windows' closed windows.  Returns
+ * how many there were, fewer than asked for shortly after start-up.
+ */
+int cpu_load_recent( int windows, struct cpu_load_sample* out );
+
+/* 'b' minus 'a', for a span measured between two cpu_load_total() calls. */
+void cpu_load_diff( const struct cpu_load_sample* a, const struct cpu_load_sample* b,
+                    struct cpu_load_sample* out );
+
+alt_u64 cpu_load_cycles( const struct cpu_load_sample* s );
+
+/* A state's share of 's' in tenths of a percent. */
+alt_u32 cpu_load_permille( const struct cpu_load_sample* s, int state );
+
+/* "busy", "idle", "io_wait" or "isr". */
+const char* cpu_load_state_name( int state );
+
+/* One BENCH line for 's', labelled 'span'. */
+void cpu_load_print( const char* span, const struct cpu_load_sample* s );
+
+/* BENCH lines for the last window, second and five seconds, and the total. */
+void cpu_load_report( void );
+
+#endif /* __CPU_LOAD_H__ */
@@ -0,0 +1,294 @@
+/******************************************************************************
+ *
+ * fmt.c
+ *
+ * Small formatter without newlib's printf.  See fmt.h.
+ *
+ * Both entry points run the same converter into a bounded buffer: the
+ * caller's for fmt_format(), or the line buffer, which is queued on the
+ * UART ring at every newline and whenever it fills, for fmt_print().
+ * Numbers are converted right to left into a 12-byte scratch array.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "alt_types.h"
+
+#include "uart_tx.h"
+#include "cpu_load.h"
+#include "fmt.h"
+
+#define FMT_LEFT  1
+#define FMT_ZERO  2
+
+struct fmt_out
+{
+  char* buf;
+  int len;
+  int size;
+  int line;             /* the line buffer: queue it instead of truncating */
+};
+
+static char fmt_line[FMT_LINE_SIZE];
+static struct fmt_out fmt_stdout = { fmt_line, 0, FMT_LINE_SIZE, 1 };
+static int fmt_active;  /* something was queued since the last fmt_flush() */
+
+static const char fmt_lower[] = "0123456789abcdef";
+static const char fmt_upper[] = "0123456789ABCDEF";
+
+static void fmt_queue( struct fmt_out* o )
+{
+  if (!fmt_active)
+  {
+    fflush(stdout);
+    fmt_active = 1;
+  }
+  if (uart_tx_write(o->buf, o->len) < 0)
+  {
+    fwrite(o->buf, 1, o->len, stdout);
+  }
+  o->len = 0;
+}
+
+static void fmt_put( struct fmt_out* o, char c )
+{
+  if (o->len == o->size)
+  {
+    if (!o->line)
+    {
+      return;
+    }
+    fmt_queue(o);
+  }
+  o->buf[o->len++] = c;
+  if (c == '\n' && o->line)
+  {
+    fmt_queue(o);
+  }
+}
+
+static void fmt_pad( struct fmt_out* o, char c, int n )
+{
+  while (n-- > 0)
+  {
+    fmt_put(o, c);
+  }
+}
+
+/* 'n' characters of 's' in a field of 'width'. */
+static void fmt_field( struct fmt_out* o, const char* s, int n, int width, int flags )
+{
+  int fill = width > n ? width - n : 0;
+
+  if (!(flags & FMT_LEFT))
+  {
+    if ((flags & FMT_ZERO) && n > 0 && *s == '-')
+    {
+      fmt_put(o, *s++);
+      n--;
+    }
+    fmt_pad(o, (flags & FMT_ZERO) ? '0' : ' ', fill);
+  }
+  while (n-- > 0)
+  {
+    fmt_put(o, *s++);
+  }
+  if (flags & FMT_LEFT)
+  {
+    fmt_pad(o, ' ', fill);
+  }
+}
+
+/* Digits of 'v' ending at 'end'; returns where they start. */
+static char* fmt_number( char* end, alt_u32 v, alt_u32 base, const char* digits )
+{
+  do
+  {
+    *--end = digits[v % base];
+    v /= base;
+  }
+  while (v != 0);
+  return end;
+}
+
+static void fmt_emit( struct fmt_out* o, const char* f, va_list ap )
+{
+  char num[12];
+  char* end = num + sizeof(num);
+  const char* s;
+  char* p;
+  alt_u32 u;
+  int flags, width, is_long;
+  char c;
+
+  while ((c = *f++) != '\0')
+  {
+    if (c != '%')
+    {
+      fmt_put(o, c);
+      continue;
+    }
+
+    flags = 0;
+    for (;; f++)
+    {
+      if (*f == '-')
+        flags |= FMT_LEFT;
+      else if (*f == '0')
+        flags |= FMT_ZERO;
+      else
+        break;
+    }
+    width = 0;
+    if (*f == '*')
+    {
+      width = va_arg(ap, int);
+      if (width < 0)
+      {
+        flags |= FMT_LEFT;
+        width = -width;
+      }
+      f++;
+    }
+    while (*f >= '0' && *f <= '9')
+    {
+      width = width * 10 + (*f++ - '0');
+    }
+    is_long = 0;
+    while (*f == 'l')
+    {
+      is_long = 1;
+      f++;
+    }
+    if (flags & FMT_LEFT)
+    {
+      flags &= ~FMT_ZERO;
+    }
+
+    switch (c = *f++)
+    {
+      case 'c':
+        num[0] = (char) va_arg(ap, int);
+        fmt_field(o, num, 1, width, flags & FMT_LEFT);
+        break;
+      case 's':
+        s = va_arg(ap, const char*);
+        if (s == NULL)
+        {
+          s = "(null)";
+        }
+        fmt_field(o, s, strlen(s), width, flags & FMT_LEFT);
+        break;
+      case 'd':
+      case 'i':
+        u = is_long ? (alt_u32) va_arg(ap, long) : (alt_u32) va_arg(ap, int);
+        if ((alt_32) u < 0)
+        {
+          p = fmt_number(end, -u, 10, fmt_lower);
+          *--p = '-';
+        }
+        else
+        {
+          p = fmt_number(end, u, 10, fmt_lower);
+        }
+        fmt_field(o, p, end - p, width, flags);
+        break;
+      case 'u':
+      case 'x':
+      case 'X':
+        u = is_long ? (alt_u32) va_arg(ap, unsigned long) : va_arg(ap, unsigned int);
+        p = fmt_number(end, u, c == 'u' ? 10 : 16, c == 'X' ? fmt_upper : fmt_lower);
+        fmt_field(o, p, end - p, width, flags);
+        break;
+      case '\0':
+        return;
+      default:
+        /* %% and anything unknown come out as the character itself. */
+        fmt_put(o, c);
+        break;
+    }
+  }
+}
+
+void fmt_vprint( const char* format, va_list ap )
+{
+  fmt_emit(&fmt_stdout, format, ap);
+}
+
+void fmt_print( const char* format, ... )
+{
+  va_list ap;
+
+  va_start(ap, format);
+  fmt_emit(&fmt_stdout, format, ap);
+  va_end(ap);
+}
+
+void fmt_putc( char c )
+{
+  fmt_put(&fmt_stdout, c);
+}
+
+void fmt_puts( const char* s )
+{
+  while (*s != '\0')
+  {
+    fmt_put(&fmt_stdout, *s++);
+  }
+}
+
+void fmt_write( const char* buf, int len )
+{
+  struct fmt_out o = { (char*) buf, len, len, 1 };
+
+  if (fmt_stdout.len > 0)
+  {
+    fmt_queue(&fmt_stdout);
+  }
+  fmt_queue(&o);
+}
+
+void fmt_flush( void )
+{
+  int prev;
+
+  if (fmt_stdout.len > 0)
+  {
+    fmt_queue(&fmt_stdout);
+  }
+  prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+  uart_tx_flush();
+  fflush(stdout);
+  cpu_load_leave(prev);
+  fmt_active = 0;
+}
+
+int fmt_vformat( char* buf, int size, const char* format, va_list ap )
+{
+  struct fmt_out o;
+
+  if (size <= 0)
+  {
+    return 0;
+  }
+  o.buf = buf;
+  o.len = 0;
+  o.size = size - 1;
+  o.line = 0;
+  fmt_emit(&o, format, ap);
+  buf[o.len] = '\0';
+  return o.len;
+}
+
+int fmt_format( char* buf, int size, const char* format, ... )
+{
+  va_list ap;
+  int len;
+
+  va_start(ap, format);
+  len = fmt_vformat(buf, size, format, ap);
+  va_end(ap);
+  return len;
+}
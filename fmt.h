@@ -0,0 +1,54 @@
+/******************************************************************************
+ *
+ * fmt.h
+ *
+ * Small formatter for menus and reports, without newlib's printf.
+ *
+ * fmt_print() formats into a fixed line buffer and queues each completed
+ * line on the JTAG UART ring (uart_tx.h) in one piece; nothing is
+ * allocated and no stdio buffer is involved.  fmt_format() formats into a
+ * caller's buffer instead, like snprintf().
+ *
+ * Conversions: %c %s %d %i %u %x %X %%, with the '-' (left justify) and
+ * '0' (zero pad) flags and a field width, or '*' to take the width from an
+ * int argument.  An 'l' length takes a long argument, as the existing
+ * printf() calls pass them; values are 32 bits either way.  There is no
+ * precision and no floating point.
+ *
+ * Output through fmt and through stdio go to the same device by different
+ * routes.  The first fmt_print() after a flush flushes stdout, so what
+ * printf() wrote earlier comes out first; call fmt_flush() before going
+ * back to printf(), and before waiting for input after a prompt that does
+ * not end in a newline.
+ *
+ ******************************************************************************/
+
+#ifndef __FMT_H__
+#define __FMT_H__
+
+#include <stdarg.h>
+
+#include "alt_types.h"
+
+/* Longest line queued in one piece; longer lines are queued in parts. */
+#define FMT_LINE_SIZE 128
+
+void fmt_print( const char* format, ... );
+void fmt_vprint( const char* format, va_list ap );
+void fmt_putc( char c );
+void fmt_puts( const char* s );
+
+/* Queue 'len' bytes in one piece, after any partial line. */
+void fmt_write( const char* buf, int len );
+
+/* Queue the partial line and wait until the ring has gone to the driver. */
+void fmt_flush( void );
+
+/*
+ * Format into 'buf', truncating to 'size' - 1 characters plus the NUL.
+ * Returns the length written.
+ */
+int fmt_format( char* buf, int size, const char* format, ... );
+int fmt_vformat( char* buf, int size, const char* format, va_list ap );
+
+#endif /* __FMT_H__ */
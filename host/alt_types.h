@@ -0,0 +1,24 @@
+/*
+ * alt_types.h - host stand-in for the Nios II HAL alt_types.h.
+ *
+ * The HAL fixes alt_32/alt_u32 at 32 bits; on an LP64 host that means int,
+ * not long.
+ */
+
+#ifndef __ALT_TYPES_H__
+#define __ALT_TYPES_H__
+
+typedef signed char        alt_8;
+typedef unsigned char      alt_u8;
+typedef signed short       alt_16;
+typedef unsigned short     alt_u16;
+typedef signed int         alt_32;
+typedef unsigned int       alt_u32;
+typedef long long          alt_64;
+typedef unsigned long long alt_u64;
+
+#define ALT_INLINE        __inline__
+#define ALT_ALWAYS_INLINE __attribute__ ((always_inline))
+#define ALT_WEAK          __attribute__((weak))
+
+#endif /* __ALT_TYPES_H__ */
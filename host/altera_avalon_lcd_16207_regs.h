@@ -0,0 +1,28 @@
+/*
+ * altera_avalon_lcd_16207_regs.h - host stand-in for the LCD controller's
+ * register map.
+ *
+ * Same register layout and accessor names as the HAL driver header.
+ */
+
+#ifndef __ALTERA_AVALON_LCD_16207_REGS_H__
+#define __ALTERA_AVALON_LCD_16207_REGS_H__
+
+#include <io.h>
+
+#define IOADDR_ALTERA_AVALON_LCD_16207_COMMAND(base)      __IO_CALC_ADDRESS_NATIVE(base, 0)
+#define IOWR_ALTERA_AVALON_LCD_16207_COMMAND(base, data)  IOWR(base, 0, data)
+
+#define IOADDR_ALTERA_AVALON_LCD_16207_STATUS(base)       __IO_CALC_ADDRESS_NATIVE(base, 1)
+#define IORD_ALTERA_AVALON_LCD_16207_STATUS(base)         IORD(base, 1)
+
+#define ALTERA_AVALON_LCD_16207_STATUS_BUSY_MSK           (0x00000080)
+#define ALTERA_AVALON_LCD_16207_STATUS_BUSY_OFST          (7)
+
+#define IOADDR_ALTERA_AVALON_LCD_16207_DATA_WR(base)      __IO_CALC_ADDRESS_NATIVE(base, 2)
+#define IOWR_ALTERA_AVALON_LCD_16207_DATA(base, data)     IOWR(base, 2, data)
+
+#define IOADDR_ALTERA_AVALON_LCD_16207_DATA_RD(base)      __IO_CALC_ADDRESS_NATIVE(base, 3)
+#define IORD_ALTERA_AVALON_LCD_16207_DATA(base)           IORD(base, 3)
+
+#endif /* __ALTERA_AVALON_LCD_16207_REGS_H__ */
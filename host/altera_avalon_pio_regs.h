@@ -0,0 +1,40 @@
+/*
+ * altera_avalon_pio_regs.h - host stand-in for the PIO register map.
+ *
+ * Same register layout and accessor names as the HAL driver header.
+ */
+
+#ifndef __ALTERA_AVALON_PIO_REGS_H__
+#define __ALTERA_AVALON_PIO_REGS_H__
+
+#include <io.h>
+
+#define IOADDR_ALTERA_AVALON_PIO_DATA(base)           __IO_CALC_ADDRESS_NATIVE(base, 0)
+#define IORD_ALTERA_AVALON_PIO_DATA(base)             IORD(base, 0)
+#define IOWR_ALTERA_AVALON_PIO_DATA(base, data)       IOWR(base, 0, data)
+
+#define IOADDR_ALTERA_AVALON_PIO_DIRECTION(base)      __IO_CALC_ADDRESS_NATIVE(base, 1)
+#define IORD_ALTERA_AVALON_PIO_DIRECTION(base)        IORD(base, 1)
+#define IOWR_ALTERA_AVALON_PIO_DIRECTION(base, data)  IOWR(base, 1, data)
+
+#define IOADDR_ALTERA_AVALON_PIO_IRQ_MASK(base)       __IO_CALC_ADDRESS_NATIVE(base, 2)
+#define IORD_ALTERA_AVALON_PIO_IRQ_MASK(base)         IORD(base, 2)
+#define IOWR_ALTERA_AVALON_PIO_IRQ_MASK(base, data)   IOWR(base, 2, data)
+
+#define IOADDR_ALTERA_AVALON_PIO_EDGE_CAP(base)       __IO_CALC_ADDRESS_NATIVE(base, 3)
+#define IORD_ALTERA_AVALON_PIO_EDGE_CAP(base)         IORD(base, 3)
+#define IOWR_ALTERA_AVALON_PIO_EDGE_CAP(base, data)   IOWR(base, 3, data)
+
+#define IOADDR_ALTERA_AVALON_PIO_SET_BIT(base)        __IO_CALC_ADDRESS_NATIVE(base, 4)
+#define IORD_ALTERA_AVALON_PIO_SET_BITS(base)         IORD(base, 4)
+#define IOWR_ALTERA_AVALON_PIO_SET_BITS(base, data)   IOWR(base, 4, data)
+
+#define IOADDR_ALTERA_AVALON_PIO_CLEAR_BITS(base)     __IO_CALC_ADDRESS_NATIVE(base, 5)
+#define IORD_ALTERA_AVALON_PIO_CLEAR_BITS(base)       IORD(base, 5)
+#define IOWR_ALTERA_AVALON_PIO_CLEAR_BITS(base, data) IOWR(base, 5, data)
+
+/* Definitions for direction-register operation with bi-directional PIOs */
+#define ALTERA_AVALON_PIO_DIRECTION_INPUT  0
+#define ALTERA_AVALON_PIO_DIRECTION_OUTPUT 1
+
+#endif /* __ALTERA_AVALON_PIO_REGS_H__ */
@@ -0,0 +1,1840 @@
+/*
+ * host_hal.c - simulated Nios II HAL backend for the Linux host build.
+ *
+ * See host_hal.h for the overview and the environment variables.
+ *
+ * Time model
+ * **********
+ * host_cycles counts CPU clock cycles (ALT_CPU_FREQ).  Every IORD/IOWR
+ * charges host_bus_cycles, usleep() charges its full duration, and the clock
+ * is stepped from one scripted input event to the next so interrupts are
+ * delivered at the virtual time they would occur on the board.
+ *
+ * sys_clk_timer is modelled as the HAL leaves it after alt_sys_init(): running
+ * continuously with the period from system.h and its interrupt enabled.
+ * host_hal.c also stands in for the HAL's system clock driver, counting
+ * _alt_nticks and running alt_alarm callbacks on every timeout.
+ *
+ * Code that spins on a variable written by an ISR (TestButtons waits on the
+ * input event queue) never touches the bus, so a 1 ms wall-clock SIGALRM advances
+ * the virtual clock by one idle quantum whenever it has not moved since the
+ * previous alarm.  Code that polls the hardware is therefore fully
+ * deterministic; pure spin loops are paced by wall-clock time.
+ *
+ * JTAG UART
+ * *********
+ * open(JTAG_UART_NAME) returns a simulated descriptor standing in for the
+ * HAL's interrupt-driven altera_avalon_jtag_uart driver: a software buffer of
+ * HOST_UART_BUF_LEN bytes in front of the WRITE_DEPTH hardware FIFO, drained
+ * to the host at $BOARD_DIAG_UART_BPS bytes per second of virtual time.
+ * Without a loopback the bytes are copied to stdout as they are written, so
+ * they stay in order with the firmware's printf output; only the buffer
+ * occupancy follows the link speed.  With $BOARD_DIAG_UART_LOOPBACK set,
+ * drained bytes come back on the read side instead (and stall the drain
+ * when the read buffers are full), so the TX and RX paths can be measured
+ * without a cable.  With $BOARD_DIAG_UART_PTY set, the far end is a Linux
+ * pseudo-terminal instead of stdout: the slave is symlinked to that path for
+ * a peer such as tools/uart_peer.py, and bytes the peer sends are charged
+ * the same link time on the way in.
+ *
+ * On-chip memory
+ * **************
+ * onchip_mem is a malloc'd array behind IORD_32DIRECT/IOWR_32DIRECT, each
+ * access charged like a register access.  $BOARD_DIAG_MEM_FAULTS injects
+ * faults for the memory tests to find, as a comma-separated list of:
+ *
+ *   sa0:<addr>:<bit>          bit stuck at 0
+ *   sa1:<addr>:<bit>          bit stuck at 1
+ *   ad:<bit>                  address line <bit> stuck at 0 (aliasing)
+ *   cf:<addr>:<bit>:<addr>:<bit>
+ *                             inversion coupling: a transition of the first
+ *                             bit flips the second
+ *
+ * Bit flips
+ * *********
+ * $BOARD_DIAG_BIT_FLIPS stands in for a register path that fails timing, as
+ * a comma-separated list of <device>:w:<n> or <device>:r:<n>, for PIOs
+ * only.  On average one in <n> accesses to the PIO's data register
+ * (register 0) gets one random bit inverted within the PIO's width: on 'w'
+ * the register latches the wrong value, on 'r' only the value read is
+ * wrong.  The sequence is pseudo-random with a fixed seed, so runs repeat.
+ *
+ * LCD
+ * ***
+ * lcd_display's registers front a model of its HD44780 controller: DDRAM
+ * and CGRAM behind one address counter, and a busy flag that stays up for
+ * HOST_HD_EXEC_US after each instruction or data transfer and
+ * HOST_HD_CLEAR_US after a clear or return home.  An access made while it
+ * is up is counted and ignored, as the text it would have written is lost
+ * on the board.  fopen(LCD_DISPLAY_NAME) returns a stream standing in for
+ * the HAL's altera_avalon_lcd_16207 driver, which keeps its own copy of
+ * the text, repaints the characters that changed after each write() and
+ * polls the busy flag, then sleeps HOST_HD_HAL_SLEEP_US, before every
+ * register write.  Both paths end up in the same controller model, so the
+ * stats show what the glass would show.
+ *
+ * Output log
+ * **********
+ * $BOARD_DIAG_PIO_LOG names a file that gets one line per write to the
+ * data, set or clear register of an output PIO:
+ *
+ *   <cycle> <device> 0x<value>
+ *
+ * with the CPU cycle of the write and the value the PIO then drives, so a
+ * test can check the exact sequence and timing of what reached the LEDs
+ * and digits (tools/red_count_check.py does this for the red LED counter).
+ */
+
+#include "host_hal.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <termios.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "system.h"
+#include "io.h"
+#include "sys/alt_irq.h"
+#include "sys/alt_alarm.h"
+#include "altera_avalon_timer_regs.h"
+
+#undef usleep
+#undef fopen
+#undef getc
+#undef open
+#undef read
+#undef write
+#undef close
+
+#define HOST_REGS          8
+#define HOST_MAX_IRQ       32
+#define HOST_CYCLES_PER_US (ALT_CPU_FREQ / 1000000)
+#define HOST_IDLE_QUANTUM  (1000 * HOST_CYCLES_PER_US)
+#define HOST_IRQ_RETRIGGER 16
+
+/* Idle levels of the input PIOs: KEY[3:0] are active-low pushbuttons. */
+#define HOST_KEY_IDLE      0xf
+#define HOST_BUTTON_IDLE   0x0
+
+enum host_kind
+{
+  HOST_PIO_IN,
+  HOST_PIO_OUT,
+  HOST_TIMER,
+  HOST_LCD,
+  HOST_PLAIN
+};
+
+#define HOST_IS_PIO(dev) ((dev)->kind == HOST_PIO_IN || (dev)->kind == HOST_PIO_OUT)
+
+struct host_dev
+{
+  const char* name;
+  alt_u32 base;
+  alt_u32 span;
+  int kind;
+  alt_u32 mask;
+  int capture;
+  int irq;
+  alt_u32 regs[HOST_REGS];
+  alt_u32 reads[HOST_REGS];
+  alt_u32 writes[HOST_REGS];
+  alt_u32 same_writes;
+  alt_u32 flip_w_every; /* $BOARD_DIAG_BIT_FLIPS, 0 for none */
+  alt_u32 flip_r_every;
+  alt_u32 flips;
+};
+
+#define HOST_WIDTH_MASK(w) ((alt_u32)((1ULL << (w)) - 1))
+
+#define HOST_PIO(n, prefix, k, idle) \
+  { .name = n, .base = prefix##_BASE, .span = prefix##_SPAN, .kind = k, \
+    .mask = HOST_WIDTH_MASK(prefix##_DATA_WIDTH), \
+    .capture = prefix##_CAPTURE, .irq = prefix##_IRQ, .regs = { idle } }
+
+#define HOST_DEV(n, prefix, i) \
+  { .name = n, .base = prefix##_BASE, .span = prefix##_SPAN, \
+    .kind = HOST_PLAIN, .mask = 0xffffffff, .irq = i }
+
+static struct host_dev host_devs[] =
+{
+#ifdef KEY_BASE
+  HOST_PIO("key", KEY, HOST_PIO_IN, HOST_KEY_IDLE),
+#endif
+#ifdef BUTTON_PIO_BASE
+  HOST_PIO("button_pio", BUTTON_PIO, HOST_PIO_IN, HOST_BUTTON_IDLE),
+#endif
+#ifdef LED_PIO_BASE
+  HOST_PIO("led_pio", LED_PIO, HOST_PIO_OUT, 0),
+#endif
+#ifdef RED_LED_BASE
+  HOST_PIO("red_led", RED_LED, HOST_PIO_OUT, 0),
+#endif
+#ifdef SEVEN_SEG_PIO_BASE
+  HOST_PIO("seven_seg_pio", SEVEN_SEG_PIO, HOST_PIO_OUT, 0),
+#endif
+#ifdef SEVEN_SEG_PIO_1_BASE
+  HOST_PIO("seven_seg_pio_1", SEVEN_SEG_PIO_1, HOST_PIO_OUT, 0),
+#endif
+#ifdef SYS_CLK_TIMER_BASE
+  { .name = "sys_clk_timer", .base = SYS_CLK_TIMER_BASE,
+    .span = SYS_CLK_TIMER_SPAN, .kind = HOST_TIMER, .mask = 0xffff,
+    .irq = SYS_CLK_TIMER_IRQ },
+#endif
+#ifdef LCD_DISPLAY_BASE
+  { .name = "lcd_display", .base = LCD_DISPLAY_BASE, .span = LCD_DISPLAY_SPAN,
+    .kind = HOST_LCD, .mask = 0xff, .irq = -1 },
+#endif
+#ifdef SYSID_BASE
+  HOST_DEV("sysid", SYSID, -1),
+#endif
+#ifdef JTAG_UART_BASE
+  HOST_DEV("jtag_uart", JTAG_UART, JTAG_UART_IRQ),
+#endif
+};
+
+#define HOST_NUM_DEVS ((int)(sizeof(host_devs) / sizeof(host_devs[0])))
+
+struct host_event
+{
+  alt_u64 cycle;
+  struct host_dev* dev;
+  alt_u32 value;
+};
+
+struct host_isr
+{
+  alt_isr_func isr;
+  void* context;
+  int enabled;
+};
+
+/* Interval timer model (32-bit counter, snapshot). */
+
+struct host_timer
+{
+  struct host_dev* dev;
+  alt_u32 period;       /* cycles between timeouts: period register + 1 */
+  alt_u32 held;         /* counter value while stopped */
+  alt_u32 snap;
+  alt_u64 start;        /* cycle at which the counter last held period - 1 */
+  alt_u64 next_to;      /* cycle of the next timeout while running */
+  int running;
+  int to;
+};
+
+/* LCD character device model: the HAL driver's 2x40 text and escape parser. */
+
+#define HOST_LCD_ROWS  2
+#define HOST_LCD_COLS  40
+#define HOST_LCD_SHOWN 16
+
+struct host_lcd
+{
+  char ddram[HOST_LCD_ROWS][HOST_LCD_COLS];
+  char shown[HOST_LCD_ROWS][HOST_LCD_SHOWN];    /* what the driver last sent */
+  int addr;                                     /* where it left the cursor */
+  int x, y;
+  int esc;
+  char esc_buf[16];
+  int esc_len;
+  alt_u32 opens;
+  alt_u32 closes;
+  alt_u32 bytes;
+  alt_u32 writes;       /* stream buffer flushes that reached the driver */
+  alt_u32 max_write;
+};
+
+/* HD44780 controller model behind the lcd_display registers. */
+
+#define HOST_HD_DDRAM        0x80
+#define HOST_HD_CGRAM        0x40
+#define HOST_HD_BUSY         0x80
+#define HOST_HD_EXEC_US      37         /* most instructions, data transfers */
+#define HOST_HD_CLEAR_US     1520       /* clear display, return home */
+#define HOST_HD_HAL_SLEEP_US 100        /* the HAL driver's sleep after busy clears */
+
+struct host_hd
+{
+  alt_u8 ddram[HOST_HD_DDRAM];
+  alt_u8 cgram[HOST_HD_CGRAM];
+  int ac;               /* address counter */
+  int cg;               /* the counter points into CGRAM */
+  int dec;              /* entry mode moves the cursor left */
+  int on;               /* display on */
+  alt_u64 busy_until;
+  alt_u64 busy_cycles;
+  alt_u32 commands;
+  alt_u32 data_writes;
+  alt_u32 data_reads;
+  alt_u32 busy_reads;   /* status reads that saw the busy flag */
+  alt_u32 overruns;     /* accesses while busy, ignored */
+};
+
+/* On-chip memory model with injected faults. */
+
+#define HOST_MEM_MAX_FAULTS 16
+
+#define HOST_MEM_SA0 0
+#define HOST_MEM_SA1 1
+#define HOST_MEM_CF  2
+
+struct host_mem_fault
+{
+  int kind;
+  alt_u32 word;         /* word index of the faulty (or aggressor) cell */
+  alt_u32 bit;
+  alt_u32 victim;       /* coupling: word index and bit of the victim */
+  alt_u32 victim_bit;
+};
+
+struct host_mem
+{
+  alt_u32* words;
+  alt_u32 ad_mask;      /* byte offset bits forced to 0 by 'ad' faults */
+  struct host_mem_fault faults[HOST_MEM_MAX_FAULTS];
+  int num_faults;
+  alt_u32 reads;
+  alt_u32 writes;
+};
+
+/* JTAG UART character device model. */
+
+#define HOST_UART_FD       1000
+#define HOST_UART_BUF_LEN  2048         /* ALTERA_AVALON_JTAG_UART_BUF_LEN */
+#define HOST_UART_TX_CAP   (HOST_UART_BUF_LEN + JTAG_UART_WRITE_DEPTH)
+#define HOST_UART_RX_CAP   (HOST_UART_BUF_LEN + JTAG_UART_READ_DEPTH)
+#define HOST_UART_CALL_CYCLES 100       /* driver entry and exit */
+#define HOST_UART_BYTE_CYCLES 4         /* copy into the driver buffer */
+#define HOST_UART_PTY_WAIT_MS 50        /* wall time granted a silent peer */
+
+struct host_uart
+{
+  char tx[HOST_UART_TX_CAP];
+  char rx[HOST_UART_RX_CAP];
+  alt_u32 tx_head, tx_len;
+  alt_u32 rx_head, rx_len;
+  alt_u64 drained_at;   /* cycle the last byte left the TX side */
+  alt_u64 bps;
+  int loopback;
+  int pty;              /* pseudo-terminal master, or -1 */
+  int nonblock;
+  alt_u32 opens;
+  alt_u32 tx_bytes;
+  alt_u32 rx_bytes;
+  alt_u32 would_block;
+};
+
+static alt_u64 host_cycles;
+static alt_u64 host_bus_cycles = 6;
+static alt_u64 host_limit_cycles;
+static struct timespec host_wall_start;
+
+static struct host_event* host_script;
+static int host_script_len;
+static int host_script_cap;
+static int host_script_next;
+
+static struct host_isr host_isrs[HOST_MAX_IRQ];
+static int host_irq_disabled;
+
+static struct host_lcd host_lcd;
+static struct host_hd host_hd;
+static struct host_mem host_mem;
+static struct host_uart host_uart = { .bps = 100000, .pty = -1 };
+static struct host_timer host_timer;
+static alt_alarm* host_alarms;
+
+volatile alt_u32 _alt_tick_rate;
+volatile alt_u32 _alt_nticks;
+
+static volatile sig_atomic_t host_in_hal;
+static volatile sig_atomic_t host_in_isr;
+static alt_u64 host_alarm_seen;
+static alt_u64 host_isr_cycles;  /* charged inside an ISR */
+static int host_stats;
+static int host_stdin_flags;     /* stdin file status flags at start-up */
+static alt_u64 host_flip_rng = 0x2545f4914f6cdd1dULL;
+static FILE* host_pio_log;
+
+static void host_fatal( const char* fmt, alt_u32 a, alt_u32 b )
+{
+  fflush(stdout);
+  fprintf(stderr, "host_hal: ");
+  fprintf(stderr, fmt, a, b);
+  fprintf(stderr, "\n");
+  abort();
+}
+
+static struct host_dev* host_find( alt_u32 base, alt_u32 regnum, alt_u32* reg )
+{
+  alt_u32 addr = base + regnum * 4;
+  int i;
+
+  for (i = 0; i < HOST_NUM_DEVS; i++)
+  {
+    struct host_dev* dev = &host_devs[i];
+    if (addr >= dev->base && addr < dev->base + dev->span)
+    {
+      *reg = (addr - dev->base) / 4;
+      return dev;
+    }
+  }
+  host_fatal("bus error: no slave at 0x%05x (base 0x%05x)", addr, base);
+  return NULL;
+}
+
+static struct host_dev* host_find_name( const char* name )
+{
+  int i;
+
+  for (i = 0; i < HOST_NUM_DEVS; i++)
+  {
+    if (strcmp(host_devs[i].name, name) == 0)
+    {
+      return &host_devs[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Interrupts
+ */
+
+static void host_call_isr( int irq )
+{
+  struct host_isr* h = &host_isrs[irq];
+
+  host_in_isr = 1;
+#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
+  h->isr(h->context);
+#else
+  h->isr(h->context, irq);
+#endif
+  host_in_isr = 0;
+}
+
+static int host_irq_pending( struct host_dev* dev )
+{
+  if (dev->irq < 0 || dev->irq >= HOST_MAX_IRQ)
+    return 0;
+  if (!host_isrs[dev->irq].enabled || host_isrs[dev->irq].isr == NULL)
+    return 0;
+  if (dev->kind == HOST_PIO_IN)
+    return (dev->regs[3] & dev->regs[2]) != 0;
+  return 0;
+}
+
+/*
+ * The HAL system clock ISR: acknowledge the timeout, count the tick and run
+ * every alarm that has expired.
+ */
+static void host_sys_clk_isr( void )
+{
+  alt_alarm* alarm;
+
+  host_in_isr = 1;
+  host_timer.to = 0;
+  _alt_nticks++;
+  for (alarm = host_alarms; alarm != NULL; alarm = alarm->next)
+  {
+    if (alarm->active && (alt_32)(_alt_nticks - alarm->time) >= 0)
+    {
+      alt_u32 next = alarm->callback(alarm->context);
+      if (next == 0)
+        alarm->active = 0;
+      else
+        alarm->time += next;
+    }
+  }
+  host_in_isr = 0;
+}
+
+static void host_deliver_irqs( void )
+{
+  int i, n;
+
+  if (host_in_isr || host_irq_disabled)
+    return;
+
+  if (host_timer.dev != NULL && host_timer.to &&
+      (host_timer.dev->regs[1] & ALTERA_AVALON_TIMER_CONTROL_ITO_MSK))
+  {
+    host_sys_clk_isr();
+  }
+
+  for (i = 0; i < HOST_NUM_DEVS; i++)
+  {
+    /* Level-sensitive: keep calling the ISR until it acknowledges. */
+    for (n = 0; n < HOST_IRQ_RETRIGGER && host_irq_pending(&host_devs[i]); n++)
+    {
+      host_call_isr(host_devs[i].irq);
+    }
+  }
+}
+
+/*
+ * Clock and input timeline
+ */
+
+static void host_set_input( struct host_dev* dev, alt_u32 value )
+{
+  alt_u32 rising;
+
+  value &= dev->mask;
+  rising = ~dev->regs[0] & value;
+  dev->regs[0] = value;
+  if (dev->capture)
+  {
+    dev->regs[3] |= rising;
+  }
+}
+
+static alt_u32 host_timer_counter( void )
+{
+  if (!host_timer.running)
+    return host_timer.held;
+  return host_timer.period - 1 - (alt_u32)((host_cycles - host_timer.start) % host_timer.period);
+}
+
+static void host_timer_reload( alt_u32 period )
+{
+  host_timer.period = period ? period : 1;
+  host_timer.held = host_timer.period - 1;
+  host_timer.running = 0;
+}
+
+static void host_timer_start( void )
+{
+  host_timer.start = host_cycles - (host_timer.period - 1 - host_timer.held);
+  host_timer.next_to = host_cycles + host_timer.held + 1;
+  host_timer.running = 1;
+}
+
+/*
+ * Step the clock to 'target', stopping at every scripted input change and
+ * every timer timeout on the way so interrupts see the right time.
+ */
+static void host_advance_to( alt_u64 target )
+{
+  for (;;)
+  {
+    alt_u64 next = target;
+    int what = 0;
+
+    if (host_script_next < host_script_len &&
+        host_script[host_script_next].cycle <= next)
+    {
+      next = host_script[host_script_next].cycle;
+      what = 1;
+    }
+    if (host_timer.running && host_timer.next_to <= next)
+    {
+      next = host_timer.next_to;
+      what = 2;
+    }
+    if (what == 0)
+      break;
+
+    if (next > host_cycles)
+    {
+      host_cycles = next;
+    }
+    if (what == 1)
+    {
+      struct host_event* ev = &host_script[host_script_next++];
+      host_set_input(ev->dev, ev->value);
+    }
+    else
+    {
+      host_timer.to = 1;
+      host_timer.next_to += host_timer.period;
+    }
+    host_deliver_irqs();
+  }
+  if (target > host_cycles)
+  {
+    host_cycles = target;
+  }
+  host_deliver_irqs();
+}
+
+static void host_charge( alt_u64 cycles )
+{
+  if (host_in_isr)
+  {
+    /* Time spent inside an ISR; events are picked up once it returns. */
+    host_cycles += cycles;
+    host_isr_cycles += cycles;
+    return;
+  }
+  host_advance_to(host_cycles + cycles);
+  if (host_limit_cycles && host_cycles >= host_limit_cycles)
+  {
+    host_hal_exit("time limit reached");
+  }
+}
+
+alt_u64 host_hal_cycles( void )
+{
+  return host_cycles;
+}
+
+alt_u64 host_hal_time_us( void )
+{
+  return host_cycles / HOST_CYCLES_PER_US;
+}
+
+void host_hal_advance( alt_u64 cycles )
+{
+  host_in_hal++;
+  host_charge(cycles);
+  host_in_hal--;
+}
+
+int host_hal_script_add( alt_u64 time_us, alt_u32 base, alt_u32 value )
+{
+  struct host_event ev;
+  alt_u32 reg;
+  int i;
+
+  ev.cycle = time_us * HOST_CYCLES_PER_US;
+  ev.dev = host_find(base, 0, &reg);
+  ev.value = value;
+  if (ev.dev->kind != HOST_PIO_IN)
+    return -1;
+
+  if (host_script_len == host_script_cap)
+  {
+    host_script_cap = host_script_cap ? host_script_cap * 2 : 64;
+    host_script = realloc(host_script, host_script_cap * sizeof(*host_script));
+    if (host_script == NULL)
+      host_fatal("out of memory (%u events)", host_script_cap, 0);
+  }
+
+  /* Keep the timeline sorted; equal times stay in insertion order. */
+  for (i = host_script_len; i > host_script_next && host_script[i - 1].cycle > ev.cycle; i--)
+  {
+    host_script[i] = host_script[i - 1];
+  }
+  host_script[i] = ev;
+  host_script_len++;
+  return 0;
+}
+
+static void host_load_script( const char* path )
+{
+  FILE* fp = fopen(path, "r");
+  char line[256];
+  int lineno = 0;
+
+  if (fp == NULL)
+  {
+    perror(path);
+    exit(2);
+  }
+  while (fgets(line, sizeof(line), fp) != NULL)
+  {
+    unsigned long long t;
+    char name[32];
+    char value[32];
+    char* hash = strchr(line, '#');
+    struct host_dev* dev;
+
+    lineno++;
+    if (hash != NULL)
+      *hash = '\0';
+    if (sscanf(line, "%llu %31s %31s", &t, name, value) != 3)
+      continue;
+    dev = host_find_name(name);
+    if (dev == NULL || dev->kind != HOST_PIO_IN)
+    {
+      fprintf(stderr, "%s:%d: '%s' is not an input PIO\n", path, lineno, name);
+      exit(2);
+    }
+    host_hal_script_add(t, dev->base, (alt_u32)strtoul(value, NULL, 0));
+  }
+  fclose(fp);
+}
+
+/*
+ * Register file
+ */
+
+/* 'value' with one bit in 'mask' inverted in one of 'every' calls on average. */
+static alt_u32 host_flip( struct host_dev* dev, alt_u32 every, alt_u32 value )
+{
+  alt_u32 r, bit;
+
+  if (every == 0)
+    return value;
+  host_flip_rng ^= host_flip_rng << 13;
+  host_flip_rng ^= host_flip_rng >> 7;
+  host_flip_rng ^= host_flip_rng << 17;
+  r = (alt_u32)(host_flip_rng >> 32);
+  if (r % every != 0)
+    return value;
+  /* Device masks are the low <width> bits. */
+  bit = (alt_u32) host_flip_rng % (32 - __builtin_clz(dev->mask));
+  dev->flips++;
+  return value ^ (1u << bit);
+}
+
+/*
+ * HD44780 controller
+ */
+
+static void host_hd_busy( alt_u32 us )
+{
+  host_hd.busy_until = host_cycles + (alt_u64) us * HOST_CYCLES_PER_US;
+  host_hd.busy_cycles += (alt_u64) us * HOST_CYCLES_PER_US;
+}
+
+/* Move the address counter one place, with the two-line DDRAM layout. */
+static void host_hd_step( void )
+{
+  int dir = host_hd.dec ? -1 : 1;
+
+  if (host_hd.cg)
+  {
+    host_hd.ac = (host_hd.ac + dir) & (HOST_HD_CGRAM - 1);
+    return;
+  }
+  host_hd.ac = (host_hd.ac + dir) & (HOST_HD_DDRAM - 1);
+  if (dir > 0 && host_hd.ac == 0x28)
+    host_hd.ac = 0x40;
+  else if (dir > 0 && host_hd.ac == 0x68)
+    host_hd.ac = 0x00;
+  else if (dir < 0 && host_hd.ac == 0x3f)
+    host_hd.ac = 0x27;
+  else if (dir < 0 && host_hd.ac == 0x7f)
+    host_hd.ac = 0x67;
+}
+
+static void host_hd_command( alt_u32 cmd )
+{
+  alt_u32 us = HOST_HD_EXEC_US;
+
+  host_hd.commands++;
+  if (cmd & 0x80)
+  {
+    host_hd.ac = cmd & 0x7f;
+    host_hd.cg = 0;
+  }
+  else if (cmd & 0x40)
+  {
+    host_hd.ac = cmd & 0x3f;
+    host_hd.cg = 1;
+  }
+  else if (cmd & 0x20)
+  {
+    /* Function set: the model is always 8-bit, two lines, 5x8. */
+  }
+  else if (cmd & 0x10)
+  {
+    /* Cursor shift; display shift is not modelled. */
+    if (!(cmd & 0x08))
+    {
+      int dec = host_hd.dec;
+      host_hd.dec = !(cmd & 0x04);
+      host_hd_step();
+      host_hd.dec = dec;
+    }
+  }
+  else if (cmd & 0x08)
+  {
+    host_hd.on = (cmd & 0x04) != 0;
+  }
+  else if (cmd & 0x04)
+  {
+    host_hd.dec = !(cmd & 0x02);
+  }
+  else if (cmd & 0x02)
+  {
+    host_hd.ac = 0;
+    host_hd.cg = 0;
+    us = HOST_HD_CLEAR_US;
+  }
+  else if (cmd & 0x01)
+  {
+    memset(host_hd.ddram, ' ', sizeof(host_hd.ddram));
+    host_hd.ac = 0;
+    host_hd.cg = 0;
+    host_hd.dec = 0;
+    us = HOST_HD_CLEAR_US;
+  }
+  host_hd_busy(us);
+}
+
+static void host_hd_write( alt_u32 reg, alt_u32 data )
+{
+  if (reg != 0 && reg != 2)
+    return;
+  if (host_cycles < host_hd.busy_until)
+  {
+    host_hd.overruns++;
+    return;
+  }
+  if (reg == 0)
+  {
+    host_hd_command(data);
+    return;
+  }
+  if (host_hd.cg)
+    host_hd.cgram[host_hd.ac] = data;
+  else
+    host_hd.ddram[host_hd.ac] = data;
+  host_hd.data_writes++;
+  host_hd_step();
+  host_hd_busy(HOST_HD_EXEC_US);
+}
+
+static alt_u32 host_hd_read( alt_u32 reg )
+{
+  int busy = host_cycles < host_hd.busy_until;
+  alt_u32 value;
+
+  if (reg == 1)
+  {
+    host_hd.busy_reads += busy;
+    return (busy ? HOST_HD_BUSY : 0) | host_hd.ac;
+  }
+  if (reg != 3)
+    return 0;
+  if (busy)
+  {
+    host_hd.overruns++;
+    return 0;
+  }
+  value = host_hd.cg ? host_hd.cgram[host_hd.ac] : host_hd.ddram[host_hd.ac];
+  host_hd.data_reads++;
+  host_hd_step();
+  host_hd_busy(HOST_HD_EXEC_US);
+  return value;
+}
+
+alt_u32 host_hal_read( alt_u32 base, alt_u32 regnum )
+{
+  alt_u32 reg;
+  struct host_dev* dev = host_find(base, regnum, &reg);
+  alt_u32 value;
+
+  host_in_hal++;
+  dev->reads[reg]++;
+  host_charge(host_bus_cycles);
+  value = dev->regs[reg];
+  if (dev->kind == HOST_PIO_OUT && reg == 0)
+  {
+    value &= dev->mask;
+  }
+  if (reg == 0 && HOST_IS_PIO(dev))
+  {
+    value = host_flip(dev, dev->flip_r_every, value);
+  }
+  else if (dev->kind == HOST_TIMER)
+  {
+    switch (reg)
+    {
+      case 0:
+        value = (host_timer.to ? ALTERA_AVALON_TIMER_STATUS_TO_MSK : 0) |
+                (host_timer.running ? ALTERA_AVALON_TIMER_STATUS_RUN_MSK : 0);
+        break;
+      case 2: value = (host_timer.period - 1) & 0xffff; break;
+      case 3: value = (host_timer.period - 1) >> 16; break;
+      case 4: value = host_timer.snap & 0xffff; break;
+      case 5: value = host_timer.snap >> 16; break;
+    }
+  }
+  else if (dev->kind == HOST_LCD)
+  {
+    value = host_hd_read(reg);
+  }
+  host_in_hal--;
+  return value;
+}
+
+void host_hal_write( alt_u32 base, alt_u32 regnum, alt_u32 data )
+{
+  alt_u32 reg;
+  struct host_dev* dev = host_find(base, regnum, &reg);
+
+  host_in_hal++;
+  dev->writes[reg]++;
+  if (dev->regs[reg] == data)
+  {
+    dev->same_writes++;
+  }
+  if (reg == 0 && HOST_IS_PIO(dev))
+  {
+    data = host_flip(dev, dev->flip_w_every, data);
+  }
+
+  switch (dev->kind)
+  {
+    case HOST_PIO_IN:
+      if (reg == 3)
+        dev->regs[3] = 0;         /* any write clears the edge capture */
+      else if (reg != 0)
+        dev->regs[reg] = data & dev->mask;
+      break;
+    case HOST_PIO_OUT:
+      if (reg == 0)
+        dev->regs[0] = data & dev->mask;
+      else if (reg == 4)
+        dev->regs[0] |= data & dev->mask;
+      else if (reg == 5)
+        dev->regs[0] &= ~data;
+      else
+        dev->regs[reg] = data;
+      if (host_pio_log != NULL && (reg == 0 || reg == 4 || reg == 5))
+      {
+        fprintf(host_pio_log, "%llu %s 0x%x\n",
+          (unsigned long long) host_cycles, dev->name, dev->regs[0]);
+      }
+      break;
+    case HOST_TIMER:
+      dev->regs[reg] = data;
+      if (reg == 0)
+      {
+        host_timer.to = 0;
+      }
+      else if (reg == 1)
+      {
+        if ((data & ALTERA_AVALON_TIMER_CONTROL_STOP_MSK) && host_timer.running)
+        {
+          host_timer.held = host_timer_counter();
+          host_timer.running = 0;
+        }
+        if ((data & ALTERA_AVALON_TIMER_CONTROL_START_MSK) && !host_timer.running)
+        {
+          host_timer_start();
+        }
+      }
+      else if (reg == 2 || reg == 3)
+      {
+        /* Writing either half of the period stops and reloads the counter. */
+        alt_u32 period = host_timer.period - 1;
+        if (reg == 2)
+          period = (period & 0xffff0000) | (data & 0xffff);
+        else
+          period = (period & 0xffff) | ((data & 0xffff) << 16);
+        host_timer_reload(period + 1);
+      }
+      else if (reg == 4 || reg == 5)
+      {
+        host_timer.snap = host_timer_counter();
+      }
+      break;
+    case HOST_LCD:
+      dev->regs[reg] = data;
+      host_hd_write(reg, data & dev->mask);
+      break;
+    default:
+      dev->regs[reg] = data;
+      break;
+  }
+  host_charge(host_bus_cycles);
+  host_in_hal--;
+}
+
+alt_u32 host_hal_peek( alt_u32 base, alt_u32 regnum )
+{
+  alt_u32 reg;
+  return host_find(base, regnum, &reg)->regs[reg];
+}
+
+alt_u32 host_hal_reads( alt_u32 base, alt_u32 regnum )
+{
+  alt_u32 reg;
+  return host_find(base, regnum, &reg)->reads[reg];
+}
+
+alt_u32 host_hal_writes( alt_u32 base, alt_u32 regnum )
+{
+  alt_u32 reg;
+  return host_find(base, regnum, &reg)->writes[reg];
+}
+
+/*
+ * On-chip memory
+ */
+
+#ifdef ONCHIP_MEM_BASE
+
+static int host_mem_hit( alt_u32 addr )
+{
+  return addr >= ONCHIP_MEM_BASE && addr - ONCHIP_MEM_BASE < ONCHIP_MEM_SPAN;
+}
+
+static alt_u32 host_mem_word( alt_u32 addr )
+{
+  if (addr & 3)
+    host_fatal("misaligned word access at 0x%05x", addr, 0);
+  return ((addr - ONCHIP_MEM_BASE) & ~host_mem.ad_mask) / 4;
+}
+
+/* Apply the stuck-at faults of a word to a value stored in it. */
+static alt_u32 host_mem_stuck( alt_u32 word, alt_u32 value )
+{
+  int i;
+
+  for (i = 0; i < host_mem.num_faults; i++)
+  {
+    struct host_mem_fault* f = &host_mem.faults[i];
+    if (f->word != word)
+      continue;
+    if (f->kind == HOST_MEM_SA0)
+      value &= ~(1u << f->bit);
+    else if (f->kind == HOST_MEM_SA1)
+      value |= 1u << f->bit;
+  }
+  return value;
+}
+
+static void host_mem_store( alt_u32 word, alt_u32 value )
+{
+  alt_u32 old = host_mem.words[word];
+  int i;
+
+  value = host_mem_stuck(word, value);
+  host_mem.words[word] = value;
+  for (i = 0; i < host_mem.num_faults; i++)
+  {
+    struct host_mem_fault* f = &host_mem.faults[i];
+    if (f->kind == HOST_MEM_CF && f->word == word && ((old ^ value) >> f->bit & 1))
+    {
+      host_mem.words[f->victim] = host_mem_stuck(f->victim,
+        host_mem.words[f->victim] ^ (1u << f->victim_bit));
+    }
+  }
+}
+
+static void host_mem_add_fault( const char* spec )
+{
+  struct host_mem_fault f = { 0, 0, 0, 0, 0 };
+  long a, c = 0;
+  unsigned int b = 0, d = 0;
+  char kind[8];
+
+  if (sscanf(spec, "%7[a-z0-9]:%li:%u:%li:%u", kind, &a, &b, &c, &d) < 2)
+    goto bad;
+  if (strcmp(kind, "ad") == 0)
+  {
+    host_mem.ad_mask |= 1u << a;
+    return;
+  }
+  if (!host_mem_hit(a) || host_mem.num_faults == HOST_MEM_MAX_FAULTS)
+    goto bad;
+  f.word = (a - ONCHIP_MEM_BASE) / 4;
+  f.bit = b & 31;
+  if (strcmp(kind, "sa0") == 0)
+    f.kind = HOST_MEM_SA0;
+  else if (strcmp(kind, "sa1") == 0)
+    f.kind = HOST_MEM_SA1;
+  else if (strcmp(kind, "cf") == 0 && host_mem_hit(c))
+  {
+    f.kind = HOST_MEM_CF;
+    f.victim = (c - ONCHIP_MEM_BASE) / 4;
+    f.victim_bit = d & 31;
+  }
+  else
+    goto bad;
+  host_mem.faults[host_mem.num_faults++] = f;
+  host_mem.words[f.word] = host_mem_stuck(f.word, host_mem.words[f.word]);
+  return;
+
+bad:
+  fprintf(stderr, "host_hal: bad BOARD_DIAG_MEM_FAULTS entry '%s'\n", spec);
+  exit(2);
+}
+
+static void host_mem_init( const char* faults )
+{
+  char buf[512];
+  char* spec;
+
+  host_mem.words = calloc(ONCHIP_MEM_SPAN / 4, sizeof(alt_u32));
+  if (host_mem.words == NULL)
+    host_fatal("out of memory (%u bytes of onchip_mem)", ONCHIP_MEM_SPAN, 0);
+  if (faults == NULL)
+    return;
+  snprintf(buf, sizeof(buf), "%s", faults);
+  for (spec = strtok(buf, ", "); spec != NULL; spec = strtok(NULL, ", "))
+    host_mem_add_fault(spec);
+}
+
+#endif
+
+alt_u32 host_hal_read32( alt_u32 addr )
+{
+  alt_u32 value;
+
+#ifdef ONCHIP_MEM_BASE
+  if (host_mem_hit(addr))
+  {
+    host_in_hal++;
+    host_mem.reads++;
+    host_charge(host_bus_cycles);
+    value = host_mem.words[host_mem_word(addr)];
+    host_in_hal--;
+    return value;
+  }
+#endif
+  value = host_hal_read(addr, 0);
+  return value;
+}
+
+void host_hal_write32( alt_u32 addr, alt_u32 data )
+{
+#ifdef ONCHIP_MEM_BASE
+  if (host_mem_hit(addr))
+  {
+    host_in_hal++;
+    host_mem.writes++;
+    host_mem_store(host_mem_word(addr), data);
+    host_charge(host_bus_cycles);
+    host_in_hal--;
+    return;
+  }
+#endif
+  host_hal_write(addr, 0, data);
+}
+
+static void host_flips_init( const char* flips )
+{
+  char buf[512];
+  char name[32];
+  char* spec;
+  char dir;
+  unsigned long every;
+  struct host_dev* dev;
+
+  snprintf(buf, sizeof(buf), "%s", flips);
+  for (spec = strtok(buf, ", "); spec != NULL; spec = strtok(NULL, ", "))
+  {
+    if (sscanf(spec, "%31[a-z0-9_]:%c:%lu", name, &dir, &every) != 3 ||
+        (dev = host_find_name(name)) == NULL || !HOST_IS_PIO(dev) ||
+        (dir != 'w' && dir != 'r'))
+    {
+      fprintf(stderr, "host_hal: bad BOARD_DIAG_BIT_FLIPS entry '%s'\n", spec);
+      exit(2);
+    }
+    if (dir == 'w')
+      dev->flip_w_every = every;
+    else
+      dev->flip_r_every = every;
+  }
+}
+
+/*
+ * HAL interrupt API
+ */
+
+int alt_ic_isr_register( alt_u32 ic_id, alt_u32 irq, alt_isr_func isr,
+  void *isr_context, void *flags )
+{
+  (void) ic_id;
+  (void) flags;
+  if (irq >= HOST_MAX_IRQ)
+    return -EINVAL;
+  host_isrs[irq].isr = isr;
+  host_isrs[irq].context = isr_context;
+  host_isrs[irq].enabled = (isr != NULL);
+  return 0;
+}
+
+int alt_ic_irq_enable( alt_u32 ic_id, alt_u32 irq )
+{
+  (void) ic_id;
+  if (irq >= HOST_MAX_IRQ)
+    return -EINVAL;
+  host_isrs[irq].enabled = 1;
+  return 0;
+}
+
+int alt_ic_irq_disable( alt_u32 ic_id, alt_u32 irq )
+{
+  (void) ic_id;
+  if (irq >= HOST_MAX_IRQ)
+    return -EINVAL;
+  host_isrs[irq].enabled = 0;
+  return 0;
+}
+
+int alt_irq_register( alt_u32 id, void* context, alt_isr_func handler )
+{
+  return alt_ic_isr_register(0, id, handler, context, NULL);
+}
+
+alt_irq_context alt_irq_disable_all( void )
+{
+  alt_irq_context prev = !host_irq_disabled;
+  host_irq_disabled = 1;
+  return prev;
+}
+
+void alt_irq_enable_all( alt_irq_context context )
+{
+  if (context)
+  {
+    host_irq_disabled = 0;
+    host_in_hal++;
+    host_deliver_irqs();
+    host_in_hal--;
+  }
+}
+
+/*
+ * HAL alarm API
+ */
+
+int alt_alarm_start( alt_alarm* the_alarm, alt_u32 nticks,
+  alt_u32 (*callback) (void* context), void* context )
+{
+  alt_alarm* a;
+
+  if (the_alarm == NULL || callback == NULL)
+    return -EINVAL;
+
+  the_alarm->time = _alt_nticks + nticks + 1;
+  the_alarm->callback = callback;
+  the_alarm->context = context;
+  the_alarm->active = 1;
+  for (a = host_alarms; a != NULL; a = a->next)
+  {
+    if (a == the_alarm)
+      return 0;
+  }
+  the_alarm->next = host_alarms;
+  host_alarms = the_alarm;
+  return 0;
+}
+
+void alt_alarm_stop( alt_alarm* the_alarm )
+{
+  alt_alarm** link;
+
+  for (link = &host_alarms; *link != NULL; link = &(*link)->next)
+  {
+    if (*link == the_alarm)
+    {
+      *link = the_alarm->next;
+      break;
+    }
+  }
+  the_alarm->active = 0;
+}
+
+/*
+ * LCD character device (/dev/lcd_display)
+ */
+
+/* One register write as the HAL driver makes it: poll, sleep, then write. */
+
+static void host_lcd_hal_write( alt_u32 reg, alt_u32 data )
+{
+#ifdef LCD_DISPLAY_BASE
+  while (host_hal_read(LCD_DISPLAY_BASE, 1) & HOST_HD_BUSY)
+    ;
+  host_hal_advance((alt_u64) HOST_HD_HAL_SLEEP_US * HOST_CYCLES_PER_US);
+  host_hal_write(LCD_DISPLAY_BASE, reg, data);
+#else
+  (void) reg;
+  (void) data;
+#endif
+}
+
+/* Send the characters that differ from what the driver last sent. */
+
+static void host_lcd_repaint( void )
+{
+  int r, x, addr;
+
+  for (r = 0; r < HOST_LCD_ROWS; r++)
+  {
+    for (x = 0; x < HOST_LCD_SHOWN; x++)
+    {
+      if (host_lcd.shown[r][x] == host_lcd.ddram[r][x])
+        continue;
+      addr = (r ? 0x40 : 0x00) + x;
+      if (addr != host_lcd.addr)
+        host_lcd_hal_write(0, 0x80 | addr);
+      host_lcd_hal_write(2, (alt_u8) host_lcd.ddram[r][x]);
+      host_lcd.shown[r][x] = host_lcd.ddram[r][x];
+      host_lcd.addr = addr + 1;
+    }
+  }
+}
+
+static void host_lcd_scroll( void )
+{
+  memmove(host_lcd.ddram[0], host_lcd.ddram[1], HOST_LCD_COLS);
+  memset(host_lcd.ddram[1], ' ', HOST_LCD_COLS);
+}
+
+static void host_lcd_escape( char cmd )
+{
+  int a = 0, b = 0;
+
+  host_lcd.esc_buf[host_lcd.esc_len] = '\0';
+  sscanf(host_lcd.esc_buf, "%d;%d", &a, &b);
+  switch (cmd)
+  {
+    case 'J':
+      /* The driver clears the display at once, not in the repaint. */
+      host_lcd_hal_write(0, 0x01);
+      memset(host_lcd.ddram, ' ', sizeof(host_lcd.ddram));
+      memset(host_lcd.shown, ' ', sizeof(host_lcd.shown));
+      host_lcd.addr = 0;
+      host_lcd.x = host_lcd.y = 0;
+      break;
+    case 'K':
+      if (host_lcd.y < HOST_LCD_ROWS && host_lcd.x < HOST_LCD_COLS)
+        memset(&host_lcd.ddram[host_lcd.y][host_lcd.x], ' ', HOST_LCD_COLS - host_lcd.x);
+      break;
+    case 'H':
+      host_lcd.y = a > 0 ? a - 1 : 0;
+      host_lcd.x = b > 0 ? b - 1 : 0;
+      break;
+  }
+}
+
+static void host_lcd_putc( char c )
+{
+  host_lcd.bytes++;
+
+  if (host_lcd.esc == 1)
+  {
+    host_lcd.esc = (c == '[') ? 2 : 0;
+    host_lcd.esc_len = 0;
+    return;
+  }
+  if (host_lcd.esc == 2)
+  {
+    if ((c >= '0' && c <= '9') || c == ';')
+    {
+      if (host_lcd.esc_len < (int)sizeof(host_lcd.esc_buf) - 1)
+        host_lcd.esc_buf[host_lcd.esc_len++] = c;
+    }
+    else
+    {
+      host_lcd_escape(c);
+      host_lcd.esc = 0;
+    }
+    return;
+  }
+
+  switch (c)
+  {
+    case 27:
+      host_lcd.esc = 1;
+      break;
+    case '\r':
+      host_lcd.x = 0;
+      break;
+    case '\n':
+      host_lcd.x = 0;
+      host_lcd.y++;
+      break;
+    default:
+      /* Like the HAL driver, scroll lazily when the next character lands. */
+      while (host_lcd.y >= HOST_LCD_ROWS)
+      {
+        host_lcd_scroll();
+        host_lcd.y--;
+      }
+      if (host_lcd.x < HOST_LCD_COLS)
+        host_lcd.ddram[host_lcd.y][host_lcd.x] = c;
+      host_lcd.x++;
+      break;
+  }
+}
+
+static ssize_t host_lcd_write( void* cookie, const char* buf, size_t size )
+{
+  size_t i;
+
+  (void) cookie;
+  host_lcd.writes++;
+  if (size > host_lcd.max_write)
+  {
+    host_lcd.max_write = size;
+  }
+  for (i = 0; i < size; i++)
+  {
+    host_lcd_putc(buf[i]);
+  }
+  host_lcd_repaint();
+  return size;
+}
+
+static int host_lcd_close( void* cookie )
+{
+  (void) cookie;
+  host_lcd.closes++;
+  return 0;
+}
+
+FILE* host_fopen( const char* path, const char* mode )
+{
+#ifdef LCD_DISPLAY_NAME
+  if (strcmp(path, LCD_DISPLAY_NAME) == 0)
+  {
+    cookie_io_functions_t io = { NULL, host_lcd_write, NULL, host_lcd_close };
+    FILE* fp = fopencookie(&host_lcd, mode, io);
+    if (fp != NULL)
+    {
+      host_lcd.opens++;
+      /* newlib line-buffers HAL character devices, as they are ttys. */
+      setvbuf(fp, NULL, _IOLBF, BUFSIZ);
+    }
+    return fp;
+  }
+#endif
+  return fopen(path, mode);
+}
+
+/*
+ * JTAG UART character device (/dev/jtag_uart)
+ */
+
+/* Move whatever the link has carried since the last call out of the TX side. */
+
+static void host_uart_drain( void )
+{
+  alt_u64 per_byte = ALT_CPU_FREQ / host_uart.bps;
+  char c;
+
+  if (per_byte == 0)
+    per_byte = 1;
+  while (host_uart.tx_len && host_cycles >= host_uart.drained_at + per_byte)
+  {
+    if (host_uart.loopback)
+    {
+      if (host_uart.rx_len == HOST_UART_RX_CAP)
+        break;
+      c = host_uart.tx[host_uart.tx_head];
+      host_uart.rx[(host_uart.rx_head + host_uart.rx_len++) % HOST_UART_RX_CAP] = c;
+    }
+    host_uart.tx_head = (host_uart.tx_head + 1) % HOST_UART_TX_CAP;
+    host_uart.tx_len--;
+    host_uart.drained_at += per_byte;
+  }
+  if (host_uart.tx_len == 0 || (host_uart.loopback && host_uart.rx_len == HOST_UART_RX_CAP))
+  {
+    /* Idle or stalled link: the next byte starts from now. */
+    host_uart.drained_at = host_cycles;
+  }
+}
+
+static ssize_t host_uart_write( const char* buf, size_t size )
+{
+  size_t n = 0;
+
+  host_hal_advance(HOST_UART_CALL_CYCLES);
+  host_uart_drain();
+  while (n < size)
+  {
+    if (host_uart.tx_len == HOST_UART_TX_CAP)
+    {
+      if (host_uart.nonblock)
+        break;
+      if (host_uart.loopback && host_uart.rx_len == HOST_UART_RX_CAP)
+        host_hal_exit("jtag_uart loopback full with a blocking write");
+      host_hal_advance(ALT_CPU_FREQ / host_uart.bps);
+      host_uart_drain();
+      continue;
+    }
+    if (host_uart.pty >= 0)
+      write(host_uart.pty, &buf[n], 1);
+    else if (!host_uart.loopback)
+      putchar(buf[n]);
+    host_uart.tx[(host_uart.tx_head + host_uart.tx_len++) % HOST_UART_TX_CAP] = buf[n++];
+  }
+  host_hal_advance((alt_u64) n * HOST_UART_BYTE_CYCLES);
+  host_uart.tx_bytes += n;
+  if (n == 0 && size > 0)
+  {
+    host_uart.would_block++;
+    errno = EWOULDBLOCK;
+    return -1;
+  }
+  return n;
+}
+
+/*
+ * Take what the peer on the pseudo-terminal has sent, charging link time for
+ * it.  Nothing is taken while our own output is still on the link, so a
+ * reply cannot overtake the bytes that caused it.  A non-blocking read gives
+ * the peer HOST_UART_PTY_WAIT_MS of wall time to answer before reporting
+ * nothing, and charges that much virtual time only when it really is silent;
+ * the peer's own scheduling delays therefore do not show in measurements.
+ */
+
+static void host_uart_pty_fill( int wait )
+{
+  struct pollfd pfd = { .fd = host_uart.pty, .events = POLLIN };
+  char tmp[HOST_UART_RX_CAP];
+  size_t room;
+  ssize_t r;
+  ssize_t i;
+
+  while (wait && host_uart.tx_len)
+  {
+    host_hal_advance(ALT_CPU_FREQ / host_uart.bps);
+    host_uart_drain();
+  }
+  room = HOST_UART_RX_CAP - host_uart.rx_len;
+  if (host_uart.tx_len || room == 0)
+    return;
+  if (poll(&pfd, 1, wait ? -1 : HOST_UART_PTY_WAIT_MS) <= 0)
+  {
+    host_hal_advance((alt_u64) HOST_UART_PTY_WAIT_MS * (ALT_CPU_FREQ / 1000));
+    return;
+  }
+  r = read(host_uart.pty, tmp, room);
+  if (r <= 0)
+    host_hal_exit("jtag_uart peer closed the pseudo-terminal");
+  for (i = 0; i < r; i++)
+  {
+    host_uart.rx[(host_uart.rx_head + host_uart.rx_len++) % HOST_UART_RX_CAP] = tmp[i];
+  }
+  host_hal_advance((alt_u64) r * (ALT_CPU_FREQ / host_uart.bps));
+}
+
+static ssize_t host_uart_read( char* buf, size_t size )
+{
+  size_t n = 0;
+
+  host_hal_advance(HOST_UART_CALL_CYCLES);
+  host_uart_drain();
+  if (host_uart.pty >= 0 && host_uart.rx_len == 0)
+  {
+    host_uart_pty_fill(!host_uart.nonblock);
+  }
+  if (host_uart.rx_len == 0 && !host_uart.nonblock)
+  {
+    if (!host_uart.loopback || host_uart.tx_len == 0)
+    {
+      /* Nothing in flight: the terminal on the other end is stdin. */
+      ssize_t r = read(0, buf, size);
+      if (r <= 0)
+        host_hal_exit("end of input");
+      return r;
+    }
+    while (host_uart.rx_len == 0)
+    {
+      host_hal_advance(ALT_CPU_FREQ / host_uart.bps);
+      host_uart_drain();
+    }
+  }
+  while (n < size && host_uart.rx_len)
+  {
+    buf[n++] = host_uart.rx[host_uart.rx_head];
+    host_uart.rx_head = (host_uart.rx_head + 1) % HOST_UART_RX_CAP;
+    host_uart.rx_len--;
+  }
+  host_hal_advance((alt_u64) n * HOST_UART_BYTE_CYCLES);
+  host_uart.rx_bytes += n;
+  if (n == 0 && size > 0)
+  {
+    errno = EWOULDBLOCK;
+    return -1;
+  }
+  return n;
+}
+
+int host_open( const char* path, int flags, ... )
+{
+  va_list ap;
+  int mode;
+
+#ifdef JTAG_UART_NAME
+  if (strcmp(path, JTAG_UART_NAME) == 0)
+  {
+    host_uart.nonblock = (flags & O_NONBLOCK) != 0;
+    host_uart.opens++;
+    return HOST_UART_FD;
+  }
+#endif
+  va_start(ap, flags);
+  mode = va_arg(ap, int);
+  va_end(ap);
+  return open(path, flags, mode);
+}
+
+ssize_t host_read( int fd, void* buf, size_t size )
+{
+  if (fd == HOST_UART_FD)
+    return host_uart_read(buf, size);
+  return read(fd, buf, size);
+}
+
+ssize_t host_write( int fd, const void* buf, size_t size )
+{
+  if (fd == HOST_UART_FD)
+    return host_uart_write(buf, size);
+  return write(fd, buf, size);
+}
+
+int host_close( int fd )
+{
+  if (fd == HOST_UART_FD)
+    return 0;
+  return close(fd);
+}
+
+/*
+ * usleep() and stdin
+ */
+
+int host_usleep( unsigned int us )
+{
+  host_hal_advance((alt_u64)us * HOST_CYCLES_PER_US);
+  return 0;
+}
+
+int host_getc( FILE* stream )
+{
+  int c = getc(stream);
+
+  if (c == EOF && stream == stdin)
+  {
+    host_hal_exit("end of input");
+  }
+  return c;
+}
+
+/*
+ * Statistics and lifetime
+ */
+
+void host_hal_dump_stats( FILE* out )
+{
+  struct timespec now;
+  double wall;
+  int i, r;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  wall = (now.tv_sec - host_wall_start.tv_sec) +
+         (now.tv_nsec - host_wall_start.tv_nsec) / 1e9;
+
+  fprintf(out, "host_hal: virtual %.6f s (%llu cycles), wall %.3f s\n",
+    (double)host_cycles / ALT_CPU_FREQ, (unsigned long long)host_cycles, wall);
+  fprintf(out, "host_hal: %llu cycles (%.2f%%) in interrupt handlers\n",
+    (unsigned long long)host_isr_cycles,
+    host_cycles ? 100.0 * host_isr_cycles / host_cycles : 0.0);
+  fprintf(out, "host_hal: %-16s %-8s %3s %10s %10s\n",
+    "device", "base", "reg", "reads", "writes");
+  for (i = 0; i < HOST_NUM_DEVS; i++)
+  {
+    struct host_dev* dev = &host_devs[i];
+    for (r = 0; r < HOST_REGS; r++)
+    {
+      if (dev->reads[r] || dev->writes[r])
+      {
+        fprintf(out, "host_hal: %-16s 0x%06x %3d %10u %10u\n",
+          dev->name, dev->base, r, dev->reads[r], dev->writes[r]);
+      }
+    }
+    if (dev->same_writes)
+    {
+      fprintf(out, "host_hal: %-16s %u writes repeated the current value\n",
+        dev->name, dev->same_writes);
+    }
+    if (dev->flips)
+    {
+      fprintf(out, "host_hal: %-16s %u bit flips injected\n", dev->name, dev->flips);
+    }
+  }
+  if (host_uart.opens)
+  {
+    fprintf(out, "host_hal: jtag_uart tx %u bytes, rx %u bytes, "
+      "%u writes would block, %u bytes still queued\n",
+      host_uart.tx_bytes, host_uart.rx_bytes, host_uart.would_block,
+      host_uart.tx_len);
+  }
+#ifdef ONCHIP_MEM_BASE
+  if (host_mem.reads || host_mem.writes)
+  {
+    fprintf(out, "host_hal: onchip_mem reads %u writes %u, %d faults injected%s\n",
+      host_mem.reads, host_mem.writes, host_mem.num_faults,
+      host_mem.ad_mask ? " plus address line faults" : "");
+  }
+#endif
+  if (host_lcd.opens)
+  {
+    fprintf(out, "host_hal: lcd_display opens %u closes %u bytes %u\n",
+      host_lcd.opens, host_lcd.closes, host_lcd.bytes);
+    fprintf(out, "host_hal: lcd_display writes %u, largest %u bytes, "
+      "%u bytes of stream buffer per open\n",
+      host_lcd.writes, host_lcd.max_write, (unsigned) BUFSIZ);
+  }
+  if (host_hd.commands || host_hd.data_writes)
+  {
+    fprintf(out, "host_hal: lcd_display hd44780 commands %u data writes %u "
+      "reads %u, busy %.3f s\n", host_hd.commands, host_hd.data_writes,
+      host_hd.data_reads, (double) host_hd.busy_cycles / ALT_CPU_FREQ);
+    fprintf(out, "host_hal: lcd_display %u status reads saw busy, "
+      "%u accesses while busy ignored\n", host_hd.busy_reads, host_hd.overruns);
+    for (r = 0; r < HOST_LCD_ROWS; r++)
+    {
+      /* CGRAM glyphs (codes 0-15) show as '#'. */
+      char row[HOST_LCD_SHOWN + 1];
+      for (i = 0; i < HOST_LCD_SHOWN; i++)
+      {
+        alt_u8 c = host_hd.ddram[(r ? 0x40 : 0x00) + i];
+        row[i] = c < 0x10 ? '#' : (c < 0x20 || c > 0x7e) ? '?' : c;
+      }
+      row[HOST_LCD_SHOWN] = '\0';
+      fprintf(out, "host_hal: lcd_display |%s|%s\n", row, host_hd.on ? "" : " (off)");
+    }
+  }
+}
+
+void host_hal_exit( const char* reason )
+{
+  fflush(stdout);
+  fprintf(stderr, "\nhost_hal: %s at %.6f s\n", reason,
+    (double)host_cycles / ALT_CPU_FREQ);
+  exit(0);
+}
+
+static void host_atexit( void )
+{
+  /* The firmware may have made stdin non-blocking; give the shell it back. */
+  fcntl(STDIN_FILENO, F_SETFL, host_stdin_flags);
+  fflush(stdout);
+  if (host_stats)
+  {
+    host_hal_dump_stats(stderr);
+  }
+}
+
+static void host_alarm( int sig )
+{
+  (void) sig;
+  if (host_in_hal || host_in_isr)
+    return;
+
+  if (host_cycles == host_alarm_seen)
+  {
+    /* Nothing touched the bus for a whole alarm period: let time pass. */
+    host_in_hal++;
+    host_advance_to(host_cycles + HOST_IDLE_QUANTUM);
+    host_in_hal--;
+    if (host_limit_cycles && host_cycles >= host_limit_cycles)
+    {
+      static const char msg[] = "\nhost_hal: time limit reached while spinning\n";
+      write(2, msg, sizeof(msg) - 1);
+      _exit(0);
+    }
+  }
+  host_alarm_seen = host_cycles;
+}
+
+/* Create the pseudo-terminal for the JTAG UART and link its slave to 'path'. */
+
+static void host_uart_open_pty( const char* path )
+{
+  struct termios tio;
+  struct pollfd pfd;
+  const char* slave;
+  int fd;
+
+  fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0 || (slave = ptsname(fd)) == NULL)
+    host_fatal("cannot create a pseudo-terminal for jtag_uart", 0, 0);
+  tcgetattr(fd, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(fd, TCSANOW, &tio);
+  unlink(path);
+  if (symlink(slave, path) < 0)
+    host_fatal("cannot link the jtag_uart pseudo-terminal", 0, 0);
+  host_uart.pty = fd;
+  host_uart.loopback = 0;
+  fprintf(stderr, "host_hal: jtag_uart on %s (%s), waiting for a peer\n", slave, path);
+
+  /*
+   * Bytes written before the peer has the slave open are lost, so wait for
+   * it.  The master only reports POLLHUP once a slave has come and gone;
+   * opening and closing it here makes that hold from the start.
+   */
+  close(open(slave, O_RDWR | O_NOCTTY));
+  do
+  {
+    pfd.fd = fd;
+    pfd.events = 0;
+    poll(&pfd, 1, 0);
+    if (pfd.revents & POLLHUP)
+      usleep(10000);
+  }
+  while (pfd.revents & POLLHUP);
+}
+
+__attribute__((constructor))
+static void host_hal_init( void )
+{
+  struct sigaction sa;
+  struct itimerval it;
+  const char* env;
+
+  clock_gettime(CLOCK_MONOTONIC, &host_wall_start);
+  host_stdin_flags = fcntl(STDIN_FILENO, F_GETFL);
+  memset(host_lcd.ddram, ' ', sizeof(host_lcd.ddram));
+  memset(host_lcd.shown, ' ', sizeof(host_lcd.shown));
+  /* As the HAL driver's initialisation leaves the controller. */
+  memset(host_hd.ddram, ' ', sizeof(host_hd.ddram));
+  host_hd.on = 1;
+#ifdef SYSID_BASE
+  host_find_name("sysid")->regs[0] = SYSID_ID;
+  host_find_name("sysid")->regs[1] = SYSID_TIMESTAMP;
+#endif
+
+#ifdef SYS_CLK_TIMER_BASE
+  /* What the HAL's sys_clk driver does in alt_sys_init(). */
+  host_timer.dev = host_find_name("sys_clk_timer");
+  host_timer_reload(SYS_CLK_TIMER_LOAD_VALUE + 1);
+  host_timer.dev->regs[1] = ALTERA_AVALON_TIMER_CONTROL_ITO_MSK |
+                            ALTERA_AVALON_TIMER_CONTROL_CONT_MSK |
+                            ALTERA_AVALON_TIMER_CONTROL_START_MSK;
+  host_timer_start();
+  _alt_tick_rate = SYS_CLK_TIMER_TICKS_PER_SEC;
+#endif
+
+  if ((env = getenv("BOARD_DIAG_BUS_CYCLES")) != NULL)
+    host_bus_cycles = strtoull(env, NULL, 0);
+  if ((env = getenv("BOARD_DIAG_TIME_LIMIT_MS")) != NULL)
+    host_limit_cycles = strtoull(env, NULL, 0) * 1000 * HOST_CYCLES_PER_US;
+  if ((env = getenv("BOARD_DIAG_SCRIPT")) != NULL)
+    host_load_script(env);
+#ifdef ONCHIP_MEM_BASE
+  host_mem_init(getenv("BOARD_DIAG_MEM_FAULTS"));
+#endif
+  if ((env = getenv("BOARD_DIAG_BIT_FLIPS")) != NULL)
+    host_flips_init(env);
+  if ((env = getenv("BOARD_DIAG_PIO_LOG")) != NULL &&
+      (host_pio_log = fopen(env, "w")) == NULL)
+    host_fatal("cannot open BOARD_DIAG_PIO_LOG", 0, 0);
+  if ((env = getenv("BOARD_DIAG_UART_BPS")) != NULL && strtoull(env, NULL, 0) > 0)
+    host_uart.bps = strtoull(env, NULL, 0);
+  host_uart.loopback = getenv("BOARD_DIAG_UART_LOOPBACK") != NULL;
+  if ((env = getenv("BOARD_DIAG_UART_PTY")) != NULL)
+    host_uart_open_pty(env);
+  host_stats = getenv("BOARD_DIAG_STATS") != NULL;
+  atexit(host_atexit);
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = host_alarm;
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGALRM, &sa, NULL);
+  it.it_interval.tv_sec = 0;
+  it.it_interval.tv_usec = 1000;
+  it.it_value = it.it_interval;
+  setitimer(ITIMER_REAL, &it, NULL);
+}
@@ -0,0 +1,93 @@
+/*
+ * host_hal.h - simulated Nios II HAL for running the diagnostics on Linux.
+ *
+ * This header is force-included into every translation unit of the host
+ * build (-include host_hal.h, see README.md).  It pulls in the C library
+ * headers first and then points the few HAL services the firmware gets from
+ * newlib (usleep, the /dev/... character devices and stdin) at the
+ * simulation, so the firmware sources build unmodified.
+ *
+ * The simulation keeps:
+ *  - a register file for every peripheral in system.h, with per-register
+ *    read/write counters,
+ *  - a virtual clock in CPU cycles, advanced by every bus access and by
+ *    usleep(),
+ *  - sys_clk_timer (counter, snapshot, timeout) and the HAL system clock
+ *    built on it (alt_nticks(), alt_alarm_start()),
+ *  - a scripted input timeline for the input PIOs (KEY_BASE,
+ *    BUTTON_PIO_BASE), loaded from $BOARD_DIAG_SCRIPT,
+ *  - the JTAG UART character device, with a rate-limited link and an
+ *    optional loopback,
+ *  - the on-chip memory, with optional injected faults,
+ *  - optional bit flips on the data registers, for the timing stress,
+ *  - an optional log of every value driven by the output PIOs.
+ *
+ * Environment:
+ *  BOARD_DIAG_SCRIPT         input timeline, one "<time_us> <pio> <value>"
+ *                            per line, '#' starts a comment.  <pio> is the
+ *                            system.h name, e.g. "key" or "button_pio".
+ *  BOARD_DIAG_STATS          if set, dump the access counters on exit.
+ *  BOARD_DIAG_TIME_LIMIT_MS  stop the run after this much virtual time.
+ *  BOARD_DIAG_BUS_CYCLES     CPU cycles charged per register access
+ *                            (default 6).
+ *  BOARD_DIAG_UART_BPS       JTAG UART link speed in bytes per second
+ *                            (default 100000).
+ *  BOARD_DIAG_UART_LOOPBACK  if set, JTAG UART output is looped back to its
+ *                            input instead of going to stdout.
+ *  BOARD_DIAG_UART_PTY       connect the JTAG UART to a pseudo-terminal whose
+ *                            slave is symlinked to this path.
+ *  BOARD_DIAG_MEM_FAULTS     faults to inject into onchip_mem, e.g.
+ *                            "sa0:0x48000:3,ad:9"; see host_hal.c.
+ *  BOARD_DIAG_BIT_FLIPS      bit flips to inject into PIO data register
+ *                            accesses, e.g. "red_led:w:1000"; see
+ *                            host_hal.c.
+ *  BOARD_DIAG_PIO_LOG        write "<cycle> <device> 0x<value>" to this
+ *                            file for every output PIO write.
+ */
+
+#ifndef __HOST_HAL_H__
+#define __HOST_HAL_H__
+
+#define BOARD_DIAG_HOST 1
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "alt_types.h"
+
+/* Simulation control and inspection. */
+extern alt_u64 host_hal_cycles( void );
+extern alt_u64 host_hal_time_us( void );
+extern void host_hal_advance( alt_u64 cycles );
+extern int host_hal_script_add( alt_u64 time_us, alt_u32 base, alt_u32 value );
+extern alt_u32 host_hal_peek( alt_u32 base, alt_u32 regnum );
+extern alt_u32 host_hal_reads( alt_u32 base, alt_u32 regnum );
+extern alt_u32 host_hal_writes( alt_u32 base, alt_u32 regnum );
+extern void host_hal_dump_stats( FILE* out );
+extern void host_hal_exit( const char* reason );
+
+/* C library services redirected into the simulation. */
+extern int host_usleep( unsigned int us );
+extern FILE* host_fopen( const char* path, const char* mode );
+extern int host_getc( FILE* stream );
+extern int host_open( const char* path, int flags, ... );
+extern ssize_t host_read( int fd, void* buf, size_t size );
+extern ssize_t host_write( int fd, const void* buf, size_t size );
+extern int host_close( int fd );
+
+#undef getc
+#define usleep(us)        host_usleep(us)
+#define fopen(path, mode) host_fopen(path, mode)
+#define getc(stream)      host_getc(stream)
+#define open(...)         host_open(__VA_ARGS__)
+#define read(fd, b, n)    host_read(fd, b, n)
+#define write(fd, b, n)   host_write(fd, b, n)
+#define close(fd)         host_close(fd)
+
+#endif /* __HOST_HAL_H__ */
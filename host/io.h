@@ -0,0 +1,28 @@
+/*
+ * io.h - host stand-in for the Nios II HAL io.h.
+ *
+ * Every IORD/IOWR lands in the simulated register file in host_hal.c instead
+ * of issuing an ldwio/stwio on the Avalon bus; IORD_32DIRECT/IOWR_32DIRECT
+ * also reach the simulated on-chip memory.
+ */
+
+#ifndef __IO_H__
+#define __IO_H__
+
+#include "alt_types.h"
+
+extern alt_u32 host_hal_read( alt_u32 base, alt_u32 regnum );
+extern void host_hal_write( alt_u32 base, alt_u32 regnum, alt_u32 data );
+extern alt_u32 host_hal_read32( alt_u32 addr );
+extern void host_hal_write32( alt_u32 addr, alt_u32 data );
+
+#define __IO_CALC_ADDRESS_NATIVE(BASE, REGNUM) \
+  ((void *)(((alt_u8*)(unsigned long)(BASE)) + ((REGNUM) * 4)))
+
+#define IORD(BASE, REGNUM)       host_hal_read((BASE), (REGNUM))
+#define IOWR(BASE, REGNUM, DATA) host_hal_write((BASE), (REGNUM), (DATA))
+
+#define IORD_32DIRECT(BASE, OFFSET)       host_hal_read32((BASE) + (OFFSET))
+#define IOWR_32DIRECT(BASE, OFFSET, DATA) host_hal_write32((BASE) + (OFFSET), (DATA))
+
+#endif /* __IO_H__ */
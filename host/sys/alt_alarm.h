@@ -0,0 +1,42 @@
+/*
+ * sys/alt_alarm.h - host stand-in for the HAL system clock and alarm API.
+ *
+ * host_hal.c plays the part of the HAL's sys_clk_timer driver: it counts
+ * _alt_nticks and runs expired alarms from "interrupt context" whenever the
+ * simulated timer times out.
+ */
+
+#ifndef __ALT_ALARM_H__
+#define __ALT_ALARM_H__
+
+#include "alt_types.h"
+
+typedef struct alt_alarm_s alt_alarm;
+
+struct alt_alarm_s
+{
+  alt_alarm* next;
+  alt_u32 time;
+  alt_u32 (*callback) (void* context);
+  void* context;
+  int active;
+};
+
+extern int alt_alarm_start( alt_alarm* the_alarm, alt_u32 nticks,
+  alt_u32 (*callback) (void* context), void* context );
+extern void alt_alarm_stop( alt_alarm* the_alarm );
+
+extern volatile alt_u32 _alt_tick_rate;
+extern volatile alt_u32 _alt_nticks;
+
+static ALT_INLINE alt_u32 ALT_ALWAYS_INLINE alt_ticks_per_second( void )
+{
+  return _alt_tick_rate;
+}
+
+static ALT_INLINE alt_u32 ALT_ALWAYS_INLINE alt_nticks( void )
+{
+  return _alt_nticks;
+}
+
+#endif /* __ALT_ALARM_H__ */
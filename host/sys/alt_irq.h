@@ -0,0 +1,32 @@
+/*
+ * sys/alt_irq.h - host stand-in for the HAL interrupt API.
+ *
+ * Both the enhanced (alt_ic_*) and the legacy (alt_irq_register) API are
+ * provided; host_hal.c invokes registered handlers when a simulated device
+ * raises its IRQ.
+ */
+
+#ifndef __ALT_IRQ_H__
+#define __ALT_IRQ_H__
+
+#include "alt_types.h"
+#include "system.h"
+
+typedef int alt_irq_context;
+
+#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
+typedef void (*alt_isr_func)(void* isr_context);
+#else
+typedef void (*alt_isr_func)(void* isr_context, alt_u32 id);
+#endif
+
+extern int alt_ic_isr_register( alt_u32 ic_id, alt_u32 irq, alt_isr_func isr,
+  void *isr_context, void *flags );
+extern int alt_ic_irq_enable( alt_u32 ic_id, alt_u32 irq );
+extern int alt_ic_irq_disable( alt_u32 ic_id, alt_u32 irq );
+extern int alt_irq_register( alt_u32 id, void* context, alt_isr_func handler );
+
+extern alt_irq_context alt_irq_disable_all( void );
+extern void alt_irq_enable_all( alt_irq_context context );
+
+#endif /* __ALT_IRQ_H__ */
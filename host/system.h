@@ -0,0 +1,244 @@
+/*
+ * system.h - host stand-in for the BSP generated system.h.
+ *
+ * Mirrors the peripherals, base addresses and widths of de2i_150_qsys.qsys so
+ * that board_diag.c can be compiled and run on Linux against the simulated
+ * HAL in host_hal.c.  Only the definitions used by the diagnostics are
+ * provided.
+ *
+ * button_pio is given an edge capture interrupt, as board_diag.c has always
+ * expected; the .qsys currently generates the PIO without one.
+ */
+
+#ifndef __SYSTEM_H_
+#define __SYSTEM_H_
+
+/*
+ * CPU configuration
+ */
+
+#define ALT_CPU_NAME "cpu"
+#define ALT_CPU_FREQ 50000000
+#define NIOS2_CPU_FREQ 50000000
+#define NIOS2_DCACHE_SIZE 0
+#define NIOS2_ICACHE_SIZE 2048
+#define ALT_ENHANCED_INTERRUPT_API_PRESENT
+
+/*
+ * System configuration
+ */
+
+#define ALT_DEVICE_FAMILY "Cyclone IV GX"
+#define ALT_STDIN "/dev/jtag_uart"
+#define ALT_STDOUT "/dev/jtag_uart"
+#define ALT_STDERR "/dev/jtag_uart"
+#define ALT_SYS_CLK SYS_CLK_TIMER
+#define ALT_TIMESTAMP_CLK none
+
+/*
+ * button_pio configuration
+ */
+
+#define ALT_MODULE_CLASS_button_pio altera_avalon_pio
+#define BUTTON_PIO_BASE 0x81050
+#define BUTTON_PIO_NAME "/dev/button_pio"
+#define BUTTON_PIO_BIT_CLEARING_EDGE_REGISTER 0
+#define BUTTON_PIO_BIT_MODIFYING_OUTPUT_REGISTER 0
+#define BUTTON_PIO_CAPTURE 1
+#define BUTTON_PIO_DATA_WIDTH 18
+#define BUTTON_PIO_DO_TEST_BENCH_WIRING 0
+#define BUTTON_PIO_EDGE_TYPE "RISING"
+#define BUTTON_PIO_FREQ 50000000
+#define BUTTON_PIO_HAS_IN 1
+#define BUTTON_PIO_HAS_OUT 0
+#define BUTTON_PIO_IRQ 2
+#define BUTTON_PIO_IRQ_INTERRUPT_CONTROLLER_ID 0
+#define BUTTON_PIO_IRQ_TYPE "EDGE"
+#define BUTTON_PIO_RESET_VALUE 0x0
+#define BUTTON_PIO_SPAN 16
+
+/*
+ * jtag_uart configuration
+ */
+
+#define ALT_MODULE_CLASS_jtag_uart altera_avalon_jtag_uart
+#define JTAG_UART_BASE 0x81098
+#define JTAG_UART_IRQ 16
+#define JTAG_UART_IRQ_INTERRUPT_CONTROLLER_ID 0
+#define JTAG_UART_NAME "/dev/jtag_uart"
+#define JTAG_UART_READ_DEPTH 64
+#define JTAG_UART_READ_THRESHOLD 8
+#define JTAG_UART_SPAN 8
+#define JTAG_UART_WRITE_DEPTH 64
+#define JTAG_UART_WRITE_THRESHOLD 8
+
+/*
+ * key configuration
+ */
+
+#define ALT_MODULE_CLASS_key altera_avalon_pio
+#define KEY_BASE 0x81020
+#define KEY_NAME "/dev/key"
+#define KEY_BIT_CLEARING_EDGE_REGISTER 0
+#define KEY_BIT_MODIFYING_OUTPUT_REGISTER 0
+#define KEY_CAPTURE 0
+#define KEY_DATA_WIDTH 4
+#define KEY_DO_TEST_BENCH_WIRING 0
+#define KEY_EDGE_TYPE "NONE"
+#define KEY_FREQ 50000000
+#define KEY_HAS_IN 1
+#define KEY_HAS_OUT 0
+#define KEY_IRQ -1
+#define KEY_IRQ_INTERRUPT_CONTROLLER_ID -1
+#define KEY_IRQ_TYPE "NONE"
+#define KEY_RESET_VALUE 0x0
+#define KEY_SPAN 16
+
+/*
+ * lcd_display configuration
+ */
+
+#define ALT_MODULE_CLASS_lcd_display altera_avalon_lcd_16207
+#define LCD_DISPLAY_BASE 0x81080
+#define LCD_DISPLAY_IRQ -1
+#define LCD_DISPLAY_IRQ_INTERRUPT_CONTROLLER_ID -1
+#define LCD_DISPLAY_NAME "/dev/lcd_display"
+#define LCD_DISPLAY_SPAN 16
+
+/*
+ * led_pio configuration
+ */
+
+#define ALT_MODULE_CLASS_led_pio altera_avalon_pio
+#define LED_PIO_BASE 0x81070
+#define LED_PIO_NAME "/dev/led_pio"
+#define LED_PIO_BIT_CLEARING_EDGE_REGISTER 0
+#define LED_PIO_BIT_MODIFYING_OUTPUT_REGISTER 0
+#define LED_PIO_CAPTURE 0
+#define LED_PIO_DATA_WIDTH 8
+#define LED_PIO_DO_TEST_BENCH_WIRING 0
+#define LED_PIO_EDGE_TYPE "NONE"
+#define LED_PIO_FREQ 50000000
+#define LED_PIO_HAS_IN 0
+#define LED_PIO_HAS_OUT 1
+#define LED_PIO_IRQ -1
+#define LED_PIO_IRQ_INTERRUPT_CONTROLLER_ID -1
+#define LED_PIO_IRQ_TYPE "NONE"
+#define LED_PIO_RESET_VALUE 0x0
+#define LED_PIO_SPAN 16
+
+/*
+ * onchip_mem configuration
+ */
+
+#define ALT_MODULE_CLASS_onchip_mem altera_avalon_onchip_memory2
+#define ONCHIP_MEM_BASE 0x40000
+#define ONCHIP_MEM_DATA_WIDTH 32
+#define ONCHIP_MEM_IRQ -1
+#define ONCHIP_MEM_NAME "/dev/onchip_mem"
+#define ONCHIP_MEM_SIZE_VALUE 200480
+#define ONCHIP_MEM_SPAN 200480
+
+/*
+ * red_led configuration
+ */
+
+#define ALT_MODULE_CLASS_red_led altera_avalon_pio
+#define RED_LED_BASE 0x81030
+#define RED_LED_NAME "/dev/red_led"
+#define RED_LED_BIT_CLEARING_EDGE_REGISTER 0
+#define RED_LED_BIT_MODIFYING_OUTPUT_REGISTER 0
+#define RED_LED_CAPTURE 0
+#define RED_LED_DATA_WIDTH 18
+#define RED_LED_DO_TEST_BENCH_WIRING 0
+#define RED_LED_EDGE_TYPE "NONE"
+#define RED_LED_FREQ 50000000
+#define RED_LED_HAS_IN 0
+#define RED_LED_HAS_OUT 1
+#define RED_LED_IRQ -1
+#define RED_LED_IRQ_INTERRUPT_CONTROLLER_ID -1
+#define RED_LED_IRQ_TYPE "NONE"
+#define RED_LED_RESET_VALUE 0x0
+#define RED_LED_SPAN 16
+
+/*
+ * seven_seg_pio configuration
+ */
+
+#define ALT_MODULE_CLASS_seven_seg_pio altera_avalon_pio
+#define SEVEN_SEG_PIO_BASE 0x81060
+#define SEVEN_SEG_PIO_NAME "/dev/seven_seg_pio"
+#define SEVEN_SEG_PIO_BIT_CLEARING_EDGE_REGISTER 0
+#define SEVEN_SEG_PIO_BIT_MODIFYING_OUTPUT_REGISTER 0
+#define SEVEN_SEG_PIO_CAPTURE 0
+#define SEVEN_SEG_PIO_DATA_WIDTH 28
+#define SEVEN_SEG_PIO_DO_TEST_BENCH_WIRING 0
+#define SEVEN_SEG_PIO_EDGE_TYPE "NONE"
+#define SEVEN_SEG_PIO_FREQ 50000000
+#define SEVEN_SEG_PIO_HAS_IN 0
+#define SEVEN_SEG_PIO_HAS_OUT 1
+#define SEVEN_SEG_PIO_IRQ -1
+#define SEVEN_SEG_PIO_IRQ_INTERRUPT_CONTROLLER_ID -1
+#define SEVEN_SEG_PIO_IRQ_TYPE "NONE"
+#define SEVEN_SEG_PIO_RESET_VALUE 0x0
+#define SEVEN_SEG_PIO_SPAN 16
+
+/*
+ * seven_seg_pio_1 configuration
+ */
+
+#define ALT_MODULE_CLASS_seven_seg_pio_1 altera_avalon_pio
+#define SEVEN_SEG_PIO_1_BASE 0x81040
+#define SEVEN_SEG_PIO_1_NAME "/dev/seven_seg_pio_1"
+#define SEVEN_SEG_PIO_1_BIT_CLEARING_EDGE_REGISTER 0
+#define SEVEN_SEG_PIO_1_BIT_MODIFYING_OUTPUT_REGISTER 0
+#define SEVEN_SEG_PIO_1_CAPTURE 0
+#define SEVEN_SEG_PIO_1_DATA_WIDTH 28
+#define SEVEN_SEG_PIO_1_DO_TEST_BENCH_WIRING 0
+#define SEVEN_SEG_PIO_1_EDGE_TYPE "NONE"
+#define SEVEN_SEG_PIO_1_FREQ 50000000
+#define SEVEN_SEG_PIO_1_HAS_IN 0
+#define SEVEN_SEG_PIO_1_HAS_OUT 1
+#define SEVEN_SEG_PIO_1_IRQ -1
+#define SEVEN_SEG_PIO_1_IRQ_INTERRUPT_CONTROLLER_ID -1
+#define SEVEN_SEG_PIO_1_IRQ_TYPE "NONE"
+#define SEVEN_SEG_PIO_1_RESET_VALUE 0x0
+#define SEVEN_SEG_PIO_1_SPAN 16
+
+/*
+ * sys_clk_timer configuration
+ */
+
+#define ALT_MODULE_CLASS_sys_clk_timer altera_avalon_timer
+#define SYS_CLK_TIMER_ALWAYS_RUN 0
+#define SYS_CLK_TIMER_BASE 0x81000
+#define SYS_CLK_TIMER_COUNTER_SIZE 32
+#define SYS_CLK_TIMER_FIXED_PERIOD 0
+#define SYS_CLK_TIMER_FREQ 50000000
+#define SYS_CLK_TIMER_IRQ 1
+#define SYS_CLK_TIMER_IRQ_INTERRUPT_CONTROLLER_ID 0
+#define SYS_CLK_TIMER_LOAD_VALUE 49999
+#define SYS_CLK_TIMER_MULT 0.001
+#define SYS_CLK_TIMER_NAME "/dev/sys_clk_timer"
+#define SYS_CLK_TIMER_PERIOD 1
+#define SYS_CLK_TIMER_PERIOD_UNITS "ms"
+#define SYS_CLK_TIMER_RESET_OUTPUT 0
+#define SYS_CLK_TIMER_SNAPSHOT 1
+#define SYS_CLK_TIMER_SPAN 32
+#define SYS_CLK_TIMER_TICKS_PER_SEC 1000
+#define SYS_CLK_TIMER_TIMEOUT_PULSE_OUTPUT 0
+
+/*
+ * sysid configuration
+ */
+
+#define ALT_MODULE_CLASS_sysid altera_avalon_sysid_qsys
+#define SYSID_BASE 0x81090
+#define SYSID_ID 0
+#define SYSID_IRQ -1
+#define SYSID_IRQ_INTERRUPT_CONTROLLER_ID -1
+#define SYSID_NAME "/dev/sysid"
+#define SYSID_SPAN 8
+#define SYSID_TIMESTAMP 0
+
+#endif /* __SYSTEM_H_ */
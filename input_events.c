@@ -0,0 +1,382 @@
+/******************************************************************************
+ *
+ * input_events.c
+ *
+ * Timestamped edge events from the key and button_pio PIOs.
+ * See input_events.h.
+ *
+ * The ring is single-producer/single-consumer: every producer runs in
+ * interrupt context and Nios II interrupts do not nest, so the PIO ISR and
+ * the tick sampler never interleave; the only consumer is the main loop.
+ * The producer owns input_head, the consumer owns input_tail, and each side
+ * only publishes its index after the slot itself has been written or read.
+ *
+ * The snapshot is built on the same side: the producers gather edges, the
+ * tick moves them into the latched snapshot with the levels, and the main
+ * loop takes it with interrupts off.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "cpu_load.h"
+#include "input_events.h"
+#include "bus_prof.h"
+#include "io_trace.h"
+
+#define INPUT_QUEUE_MASK (INPUT_EVENT_QUEUE_SIZE - 1)
+
+#if (INPUT_EVENT_QUEUE_SIZE & INPUT_QUEUE_MASK) != 0
+#error "INPUT_EVENT_QUEUE_SIZE must be a power of two"
+#endif
+
+/* Keep the compiler from moving slot accesses across an index update. */
+#define INPUT_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+
+#define INPUT_WIDTH_MASK(w) ((alt_u32)((1ULL << (w)) - 1))
+
+struct input_source
+{
+  alt_u32 base;
+  alt_u32 mask;
+  int ic;
+  int irq;
+  const char* edge_type;
+  int polled;           /* sampled on the tick as well */
+  volatile alt_u32 state;
+};
+
+static struct input_source input_src[INPUT_NUM_SRC] =
+{
+#ifdef KEY_BASE
+  { KEY_BASE, INPUT_WIDTH_MASK(KEY_DATA_WIDTH),
+    KEY_IRQ_INTERRUPT_CONTROLLER_ID, KEY_IRQ, KEY_EDGE_TYPE, 0, 0 },
+#else
+  { 0, 0, -1, -1, "NONE", 0, 0 },
+#endif
+#ifdef BUTTON_PIO_BASE
+  { BUTTON_PIO_BASE, INPUT_WIDTH_MASK(BUTTON_PIO_DATA_WIDTH),
+    BUTTON_PIO_IRQ_INTERRUPT_CONTROLLER_ID, BUTTON_PIO_IRQ, BUTTON_PIO_EDGE_TYPE,
+    0, 0 },
+#else
+  { 0, 0, -1, -1, "NONE", 0, 0 },
+#endif
+};
+
+static struct input_event input_ring[INPUT_EVENT_QUEUE_SIZE];
+static volatile alt_u32 input_head;
+static volatile alt_u32 input_tail;
+static volatile alt_u32 input_lost;
+static struct input_latency input_lat;
+static input_edge_fn input_edge_hook;
+static struct input_snapshot input_snap;
+static alt_u32 input_acc_rising[INPUT_NUM_SRC];  /* edges since the last latch */
+static alt_u32 input_acc_falling[INPUT_NUM_SRC];
+static alt_u64 input_acc_timestamp;
+static int input_acc_edges;
+static struct input_snapshot_stats input_snap_stats;
+
+/* Producer side: interrupt context only. */
+
+static void input_push( const struct input_event* ev )
+{
+  alt_u32 head = input_head;
+
+  if (head - input_tail >= INPUT_EVENT_QUEUE_SIZE)
+  {
+    input_lost++;
+    return;
+  }
+  input_ring[head & INPUT_QUEUE_MASK] = *ev;
+  INPUT_BARRIER();
+  input_head = head + 1;
+}
+
+/*
+ * Compare the PIO level against the last one seen and queue an event for any
+ * change.  'edges' are edge capture bits; a capture bit whose level is back
+ * where it was is a pulse shorter than the sampling interval and is reported
+ * as both a rising and a falling edge.  On a PIO that the tick samples as
+ * well, such a bit is more likely an edge the sampler got to first, so
+ * there it is ignored.
+ */
+static void input_sample( int id, alt_u32 edges )
+{
+  struct input_source* src = &input_src[id];
+  struct input_event ev;
+  alt_u32 level;
+  alt_u32 changed;
+  alt_u32 pulses;
+
+  level = IORD_ALTERA_AVALON_PIO_DATA(src->base) & src->mask;
+  input_snap_stats.reads++;
+  changed = level ^ src->state;
+  pulses = src->polled ? 0 : edges & src->mask & ~changed;
+  if (changed == 0 && pulses == 0)
+  {
+    return;
+  }
+
+  ev.timestamp = timer_now_cycles();
+  ev.state = level;
+  ev.rising = (changed & level) | pulses;
+  ev.falling = (changed & ~level) | pulses;
+  ev.source = id;
+  src->state = level;
+  if (!input_acc_edges)
+  {
+    input_acc_timestamp = ev.timestamp;
+    input_acc_edges = 1;
+  }
+  input_acc_rising[id] |= ev.rising;
+  input_acc_falling[id] |= ev.falling;
+  if (input_edge_hook != NULL)
+  {
+    input_edge_hook(&ev);
+  }
+  input_push(&ev);
+}
+
+/*******************************************************************
+ * static void handle_button_interrupts( void* context, alt_u32 id)*
+ *                                                                 *
+ * Handle edge capture interrupts from an input PIO.  *context is  *
+ * the input_source that raised it.  The edge capture register is  *
+ * read and cleared, and the new level is queued as an event.      *
+ ******************************************************************/
+#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
+static void handle_button_interrupts(void* context)
+#else
+static void handle_button_interrupts(void* context, alt_u32 id)
+#endif
+{
+  struct input_source* src = (struct input_source*) context;
+  alt_u64 begin = cpu_load_isr_begin();
+  alt_u32 edges;
+
+  edges = IORD_ALTERA_AVALON_PIO_EDGE_CAP(src->base);
+  IOWR_ALTERA_AVALON_PIO_EDGE_CAP(src->base, 0);
+  input_sample(src - input_src, edges);
+
+  /*
+   * Read the PIO to delay ISR exit. This is done to prevent a spurious
+   * interrupt in systems with high processor -> pio latency and fast
+   * interrupts.
+   */
+  IORD_ALTERA_AVALON_PIO_EDGE_CAP(src->base);
+  input_snap_stats.reads += 2;
+  cpu_load_isr_end(begin);
+}
+
+/*
+ * Tick hook: samples the PIOs that have no edge capture interrupt, and those
+ * whose interrupt only fires on one edge direction, so the other is not
+ * left waiting for an unrelated edge.  Then latches the snapshot, adding
+ * the edges gathered since the last tick to any the main loop has not
+ * taken yet.
+ */
+
+static void input_tick( void* context )
+{
+  int id;
+
+  (void) context;
+  for (id = 0; id < INPUT_NUM_SRC; id++)
+  {
+    if (input_src[id].polled)
+    {
+      input_sample(id, 0);
+    }
+  }
+
+  input_snap.frame++;
+  for (id = 0; id < INPUT_NUM_SRC; id++)
+  {
+    input_snap.current[id] = input_src[id].state;
+  }
+  if (input_acc_edges)
+  {
+    for (id = 0; id < INPUT_NUM_SRC; id++)
+    {
+      if (input_snap.rising[id] | input_snap.falling[id])
+      {
+        break;
+      }
+    }
+    if (id == INPUT_NUM_SRC)
+    {
+      input_snap.edge_timestamp = input_acc_timestamp;
+    }
+    for (id = 0; id < INPUT_NUM_SRC; id++)
+    {
+      input_snap.rising[id] |= input_acc_rising[id];
+      input_snap.falling[id] |= input_acc_falling[id];
+      input_acc_rising[id] = 0;
+      input_acc_falling[id] = 0;
+    }
+    input_acc_edges = 0;
+  }
+  input_snap_stats.frames++;
+}
+
+void input_events_init( void )
+{
+  int id;
+
+  for (id = 0; id < INPUT_NUM_SRC; id++)
+  {
+    struct input_source* src = &input_src[id];
+
+    if (src->mask == 0)
+    {
+      continue;
+    }
+    src->state = IORD_ALTERA_AVALON_PIO_DATA(src->base) & src->mask;
+    src->polled = src->irq < 0 || strcmp(src->edge_type, "ANY") != 0;
+    input_snap.current[id] = src->state;
+    if (src->irq < 0)
+    {
+      continue;
+    }
+
+    /* Enable every bit's interrupt and reset the edge capture register. */
+    IOWR_ALTERA_AVALON_PIO_IRQ_MASK(src->base, src->mask);
+    IOWR_ALTERA_AVALON_PIO_EDGE_CAP(src->base, 0x0);
+#ifdef ALT_ENHANCED_INTERRUPT_API_PRESENT
+    alt_ic_isr_register(src->ic, src->irq, handle_button_interrupts, src, 0x0);
+#else
+    alt_irq_register(src->irq, src, handle_button_interrupts);
+#endif
+  }
+
+  timer_add_tick_hook(input_tick, NULL);
+}
+
+void input_events_set_edge_hook( input_edge_fn fn )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  input_edge_hook = fn;
+  alt_irq_enable_all(irq);
+}
+
+/* Consumer side: main loop only. */
+
+int input_events_get( struct input_event* ev )
+{
+  alt_u32 tail = input_tail;
+
+  if (tail == input_head)
+  {
+    return 0;
+  }
+  INPUT_BARRIER();
+  *ev = input_ring[tail & INPUT_QUEUE_MASK];
+  INPUT_BARRIER();
+  input_tail = tail + 1;
+  return 1;
+}
+
+void input_events_flush( void )
+{
+  input_tail = input_head;
+}
+
+alt_u32 input_events_state( int source )
+{
+  return input_src[source].state;
+}
+
+alt_u32 input_events_dropped( void )
+{
+  return input_lost;
+}
+
+void input_events_snapshot( struct input_snapshot* out )
+{
+  alt_irq_context irq;
+  int id;
+
+  irq = alt_irq_disable_all();
+  *out = input_snap;
+  for (id = 0; id < INPUT_NUM_SRC; id++)
+  {
+    input_snap.rising[id] = 0;
+    input_snap.falling[id] = 0;
+  }
+  input_snap_stats.takes++;
+  alt_irq_enable_all(irq);
+}
+
+void input_events_snapshot_stats( struct input_snapshot_stats* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  *out = input_snap_stats;
+  alt_irq_enable_all(irq);
+}
+
+void input_events_reset_snapshot_stats( void )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  memset(&input_snap_stats, 0, sizeof(input_snap_stats));
+  alt_irq_enable_all(irq);
+}
+
+static void input_note_latency( alt_u64 since )
+{
+  alt_u32 us = (alt_u32)((timer_now_cycles() - since) / timer_cycles_per_us());
+
+  if (input_lat.count == 0 || us < input_lat.min_us)
+  {
+    input_lat.min_us = us;
+  }
+  if (us > input_lat.max_us)
+  {
+    input_lat.max_us = us;
+  }
+  input_lat.total_us += us;
+  input_lat.count++;
+}
+
+void input_events_note_reaction( const struct input_event* ev )
+{
+  input_note_latency(ev->timestamp);
+}
+
+void input_events_note_snapshot_reaction( const struct input_snapshot* snap )
+{
+  int id;
+
+  for (id = 0; id < INPUT_NUM_SRC; id++)
+  {
+    if (snap->rising[id] | snap->falling[id])
+    {
+      input_note_latency(snap->edge_timestamp);
+      return;
+    }
+  }
+}
+
+void input_events_latency( struct input_latency* out )
+{
+  *out = input_lat;
+}
+
+void input_events_reset_latency( void )
+{
+  input_lat.count = 0;
+  input_lat.min_us = 0;
+  input_lat.max_us = 0;
+  input_lat.total_us = 0;
+}
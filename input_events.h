@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ * input_events.h
+ *
+ * Timestamped edge events from the key and button_pio (switch) PIOs.
+ *
+ * Edges are captured in interrupt context and handed to the main loop through
+ * a lock-free single-producer/single-consumer ring, so a press that happens
+ * while the main loop is busy is queued instead of lost, and the main loop no
+ * longer issues an uncached Avalon read every time it wants to look at a key.
+ *
+ * A PIO generated with an edge capture interrupt is serviced from its ISR.  A
+ * PIO without one (key in de2i_150_qsys.qsys) is sampled on every system clock
+ * tick by the same producer code instead, and so is one that only captures
+ * one edge direction (button_pio captures rising edges), for the other.
+ *
+ * For code that looks at levels rather than edges, the tick also latches a
+ * snapshot of every source: the levels as of that tick, and the edges seen
+ * since the snapshot was last taken.  Everything that evaluates one
+ * snapshot sees the same switch and key state, however often it looks, and
+ * taking it costs no bus read; the only reads are the producer's, one per
+ * polled source per tick plus the ISR's.
+ *
+ ******************************************************************************/
+
+#ifndef __INPUT_EVENTS_H__
+#define __INPUT_EVENTS_H__
+
+#include "alt_types.h"
+
+/* Ring capacity; must be a power of two. */
+#define INPUT_EVENT_QUEUE_SIZE 32
+
+#define INPUT_SRC_KEY    0
+#define INPUT_SRC_SWITCH 1
+#define INPUT_NUM_SRC    2
+
+struct input_event
+{
+  alt_u64 timestamp;    /* timer_now_cycles() when the edge was captured */
+  alt_u32 state;        /* PIO data after the edge */
+  alt_u32 rising;       /* bits that went 0 -> 1 */
+  alt_u32 falling;      /* bits that went 1 -> 0 */
+  alt_u8  source;       /* INPUT_SRC_KEY or INPUT_SRC_SWITCH */
+};
+
+struct input_snapshot
+{
+  alt_u32 frame;                        /* ticks since input_events_init() */
+  alt_u32 current[INPUT_NUM_SRC];       /* levels */
+  alt_u32 rising[INPUT_NUM_SRC];        /* 0 -> 1 since the last take */
+  alt_u32 falling[INPUT_NUM_SRC];       /* 1 -> 0 since the last take */
+  alt_u64 edge_timestamp;               /* capture time of the oldest edge */
+};
+
+struct input_snapshot_stats
+{
+  alt_u32 frames;       /* snapshots latched, one per tick */
+  alt_u32 takes;        /* input_events_snapshot() calls */
+  alt_u32 reads;        /* input PIO reads, tick sampler and ISR */
+};
+
+struct input_latency
+{
+  alt_u32 count;
+  alt_u32 min_us;
+  alt_u32 max_us;
+  alt_u64 total_us;
+};
+
+/*
+ * Called in interrupt context with every event as it is captured, before it
+ * is queued; for drivers layered on the raw edges.
+ */
+typedef void (*input_edge_fn)( const struct input_event* ev );
+
+/* Enable edge capture on the input PIOs and start producing events. */
+void input_events_init( void );
+
+/* Set (or with NULL, clear) the edge hook. */
+void input_events_set_edge_hook( input_edge_fn fn );
+
+/* Pop the oldest event.  Returns 1 if one was available, 0 if empty. */
+int input_events_get( struct input_event* ev );
+
+/* Discard everything queued so far. */
+void input_events_flush( void );
+
+/* Level of a source as of the last edge the producer saw. */
+alt_u32 input_events_state( int source );
+
+/* Events lost because the ring was full. */
+alt_u32 input_events_dropped( void );
+
+/*
+ * Copy the latest snapshot and clear its edges, so the next take only
+ * reports edges that came after this one.  Main loop only.
+ */
+void input_events_snapshot( struct input_snapshot* out );
+
+void input_events_snapshot_stats( struct input_snapshot_stats* out );
+void input_events_reset_snapshot_stats( void );
+
+/*
+ * Press-to-reaction accounting: call once an event has been acted on to
+ * record the time since it was captured.
+ */
+void input_events_note_reaction( const struct input_event* ev );
+
+/* The same, for a snapshot whose edges have been acted on; none, no-op. */
+void input_events_note_snapshot_reaction( const struct input_snapshot* snap );
+void input_events_latency( struct input_latency* out );
+void input_events_reset_latency( void );
+
+#endif /* __INPUT_EVENTS_H__ */
@@ -0,0 +1,317 @@
+/******************************************************************************
+ *
+ * io_trace.c
+ *
+ * Peripheral write trace.  See io_trace.h.
+ *
+ * The ring is written with interrupts disabled, from the main loop and from
+ * the tick hooks alike.  'tail_base' is the time the oldest record's delta
+ * counts from; dropping a record adds its delta to it.
+ *
+ ******************************************************************************/
+
+#include "system.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "fmt.h"
+
+#define IO_TRACE_IMPL
+#include "io_trace.h"
+
+#ifdef IO_TRACE
+
+#define IO_TRACE_ESCAPE   15
+#define IO_TRACE_MAX_REC  (1 + 4 + 10 + 5)  /* header, escape, 64-bit and 32-bit LEB128 */
+#define IO_TRACE_LINE     32    /* data bytes per dump line */
+
+#define IO_TRACE_SLAVE(name, prefix, width) { name, prefix##_BASE, width }
+
+static const struct
+{
+  const char* name;
+  alt_u32 base;
+  int width;
+} io_trace_slaves[] =
+{
+#ifdef LED_PIO_BASE
+  IO_TRACE_SLAVE("led_pio", LED_PIO, LED_PIO_DATA_WIDTH),
+#endif
+#ifdef RED_LED_BASE
+  IO_TRACE_SLAVE("red_led", RED_LED, RED_LED_DATA_WIDTH),
+#endif
+#ifdef SEVEN_SEG_PIO_BASE
+  IO_TRACE_SLAVE("seven_seg_pio", SEVEN_SEG_PIO, SEVEN_SEG_PIO_DATA_WIDTH),
+#endif
+#ifdef SEVEN_SEG_PIO_1_BASE
+  IO_TRACE_SLAVE("seven_seg_pio_1", SEVEN_SEG_PIO_1, SEVEN_SEG_PIO_1_DATA_WIDTH),
+#endif
+#ifdef KEY_BASE
+  IO_TRACE_SLAVE("key", KEY, KEY_DATA_WIDTH),
+#endif
+#ifdef BUTTON_PIO_BASE
+  IO_TRACE_SLAVE("button_pio", BUTTON_PIO, BUTTON_PIO_DATA_WIDTH),
+#endif
+#ifdef LCD_DISPLAY_BASE
+  IO_TRACE_SLAVE("lcd_display", LCD_DISPLAY, 8),
+#endif
+#ifdef SYS_CLK_TIMER_BASE
+  IO_TRACE_SLAVE("sys_clk_timer", SYS_CLK_TIMER, 16),
+#endif
+};
+
+#define IO_TRACE_NUM_SLAVES ((int)(sizeof(io_trace_slaves) / sizeof(io_trace_slaves[0])))
+
+/* Fails to compile when the slaves no longer fit the record's four bits. */
+typedef char io_trace_slaves_fit[IO_TRACE_NUM_SLAVES <= IO_TRACE_MAX_SLAVES ? 1 : -1];
+
+volatile int io_trace_on;
+
+static alt_u8 io_trace_ring[IO_TRACE_BYTES];
+static alt_u32 io_trace_head;       /* next byte to write */
+static alt_u32 io_trace_tail;       /* oldest record */
+static alt_u32 io_trace_used;
+static alt_u64 io_trace_tail_base;
+static alt_u64 io_trace_last;       /* time of the newest record */
+static alt_u32 io_trace_records;
+static alt_u32 io_trace_dropped;
+
+static int io_trace_slave( alt_u32 base )
+{
+  int i;
+
+  for (i = 0; i < IO_TRACE_NUM_SLAVES; i++)
+  {
+    if (io_trace_slaves[i].base == base)
+    {
+      return i;
+    }
+  }
+  return IO_TRACE_ESCAPE;
+}
+
+static alt_u8* io_trace_leb( alt_u8* p, alt_u64 v )
+{
+  while (v >= 0x80)
+  {
+    *p++ = (alt_u8)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (alt_u8) v;
+  return p;
+}
+
+static alt_u8 io_trace_byte( alt_u32 pos )
+{
+  return io_trace_ring[pos % IO_TRACE_BYTES];
+}
+
+/* Drop the oldest record, folding its delta into the time base. */
+static void io_trace_drop( void )
+{
+  alt_u32 pos = io_trace_tail;
+  alt_u64 delta = 0;
+  int shift = 0;
+  alt_u8 b;
+
+  if ((io_trace_byte(pos++) & 0x0f) == IO_TRACE_ESCAPE)
+  {
+    pos += 4;
+  }
+  do
+  {
+    b = io_trace_byte(pos++);
+    delta |= (alt_u64)(b & 0x7f) << shift;
+    shift += 7;
+  }
+  while (b & 0x80);
+  while (io_trace_byte(pos++) & 0x80)
+  {
+  }
+
+  io_trace_tail_base += delta;
+  io_trace_used -= pos - io_trace_tail;
+  io_trace_tail = pos % IO_TRACE_BYTES;
+  io_trace_records--;
+  io_trace_dropped++;
+}
+
+void io_trace_record( alt_u32 base, alt_u32 reg, alt_u32 data )
+{
+  alt_u8 rec[IO_TRACE_MAX_REC];
+  alt_u8* p = rec;
+  alt_irq_context irq;
+  alt_u64 now;
+  alt_u32 len, i;
+  int slave;
+
+  irq = alt_irq_disable_all();
+  now = timer_now_cycles();
+  slave = io_trace_slave(base);
+  *p++ = (alt_u8)(slave | ((reg & 7) << 4));
+  if (slave == IO_TRACE_ESCAPE)
+  {
+    for (i = 0; i < 4; i++)
+    {
+      *p++ = (alt_u8)(base >> (8 * i));
+    }
+  }
+  p = io_trace_leb(p, now - io_trace_last);
+  p = io_trace_leb(p, data);
+  io_trace_last = now;
+
+  len = p - rec;
+  while (io_trace_used + len > IO_TRACE_BYTES)
+  {
+    io_trace_drop();
+  }
+  for (i = 0; i < len; i++)
+  {
+    io_trace_ring[io_trace_head] = rec[i];
+    io_trace_head = (io_trace_head + 1) % IO_TRACE_BYTES;
+  }
+  io_trace_used += len;
+  io_trace_records++;
+  alt_irq_enable_all(irq);
+}
+
+void io_trace_clear( void )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  io_trace_head = 0;
+  io_trace_tail = 0;
+  io_trace_used = 0;
+  io_trace_records = 0;
+  io_trace_dropped = 0;
+  io_trace_last = timer_now_cycles();
+  io_trace_tail_base = io_trace_last;
+  alt_irq_enable_all(irq);
+}
+
+void io_trace_init( void )
+{
+  io_trace_clear();
+  io_trace_start();
+}
+
+void io_trace_start( void )
+{
+  io_trace_on = 1;
+}
+
+void io_trace_stop( void )
+{
+  io_trace_on = 0;
+}
+
+int io_trace_available( void )
+{
+  return 1;
+}
+
+int io_trace_running( void )
+{
+  return io_trace_on;
+}
+
+void io_trace_get_stats( struct io_trace_stats* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  out->records = io_trace_records;
+  out->dropped = io_trace_dropped;
+  out->bytes = io_trace_used;
+  alt_irq_enable_all(irq);
+}
+
+/* fmt has 32-bit conversions only: a cycle count in decimal, in two parts. */
+static void io_trace_cycles( char* buf, int size, alt_u64 cycles )
+{
+  alt_u32 hi = (alt_u32)(cycles / 1000000000);
+  alt_u32 lo = (alt_u32)(cycles % 1000000000);
+
+  if (hi != 0)
+    fmt_format(buf, size, "%lu%09lu", (unsigned long) hi, (unsigned long) lo);
+  else
+    fmt_format(buf, size, "%lu", (unsigned long) lo);
+}
+
+void io_trace_dump( void )
+{
+  int was_on = io_trace_on;
+  alt_u32 i, n;
+  char t0[24], t1[24];
+  int s;
+
+  io_trace_on = 0;
+  io_trace_cycles(t0, sizeof(t0), io_trace_tail_base);
+  io_trace_cycles(t1, sizeof(t1), timer_now_cycles());
+  fmt_print("TRACE begin cpu_hz=%lu t0=%s t1=%s records=%lu dropped=%lu bytes=%lu\n",
+    (unsigned long) ALT_CPU_FREQ, t0, t1, (unsigned long) io_trace_records,
+    (unsigned long) io_trace_dropped, (unsigned long) io_trace_used);
+  for (s = 0; s < IO_TRACE_NUM_SLAVES; s++)
+  {
+    fmt_print("TRACE slave %d %s 0x%lx %d\n", s, io_trace_slaves[s].name,
+      (unsigned long) io_trace_slaves[s].base, io_trace_slaves[s].width);
+  }
+  for (i = 0; i < io_trace_used; i += n)
+  {
+    n = io_trace_used - i < IO_TRACE_LINE ? io_trace_used - i : IO_TRACE_LINE;
+    fmt_puts("TRACE data ");
+    for (s = 0; s < (int) n; s++)
+    {
+      fmt_print("%02x", io_trace_byte(io_trace_tail + i + s));
+    }
+    fmt_putc('\n');
+  }
+  fmt_puts("TRACE end\n");
+  fmt_flush();
+  io_trace_on = was_on;
+}
+
+#else
+
+void io_trace_init( void )
+{
+}
+
+void io_trace_start( void )
+{
+}
+
+void io_trace_stop( void )
+{
+}
+
+void io_trace_clear( void )
+{
+}
+
+int io_trace_available( void )
+{
+  return 0;
+}
+
+int io_trace_running( void )
+{
+  return 0;
+}
+
+void io_trace_get_stats( struct io_trace_stats* out )
+{
+  out->records = 0;
+  out->dropped = 0;
+  out->bytes = 0;
+}
+
+void io_trace_dump( void )
+{
+  fmt_print("\nThe peripheral write trace is not built in; rebuild with -DIO_TRACE.\n");
+  fmt_flush();
+}
+
+#endif /* IO_TRACE */
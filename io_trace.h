@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ * io_trace.h
+ *
+ * Peripheral write trace: a ring of every IOWR the firmware makes, kept for
+ * dumping when a board misbehaves.
+ *
+ * Built with IO_TRACE defined, this header takes over IOWR in every file
+ * that includes it after bus_prof.h, as bus_prof.h does for profiling, and
+ * each write is recorded before it is made.  Built without IO_TRACE it
+ * changes nothing and the functions below are empty.
+ *
+ * A record is one to twenty bytes:
+ *
+ *   byte 0     bits 0-3 slave number in the dump's slave list (15: the
+ *              base address follows as four bytes, low byte first),
+ *              bits 4-6 register number, bit 7 zero
+ *   delta      CPU cycles since the previous record, LEB128
+ *   value      the value written, LEB128
+ *
+ * so a write to an LED or digit PIO a few milliseconds after the one
+ * before takes five to eight bytes.  The ring is a static array, in
+ * onchip_mem with the rest of the program; when it is full the oldest
+ * records are dropped whole and their deltas folded into the time base,
+ * so the dump always starts at a record boundary with an absolute time.
+ *
+ * The dump is text, so it survives nios2-terminal and a log file:
+ *
+ *   TRACE begin cpu_hz=<hz> t0=<cycles> t1=<cycles> records=<n>
+ *               dropped=<n> bytes=<n>             (one line)
+ *   TRACE slave <number> <name> 0x<base> <width>
+ *   TRACE data <up to 32 bytes in hex>
+ *   TRACE end
+ *
+ * t0 is the time the first record's delta counts from and t1 the time the
+ * dump started, both in CPU cycles since start-up; writes made while the
+ * dump is printed are not recorded.
+ *
+ * tools/trace_replay.py decodes it.  timer_service does not include this
+ * header, so reading the clock for a timestamp is not itself traced, and
+ * the JTAG UART, and the LCD when written through /dev/lcd_display, are
+ * written inside the HAL drivers and not seen.  lcd_16207's writes are.
+ *
+ ******************************************************************************/
+
+#ifndef __IO_TRACE_H__
+#define __IO_TRACE_H__
+
+#include "alt_types.h"
+
+#ifndef IO_TRACE_BYTES
+#define IO_TRACE_BYTES 8192
+#endif
+
+#define IO_TRACE_MAX_SLAVES 15  /* numbered slaves; others carry their base */
+
+struct io_trace_stats
+{
+  alt_u32 records;      /* in the ring */
+  alt_u32 dropped;      /* overwritten since the last clear */
+  alt_u32 bytes;        /* of the ring in use */
+};
+
+/* Start tracing, from main() before the first peripheral write. */
+void io_trace_init( void );
+
+void io_trace_start( void );
+void io_trace_stop( void );
+void io_trace_clear( void );
+
+/* 1 if the trace is compiled in. */
+int io_trace_available( void );
+int io_trace_running( void );
+
+void io_trace_get_stats( struct io_trace_stats* out );
+
+/* Print the ring in the format above; tracing pauses while it is printed. */
+void io_trace_dump( void );
+
+#ifdef IO_TRACE
+
+#include "io.h"
+#include "bus_prof.h"
+
+/* The write the trace hands on to: the profiler's, or the HAL's own. */
+#if defined(BUS_PROF)
+#define IO_TRACE_IOWR(b, r, d) bus_prof_wr((b), (r), (d))
+#elif defined(BOARD_DIAG_HOST)
+#define IO_TRACE_IOWR(b, r, d) host_hal_write((b), (r), (d))
+#else
+#define IO_TRACE_IOWR(b, r, d) __builtin_stwio(__IO_CALC_ADDRESS_NATIVE((b), (r)), (d))
+#endif
+
+extern volatile int io_trace_on;
+
+void io_trace_record( alt_u32 base, alt_u32 reg, alt_u32 data );
+
+static ALT_INLINE void ALT_ALWAYS_INLINE io_trace_wr( alt_u32 base, alt_u32 reg,
+                                                      alt_u32 data )
+{
+  if (__builtin_expect(io_trace_on, 1))
+  {
+    io_trace_record(base, reg, data);
+  }
+  IO_TRACE_IOWR(base, reg, data);
+}
+
+#ifndef IO_TRACE_IMPL
+#undef IOWR
+#define IOWR(BASE, REGNUM, DATA) io_trace_wr((BASE), (REGNUM), (DATA))
+#endif
+
+#endif /* IO_TRACE */
+
+#endif /* __IO_TRACE_H__ */
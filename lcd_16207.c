@@ -0,0 +1,199 @@
+/******************************************************************************
+ *
+ * lcd_16207.c
+ *
+ * Direct register driver for the character LCD.  See lcd_16207.h.
+ *
+ * Every access waits for the busy flag first, so a command is never
+ * written while the previous one is still executing, and nothing waits
+ * longer than the controller needs.  The wait is charged to io_wait.  The
+ * HD44780 keeps one address counter for DDRAM and CGRAM; 'addr' is where
+ * the cursor is in DDRAM, so a glyph definition can put it back.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "altera_avalon_lcd_16207_regs.h"
+
+#include "cpu_load.h"
+#include "lcd_16207.h"
+#include "bus_prof.h"
+#include "io_trace.h"
+
+#ifdef LCD_DISPLAY_BASE
+#define LCD_BASE LCD_DISPLAY_BASE
+#else
+#define LCD_BASE 0              /* never accessed: lcd_16207_init() fails */
+#endif
+
+#define LCD_CMD_CLEAR       0x01
+#define LCD_CMD_ENTRY_INC   0x06        /* cursor moves right, no shift */
+#define LCD_CMD_DISPLAY_ON  0x0c        /* no cursor, no blink */
+#define LCD_CMD_FUNCTION    0x38        /* 8-bit bus, two lines, 5x8 font */
+#define LCD_CMD_CGRAM       0x40
+#define LCD_CMD_DDRAM       0x80
+
+#define LCD_ROW_ADDR(row)   ((row) ? 0x40 : 0x00)
+
+struct lcd_16207
+{
+  int ready;
+  int addr;                     /* DDRAM address of the cursor */
+  struct lcd_16207_stats stats;
+};
+
+static struct lcd_16207 lcd_hw;
+
+/* Poll until the controller is idle.  Returns 0, or -1 on a timeout. */
+
+static int lcd_16207_wait( void )
+{
+  alt_u32 polls = 0;
+  int prev = CPU_LOAD_BUSY;
+
+  while (IORD_ALTERA_AVALON_LCD_16207_STATUS(LCD_BASE) &
+         ALTERA_AVALON_LCD_16207_STATUS_BUSY_MSK)
+  {
+    if (polls == 0)
+    {
+      prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+    }
+    if (++polls >= LCD_16207_POLL_LIMIT)
+    {
+      lcd_hw.stats.timeouts++;
+      lcd_hw.ready = 0;
+      break;
+    }
+  }
+  if (polls > 0)
+  {
+    cpu_load_leave(prev);
+    lcd_hw.stats.polls += polls;
+    if (polls > lcd_hw.stats.max_polls)
+    {
+      lcd_hw.stats.max_polls = polls;
+    }
+  }
+  return lcd_hw.ready ? 0 : -1;
+}
+
+static void lcd_16207_command( alt_u32 cmd )
+{
+  if (!lcd_hw.ready || lcd_16207_wait() < 0)
+  {
+    return;
+  }
+  IOWR_ALTERA_AVALON_LCD_16207_COMMAND(LCD_BASE, cmd);
+  lcd_hw.stats.commands++;
+}
+
+/* The address counter after a data access, in two-line mode. */
+
+static int lcd_16207_next( int addr )
+{
+  addr++;
+  if (addr == 0x28)
+  {
+    addr = 0x40;
+  }
+  else if (addr == 0x68)
+  {
+    addr = 0x00;
+  }
+  return addr;
+}
+
+int lcd_16207_init( void )
+{
+#ifdef LCD_DISPLAY_BASE
+  lcd_hw.ready = 1;
+#endif
+  lcd_16207_command(LCD_CMD_FUNCTION);
+  lcd_16207_command(LCD_CMD_DISPLAY_ON);
+  lcd_16207_command(LCD_CMD_ENTRY_INC);
+  lcd_16207_clear();
+  return lcd_hw.ready ? 0 : -1;
+}
+
+int lcd_16207_ready( void )
+{
+  return lcd_hw.ready;
+}
+
+void lcd_16207_clear( void )
+{
+  lcd_16207_command(LCD_CMD_CLEAR);
+  lcd_hw.addr = 0;
+}
+
+void lcd_16207_goto( int row, int col )
+{
+  lcd_hw.addr = LCD_ROW_ADDR(row) + col;
+  lcd_16207_command(LCD_CMD_DDRAM | lcd_hw.addr);
+}
+
+void lcd_16207_write( const char* text, int n )
+{
+  while (n-- > 0)
+  {
+    if (!lcd_hw.ready || lcd_16207_wait() < 0)
+    {
+      return;
+    }
+    IOWR_ALTERA_AVALON_LCD_16207_DATA(LCD_BASE, (alt_u8) *text++);
+    lcd_hw.stats.data++;
+    lcd_hw.addr = lcd_16207_next(lcd_hw.addr);
+  }
+}
+
+void lcd_16207_puts( const char* text )
+{
+  lcd_16207_write(text, strlen(text));
+}
+
+void lcd_16207_read( int row, int col, char* out, int n )
+{
+  lcd_16207_goto(row, col);
+  while (n-- > 0)
+  {
+    if (!lcd_hw.ready || lcd_16207_wait() < 0)
+    {
+      *out++ = '\0';
+      continue;
+    }
+    *out++ = (char) IORD_ALTERA_AVALON_LCD_16207_DATA(LCD_BASE);
+    lcd_hw.stats.reads++;
+    lcd_hw.addr = lcd_16207_next(lcd_hw.addr);
+  }
+}
+
+void lcd_16207_define_glyph( int code, const alt_u8 rows[LCD_16207_GLYPH_ROWS] )
+{
+  int i;
+
+  lcd_16207_command(LCD_CMD_CGRAM | (code & (LCD_16207_GLYPHS - 1)) << 3);
+  for (i = 0; i < LCD_16207_GLYPH_ROWS; i++)
+  {
+    if (!lcd_hw.ready || lcd_16207_wait() < 0)
+    {
+      return;
+    }
+    IOWR_ALTERA_AVALON_LCD_16207_DATA(LCD_BASE, rows[i] & 0x1f);
+    lcd_hw.stats.data++;
+  }
+  /* Point the address counter back into DDRAM, at the cursor. */
+  lcd_16207_command(LCD_CMD_DDRAM | lcd_hw.addr);
+}
+
+void lcd_16207_get_stats( struct lcd_16207_stats* out )
+{
+  *out = lcd_hw.stats;
+}
+
+void lcd_16207_reset_stats( void )
+{
+  memset(&lcd_hw.stats, 0, sizeof(lcd_hw.stats));
+}
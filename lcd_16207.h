@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * lcd_16207.h
+ *
+ * Direct register driver for the 2x16 character LCD (lcd_display, an
+ * altera_avalon_lcd_16207 in front of an HD44780 controller).
+ *
+ * The HAL's /dev/lcd_display driver takes text through stdio, parses
+ * escapes into its own 2x80 buffer and repaints what changed, and for
+ * every byte it sends it polls the busy flag and then sleeps another
+ * 100 us.  This driver writes commands and DDRAM data straight to the
+ * controller's registers and only waits as long as the busy flag says:
+ * about 37 us per character, 1.52 ms for a clear.
+ *
+ * The HAL driver has already run the controller's power-on sequence by the
+ * time main() starts, so lcd_16207_init() only sets the modes this driver
+ * relies on.  Both drivers talk to the same controller: after writing
+ * through one, reset the display through the other before using it (see
+ * lcd_fb_set_direct()).
+ *
+ * Character codes 0-7 show the eight CGRAM glyphs; 8-15 show the same
+ * glyphs again, which is the way to put them in a C string.
+ *
+ ******************************************************************************/
+
+#ifndef __LCD_16207_H__
+#define __LCD_16207_H__
+
+#include "alt_types.h"
+
+#define LCD_16207_ROWS    2
+#define LCD_16207_COLS    16
+#define LCD_16207_GLYPHS  8
+#define LCD_16207_GLYPH_ROWS 8
+
+/* Status reads before a wait is given up and the display marked broken. */
+#define LCD_16207_POLL_LIMIT 100000
+
+struct lcd_16207_stats
+{
+  alt_u32 commands;
+  alt_u32 data;         /* characters and glyph rows written */
+  alt_u32 reads;        /* characters read back */
+  alt_u32 polls;        /* status reads that found the controller busy */
+  alt_u32 max_polls;    /* longest single wait, in status reads */
+  alt_u32 timeouts;
+};
+
+/*
+ * Set 8-bit, two-line mode, display on with no cursor, left-to-right
+ * entry, and clear.  Returns 0, or -1 if the busy flag never clears.
+ */
+int lcd_16207_init( void );
+
+/* 1 after a successful lcd_16207_init() and no timeout since. */
+int lcd_16207_ready( void );
+
+void lcd_16207_clear( void );
+
+/* Move the cursor; the next character goes to 'row', 'col' (0-based). */
+void lcd_16207_goto( int row, int col );
+
+/* Write 'n' characters at the cursor, which advances past them. */
+void lcd_16207_write( const char* text, int n );
+void lcd_16207_puts( const char* text );
+
+/*
+ * Read 'n' characters back from 'row', 'col' into 'out'.  Leaves the
+ * cursor after them.
+ */
+void lcd_16207_read( int row, int col, char* out, int n );
+
+/*
+ * Load CGRAM glyph 'code' (0-7) with eight rows of five pixels, top first,
+ * bit 4 leftmost.  Characters already showing the glyph change with it.
+ */
+void lcd_16207_define_glyph( int code, const alt_u8 rows[LCD_16207_GLYPH_ROWS] );
+
+void lcd_16207_get_stats( struct lcd_16207_stats* out );
+void lcd_16207_reset_stats( void );
+
+#endif /* __LCD_16207_H__ */
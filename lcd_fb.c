@@ -0,0 +1,248 @@
+/******************************************************************************
+ *
+ * lcd_fb.c
+ *
+ * Framebuffer renderer for the 2x16 character LCD.  See lcd_fb.h.
+ *
+ * The altera_avalon_lcd_16207 driver takes "ESC [ row ; col H" (both
+ * 1-based) to move the cursor and "ESC [ 2 J" to clear.  A cursor move costs
+ * six bytes, so two runs of changes separated by fewer unchanged characters
+ * than that are sent as one run.  Blanking a screen that has text on it is
+ * cheapest as a clear, which is four bytes.
+ *
+ * On the direct path a cursor move is one command, as long as a
+ * character, so runs are never merged across unchanged characters.  A
+ * clear keeps the controller busy for as long as rewriting 40 characters,
+ * so a screen is blanked by writing spaces over what differs instead.
+ * The direct path waits on the busy flag itself and there is nothing to
+ * flush.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+
+#include "cpu_load.h"
+#include "lcd_16207.h"
+#include "lcd_fb.h"
+
+#define LCD_ESC          27
+#define LCD_MOVE_BYTES   6
+#define LCD_MOVE_DIRECT  1
+
+struct lcd_fb
+{
+  FILE* fp;
+  int direct;                   /* updates go through lcd_16207 */
+  char want[LCD_FB_ROWS][LCD_FB_COLS];
+  char shown[LCD_FB_ROWS][LCD_FB_COLS];
+  int x, y;                     /* driver cursor position, x -1 unknown */
+  struct lcd_fb_stats stats;
+};
+
+static struct lcd_fb lcd;
+
+static int lcd_blank( const char* p, int n )
+{
+  while (n-- > 0)
+  {
+    if (*p++ != ' ')
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int lcd_fb_init( void )
+{
+#ifdef LCD_DISPLAY_NAME
+  lcd.fp = fopen(LCD_DISPLAY_NAME, "w");
+#endif
+  lcd.direct = (lcd_16207_init() == 0);
+  if (lcd.fp == NULL && !lcd.direct)
+  {
+    return -1;
+  }
+  lcd_fb_reset();
+  return 0;
+}
+
+int lcd_fb_set_direct( int on )
+{
+  if ((on && !lcd_16207_ready()) || (!on && lcd.fp == NULL))
+  {
+    return -1;
+  }
+  lcd.direct = on;
+  lcd_fb_reset();
+  return 0;
+}
+
+int lcd_fb_direct( void )
+{
+  return lcd.direct;
+}
+
+void lcd_fb_puts( int row, const char* text )
+{
+  int n = strlen(text);
+
+  if (n > LCD_FB_COLS)
+  {
+    n = LCD_FB_COLS;
+  }
+  memcpy(lcd.want[row], text, n);
+  memset(&lcd.want[row][n], ' ', LCD_FB_COLS - n);
+}
+
+void lcd_fb_clear( void )
+{
+  memset(lcd.want, ' ', sizeof(lcd.want));
+}
+
+/* Send columns [from, to) of a row, moving the cursor there if needed. */
+
+static int lcd_send_run( int row, int from, int to )
+{
+  int sent = 0;
+
+  if (lcd.direct)
+  {
+    if (lcd.y != row || lcd.x != from)
+    {
+      lcd_16207_goto(row, from);
+      sent++;
+    }
+    lcd_16207_write(&lcd.want[row][from], to - from);
+    sent += to - from;
+  }
+  else
+  {
+    if (lcd.y != row || lcd.x != from)
+    {
+      sent += fprintf(lcd.fp, "%c[%d;%dH", LCD_ESC, row + 1, from + 1);
+    }
+    sent += fwrite(&lcd.want[row][from], 1, to - from, lcd.fp);
+  }
+  memcpy(&lcd.shown[row][from], &lcd.want[row][from], to - from);
+  lcd.y = row;
+  lcd.x = to;
+  return sent;
+}
+
+int lcd_fb_update( void )
+{
+  int row, col, start, end;
+  int move = lcd.direct ? LCD_MOVE_DIRECT : LCD_MOVE_BYTES;
+  int sent = 0;
+  int prev;
+
+  lcd.stats.updates++;
+  if (lcd.fp == NULL && !lcd.direct)
+  {
+    return 0;
+  }
+
+  if (!lcd.direct && lcd_blank(&lcd.want[0][0], sizeof(lcd.want)) &&
+      !lcd_blank(&lcd.shown[0][0], sizeof(lcd.shown)))
+  {
+    sent += fprintf(lcd.fp, "%c[2J", LCD_ESC);
+    memset(lcd.shown, ' ', sizeof(lcd.shown));
+    lcd.x = 0;
+    lcd.y = 0;
+  }
+
+  for (row = 0; row < LCD_FB_ROWS; row++)
+  {
+    start = -1;
+    end = 0;
+    for (col = 0; col < LCD_FB_COLS; col++)
+    {
+      if (lcd.want[row][col] == lcd.shown[row][col])
+      {
+        continue;
+      }
+      if (start >= 0 && col - end >= move)
+      {
+        sent += lcd_send_run(row, start, end);
+        start = -1;
+      }
+      if (start < 0)
+      {
+        start = col;
+      }
+      end = col + 1;
+    }
+    if (start >= 0)
+    {
+      sent += lcd_send_run(row, start, end);
+    }
+  }
+
+  if (sent > 0)
+  {
+    if (!lcd.direct)
+    {
+      /* The driver waits on the LCD's busy flag for every byte. */
+      prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+      fflush(lcd.fp);
+      cpu_load_leave(prev);
+    }
+    lcd.stats.sends++;
+    lcd.stats.bytes += sent;
+    if ((alt_u32) sent > lcd.stats.max_bytes)
+    {
+      lcd.stats.max_bytes = sent;
+    }
+  }
+  return sent;
+}
+
+FILE* lcd_fb_stream( void )
+{
+  return lcd.fp;
+}
+
+void lcd_fb_reset( void )
+{
+  memset(lcd.want, ' ', sizeof(lcd.want));
+  memset(lcd.shown, ' ', sizeof(lcd.shown));
+  lcd.x = 0;
+  lcd.y = 0;
+  /*
+   * Clearing through the HAL also resets what its driver believes is on
+   * the display, which a direct write will have made stale.
+   */
+  if (lcd.fp != NULL)
+  {
+    fprintf(lcd.fp, "%c[2J", LCD_ESC);
+    fflush(lcd.fp);
+    if (lcd.direct)
+    {
+      lcd.x = -1;
+    }
+  }
+  else if (lcd.direct)
+  {
+    lcd_16207_clear();
+  }
+}
+
+alt_u32 lcd_fb_footprint( void )
+{
+  return sizeof(lcd);
+}
+
+void lcd_fb_get_stats( struct lcd_fb_stats* out )
+{
+  *out = lcd.stats;
+}
+
+void lcd_fb_reset_stats( void )
+{
+  memset(&lcd.stats, 0, sizeof(lcd.stats));
+}
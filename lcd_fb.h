@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ * lcd_fb.h
+ *
+ * Framebuffer renderer for the 2x16 character LCD (lcd_display).
+ *
+ * Callers draw into a 2x16 framebuffer and lcd_fb_update() compares it
+ * with what the display is known to show, then sends a cursor move plus
+ * the changed characters for each run of differences, or nothing at all
+ * when the content is unchanged.
+ *
+ * Updates go straight to the controller through lcd_16207 when it answers
+ * at start-up, and otherwise through the HAL's stdio device, which is
+ * opened once either way for free-form output.
+ *
+ ******************************************************************************/
+
+#ifndef __LCD_FB_H__
+#define __LCD_FB_H__
+
+#include <stdio.h>
+
+#include "alt_types.h"
+
+#define LCD_FB_ROWS 2
+#define LCD_FB_COLS 16
+
+struct lcd_fb_stats
+{
+  alt_u32 updates;      /* lcd_fb_update() calls */
+  alt_u32 sends;        /* updates that had something to send */
+  alt_u32 bytes;        /* bytes sent, escapes or commands included */
+  alt_u32 max_bytes;    /* largest single update */
+};
+
+/*
+ * Open the LCD, pick the direct path if the controller answers, and clear
+ * it.  Returns 0, or -1 if the display can be reached neither way.
+ */
+int lcd_fb_init( void );
+
+/*
+ * Send updates through lcd_16207 (1) or the stdio device (0), and reset.
+ * Returns 0, or -1 if the direct path was asked for and is not ready.
+ */
+int lcd_fb_set_direct( int on );
+int lcd_fb_direct( void );
+
+/* Set a row to 'text', truncated or padded with spaces to 16 characters. */
+void lcd_fb_puts( int row, const char* text );
+
+/* Blank the framebuffer. */
+void lcd_fb_clear( void );
+
+/*
+ * Send the differences to the LCD.  Returns the number of bytes sent: on
+ * the direct path, the commands and characters written.
+ */
+int lcd_fb_update( void );
+
+/*
+ * The open LCD stream, for free-form output such as the LCD test.  Call
+ * lcd_fb_reset() afterwards: it clears the display and the framebuffer so
+ * the two agree again, whichever path wrote last.
+ */
+FILE* lcd_fb_stream( void );
+void lcd_fb_reset( void );
+
+/* Bytes of RAM the renderer keeps, not counting the stdio stream. */
+alt_u32 lcd_fb_footprint( void );
+
+void lcd_fb_get_stats( struct lcd_fb_stats* out );
+void lcd_fb_reset_stats( void );
+
+#endif /* __LCD_FB_H__ */
@@ -0,0 +1,199 @@
+/******************************************************************************
+ *
+ * led_anim.c
+ *
+ * Frame-table LED animations played back from the system clock tick.
+ * See led_anim.h.
+ *
+ * The playback state is written by the main loop only with interrupts
+ * disabled, and otherwise only by the tick hook.
+ *
+ ******************************************************************************/
+
+#include "system.h"
+#include "qsys_map.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "pio_shadow.h"
+#include "led_anim.h"
+
+#if !defined(LED_PIO_BASE) || !defined(RED_LED_BASE)
+#error "led_anim requires the led_pio and red_led PIOs"
+#endif
+
+#if QSYS_LED_PIO_MASK != LED_STRIP_GREEN || \
+    QSYS_RED_LED_MASK << LED_STRIP_RED_SHIFT != LED_STRIP_RED
+#error "led_anim: the strip layout no longer matches the led_pio and red_led widths"
+#endif
+
+#define LED_ANIM_TICKS(ms) ((ms) * SYS_CLK_TIMER_TICKS_PER_SEC / 1000)
+
+/* Expand F(n) for a run of consecutive n. */
+#define LED_REP4(F, n)   F(n) F((n) + 1) F((n) + 2) F((n) + 3)
+#define LED_REP16(F, n)  LED_REP4(F, n) LED_REP4(F, (n) + 4) \
+                         LED_REP4(F, (n) + 8) LED_REP4(F, (n) + 12)
+#define LED_REP64(F, n)  LED_REP16(F, n) LED_REP16(F, (n) + 16) \
+                         LED_REP16(F, (n) + 32) LED_REP16(F, (n) + 48)
+#define LED_REP256(F, n) LED_REP64(F, n) LED_REP64(F, (n) + 64) \
+                         LED_REP64(F, (n) + 128) LED_REP64(F, (n) + 192)
+
+/*
+ * Sweep and bounce: a block of KR_WIDTH LEDs moved one position per frame.
+ * Positions run 0..KR_LAST.
+ */
+#define KR_WIDTH  6
+#define KR_LAST   (LED_STRIP_BITS - KR_WIDTH)
+#define KR_DWELL  LED_ANIM_TICKS(40)
+#define KR_BLOCK(pos) ((((alt_u32) 1 << KR_WIDTH) - 1) << (pos))
+
+#define KR_UP(n)   LED_ANIM_FRAME(KR_BLOCK(n), KR_DWELL),
+#define KR_DOWN(n) LED_ANIM_FRAME(KR_BLOCK(KR_LAST - 1 - (n)), KR_DWELL),
+
+static const struct led_frame led_frames_up[KR_LAST + 1] =
+{
+  LED_REP16(KR_UP, 0) LED_REP4(KR_UP, 16) KR_UP(20)
+};
+
+/* Up to KR_LAST, then back down to 1 so the loop does not repeat a frame. */
+static const struct led_frame led_frames_bounce[2 * KR_LAST] =
+{
+  LED_REP16(KR_UP, 0) LED_REP4(KR_UP, 16) KR_UP(20)
+  LED_REP16(KR_DOWN, 0) KR_DOWN(16) KR_DOWN(17) KR_DOWN(18)
+};
+
+/* Binary count 1..256 on red_led bits 8 and up, as Test_Func first showed it. */
+#define COUNT_DWELL LED_ANIM_TICKS(200)
+#define COUNT_FRAME(n) \
+  LED_ANIM_FRAME((alt_u32)((n) + 1) << (LED_STRIP_RED_SHIFT + 8), COUNT_DWELL),
+
+static const struct led_frame led_frames_count[256] =
+{
+  LED_REP256(COUNT_FRAME, 0)
+};
+
+/* Custom pattern: a pair of LEDs moving out from the middle of the strip. */
+#define CENTER_DWELL LED_ANIM_TICKS(60)
+#define CENTER_FRAME(n) \
+  LED_ANIM_FRAME(((alt_u32) 1 << (12 - (n))) | ((alt_u32) 1 << (13 + (n))), \
+                 CENTER_DWELL),
+
+static const struct led_frame led_frames_center[13] =
+{
+  LED_REP4(CENTER_FRAME, 0) LED_REP4(CENTER_FRAME, 4) LED_REP4(CENTER_FRAME, 8)
+  CENTER_FRAME(12)
+};
+
+LED_ANIM_DEFINE(led_anim_sweep, "sweep", led_frames_up, 1);
+LED_ANIM_DEFINE(led_anim_bounce, "bounce", led_frames_bounce, 1);
+LED_ANIM_DEFINE(led_anim_count, "count", led_frames_count, 0);
+LED_ANIM_DEFINE(led_anim_center, "center-out", led_frames_center, 1);
+
+static const struct led_anim* volatile led_cur;
+static alt_u16 led_index;
+static alt_u16 led_left;
+static struct led_anim_stats led_stats;
+
+/*
+ * Show a strip pattern.  The shadow layer only writes a PIO whose value
+ * changes, and flushes later in the same tick.
+ */
+
+static void led_anim_write( alt_u32 leds )
+{
+  pio_shadow_write(PIO_OUT_LED, leds & LED_STRIP_GREEN);
+  pio_shadow_write(PIO_OUT_RED, (leds & LED_STRIP_RED) >> LED_STRIP_RED_SHIFT);
+}
+
+static void led_anim_frame( void )
+{
+  const struct led_frame* frame = &led_cur->frames[led_index];
+
+  led_anim_write(frame->leds);
+  led_left = frame->dwell;
+  led_stats.frames++;
+}
+
+/* Tick hook: count down the current frame and move to the next one. */
+
+static void led_anim_tick( void* context )
+{
+  (void) context;
+  if (led_cur == NULL)
+  {
+    return;
+  }
+  led_stats.ticks++;
+  if (led_left > 1)
+  {
+    led_left--;
+    return;
+  }
+  if (++led_index == led_cur->count)
+  {
+    if (!led_cur->loop)
+    {
+      led_cur = NULL;
+      return;
+    }
+    led_index = 0;
+  }
+  led_anim_frame();
+}
+
+void led_anim_init( void )
+{
+  led_anim_write(0);
+  timer_add_tick_hook(led_anim_tick, NULL);
+}
+
+void led_anim_play( const struct led_anim* anim )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  led_cur = anim;
+  led_index = 0;
+  led_anim_frame();
+  alt_irq_enable_all(irq);
+}
+
+void led_anim_stop( void )
+{
+  led_cur = NULL;
+}
+
+const struct led_anim* led_anim_current( void )
+{
+  return led_cur;
+}
+
+void led_anim_show( alt_u32 leds )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  led_cur = NULL;
+  led_anim_write(leds);
+  alt_irq_enable_all(irq);
+}
+
+void led_anim_get_stats( struct led_anim_stats* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  *out = led_stats;
+  alt_irq_enable_all(irq);
+}
+
+void led_anim_reset_stats( void )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  led_stats.frames = 0;
+  led_stats.ticks = 0;
+  alt_irq_enable_all(irq);
+}
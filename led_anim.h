@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ * led_anim.h
+ *
+ * Frame-table LED animations played back from the system clock tick.
+ *
+ * The 26 board LEDs are treated as one strip: bits 0-7 are led_pio (green)
+ * and bits 8-25 are red_led.  An animation is a constant table of strip
+ * patterns, each with a dwell time in ticks; the tables for the built-in
+ * patterns are expanded by the preprocessor, so nothing is computed while
+ * they play.  Frames go out through pio_shadow, so only the PIO whose LEDs
+ * changed is written, which is a single Avalon write for every frame that
+ * stays within one PIO.  led_anim_init() must be called before
+ * pio_shadow_init().
+ *
+ ******************************************************************************/
+
+#ifndef __LED_ANIM_H__
+#define __LED_ANIM_H__
+
+#include "alt_types.h"
+
+#define LED_STRIP_BITS   26
+#define LED_STRIP_GREEN  0x000000ff
+#define LED_STRIP_RED    0x03ffff00
+#define LED_STRIP_RED_SHIFT 8
+
+struct led_frame
+{
+  alt_u32 leds;         /* strip pattern */
+  alt_u16 dwell;        /* ticks to show it for */
+};
+
+struct led_anim
+{
+  const char* name;
+  const struct led_frame* frames;
+  alt_u16 count;
+  alt_u8 loop;          /* restart after the last frame, else hold it */
+};
+
+/* Build a custom animation from a constant struct led_frame array. */
+#define LED_ANIM_FRAME(leds, dwell) { (leds), (dwell) }
+#define LED_ANIM_DEFINE(var, name, frames, loop) \
+  const struct led_anim var = \
+    { name, frames, sizeof(frames) / sizeof((frames)[0]), loop }
+
+/* Built-in animations. */
+extern const struct led_anim led_anim_sweep;    /* 6-LED block, low to high */
+extern const struct led_anim led_anim_bounce;   /* Knight Rider scanner */
+extern const struct led_anim led_anim_count;    /* red LEDs count 1..256 */
+extern const struct led_anim led_anim_center;   /* pairs moving outwards */
+
+struct led_anim_stats
+{
+  alt_u32 frames;       /* frames shown */
+  alt_u32 ticks;        /* ticks spent playing */
+};
+
+/* Turn the strip off and register the playback tick hook. */
+void led_anim_init( void );
+
+/*
+ * Start playing an animation; its first frame is queued immediately.  The
+ * engine owns both LED PIOs until led_anim_stop() or, for a non-looping
+ * animation, until the last frame has been shown.
+ */
+void led_anim_play( const struct led_anim* anim );
+void led_anim_stop( void );
+
+/* Animation playing, or NULL once it has stopped or finished. */
+const struct led_anim* led_anim_current( void );
+
+/* Stop playback and show a fixed strip pattern. */
+void led_anim_show( alt_u32 leds );
+
+void led_anim_get_stats( struct led_anim_stats* out );
+void led_anim_reset_stats( void );
+
+#endif /* __LED_ANIM_H__ */
@@ -0,0 +1,311 @@
+/******************************************************************************
+ *
+ * led_bam.c
+ *
+ * Bit-angle modulated LED brightness.  See led_bam.h.
+ *
+ * The levels are split into bit planes, one strip pattern per bit, in a
+ * back buffer that the tick hook swaps in at the start of a period, so a
+ * period never mixes two settings.  The planes are built with interrupts
+ * disabled, or from the tick hook for the scanner.  A slot change is timed
+ * with the timer service, less the cost of an empty bracket measured at
+ * start-up.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "pio_shadow.h"
+#include "fmt.h"
+#include "led_anim.h"
+#include "led_bam.h"
+
+#define LED_BAM_LEVELS(bits) ((alt_u32) 1 << (bits))
+#define LED_BAM_SCAN_TICKS   (LED_BAM_SCAN_MS * SYS_CLK_TIMER_TICKS_PER_SEC / 1000)
+
+static volatile int led_bam_on;
+static int led_bam_bits;
+static int led_bam_slot;                /* next slot to show */
+static alt_u32 led_bam_left;            /* ticks left in the slot showing */
+static alt_u32 led_bam_shown;           /* its strip pattern */
+static alt_u32 led_bam_planes[2][LED_BAM_MAX_BITS];
+static int led_bam_front;               /* planes being shown */
+static int led_bam_pending;             /* the back planes are newer */
+static alt_u8 led_bam_brightness[LED_STRIP_BITS];
+static int led_bam_scanning;
+static int led_bam_head;
+static int led_bam_dir;
+static alt_u32 led_bam_scan_left;
+static alt_u32 led_bam_bracket;
+static struct led_bam_stats led_bam_stats;
+
+alt_u32 led_bam_level( alt_u8 brightness, int bits )
+{
+  return ((alt_u32) brightness * (LED_BAM_LEVELS(bits) - 1) + 127) / 255;
+}
+
+/* Split the levels into the back planes.  Interrupts off or in the hook. */
+
+static void led_bam_build( void )
+{
+  alt_u32* planes = led_bam_planes[!led_bam_front];
+  alt_u32 level;
+  int i, k;
+
+  memset(planes, 0, sizeof(led_bam_planes[0]));
+  for (i = 0; i < LED_STRIP_BITS; i++)
+  {
+    level = led_bam_level(led_bam_brightness[i], led_bam_bits);
+    for (k = 0; level != 0; k++, level >>= 1)
+    {
+      if (level & 1)
+      {
+        planes[k] |= (alt_u32) 1 << i;
+      }
+    }
+  }
+  led_bam_pending = 1;
+}
+
+/* Scanner: every LED fades by half, and the head moves on at full brightness. */
+
+static void led_bam_scan_step( void )
+{
+  int i;
+
+  for (i = 0; i < LED_STRIP_BITS; i++)
+  {
+    led_bam_brightness[i] >>= 1;
+  }
+  led_bam_brightness[led_bam_head] = 255;
+  led_bam_build();
+  if (led_bam_head + led_bam_dir < 0 || led_bam_head + led_bam_dir >= LED_STRIP_BITS)
+  {
+    led_bam_dir = -led_bam_dir;
+  }
+  led_bam_head += led_bam_dir;
+}
+
+/* Show the next slot's plane. */
+
+static void led_bam_next( void )
+{
+  alt_u64 begin = timer_now_cycles();
+  alt_u32 leds, changed, cycles;
+
+  if (led_bam_slot == 0)
+  {
+    if (led_bam_pending)
+    {
+      led_bam_front = !led_bam_front;
+      led_bam_pending = 0;
+    }
+    if (led_bam_stats.slots == 0)
+    {
+      led_bam_stats.first_cycles = begin;
+    }
+    else
+    {
+      led_bam_stats.periods++;
+    }
+  }
+  leds = led_bam_planes[led_bam_front][led_bam_slot];
+  changed = leds ^ led_bam_shown;
+  led_bam_shown = leds;
+  pio_shadow_write(PIO_OUT_LED, leds & LED_STRIP_GREEN);
+  pio_shadow_write(PIO_OUT_RED, (leds & LED_STRIP_RED) >> LED_STRIP_RED_SHIFT);
+  pio_shadow_flush();
+  led_bam_left = (alt_u32) 1 << led_bam_slot;
+  if (++led_bam_slot == led_bam_bits)
+  {
+    led_bam_slot = 0;
+  }
+
+  cycles = (alt_u32)(timer_now_cycles() - begin);
+  cycles = cycles > led_bam_bracket ? cycles - led_bam_bracket : 0;
+  led_bam_stats.slots++;
+  led_bam_stats.writes += ((changed & LED_STRIP_GREEN) != 0) + ((changed & LED_STRIP_RED) != 0);
+  led_bam_stats.cycles += cycles;
+  if (cycles < led_bam_stats.min_cycles)
+  {
+    led_bam_stats.min_cycles = cycles;
+  }
+  if (cycles > led_bam_stats.max_cycles)
+  {
+    led_bam_stats.max_cycles = cycles;
+  }
+}
+
+/* Tick hook: step the scanner, and change slots when this one is over. */
+
+static void led_bam_tick( void* context )
+{
+  (void) context;
+  if (!led_bam_on)
+  {
+    return;
+  }
+  if (led_bam_scanning && --led_bam_scan_left == 0)
+  {
+    led_bam_scan_left = LED_BAM_SCAN_TICKS;
+    led_bam_scan_step();
+  }
+  if (--led_bam_left == 0)
+  {
+    led_bam_next();
+  }
+}
+
+void led_bam_init( void )
+{
+  alt_u64 a, b;
+  int i;
+
+  /* The cheapest of a few empty brackets is the timing overhead. */
+  led_bam_bracket = ~(alt_u32) 0;
+  for (i = 0; i < 8; i++)
+  {
+    a = timer_now_cycles();
+    b = timer_now_cycles();
+    if (b - a < led_bam_bracket)
+    {
+      led_bam_bracket = (alt_u32)(b - a);
+    }
+  }
+  timer_add_tick_hook(led_bam_tick, NULL);
+}
+
+void led_bam_start( int bits )
+{
+  alt_irq_context irq;
+
+  if (bits < 1)
+  {
+    bits = 1;
+  }
+  else if (bits > LED_BAM_MAX_BITS)
+  {
+    bits = LED_BAM_MAX_BITS;
+  }
+  irq = alt_irq_disable_all();
+  memset(&led_bam_stats, 0, sizeof(led_bam_stats));
+  led_bam_stats.bits = bits;
+  led_bam_stats.min_cycles = ~(alt_u32) 0;
+  led_bam_bits = bits;
+  led_bam_slot = 0;
+  led_bam_left = 1;
+  led_bam_shown = pio_shadow_read(PIO_OUT_LED) |
+                  pio_shadow_read(PIO_OUT_RED) << LED_STRIP_RED_SHIFT;
+  led_bam_build();
+  led_bam_on = 1;
+  alt_irq_enable_all(irq);
+}
+
+void led_bam_stop( void )
+{
+  alt_irq_context irq;
+
+  if (!led_bam_on)
+  {
+    return;
+  }
+  irq = alt_irq_disable_all();
+  led_bam_on = 0;
+  led_bam_scanning = 0;
+  pio_shadow_write(PIO_OUT_LED, 0);
+  pio_shadow_write(PIO_OUT_RED, 0);
+  alt_irq_enable_all(irq);
+}
+
+int led_bam_running( void )
+{
+  return led_bam_on;
+}
+
+void led_bam_set( const alt_u8 brightness[LED_STRIP_BITS] )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  led_bam_scanning = 0;
+  memcpy(led_bam_brightness, brightness, sizeof(led_bam_brightness));
+  led_bam_build();
+  alt_irq_enable_all(irq);
+}
+
+void led_bam_scan( int bits )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  memset(led_bam_brightness, 0, sizeof(led_bam_brightness));
+  led_bam_head = 0;
+  led_bam_dir = 1;
+  led_bam_scan_left = 1;
+  led_bam_scanning = 1;
+  led_bam_start(bits);
+  alt_irq_enable_all(irq);
+}
+
+int led_bam_flicker_free_bits( void )
+{
+  int bits;
+
+  for (bits = LED_BAM_MAX_BITS; bits > 1; bits--)
+  {
+    if (SYS_CLK_TIMER_TICKS_PER_SEC / (LED_BAM_LEVELS(bits) - 1) >= LED_BAM_FLICKER_HZ)
+    {
+      break;
+    }
+  }
+  return bits;
+}
+
+void led_bam_get_stats( struct led_bam_stats* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  *out = led_bam_stats;
+  alt_irq_enable_all(irq);
+}
+
+void led_bam_report( void )
+{
+  struct led_bam_stats s;
+  alt_u32 steps, refresh_mhz, per_period, max_hz;
+  alt_u32 per_us = timer_cycles_per_us();
+
+  led_bam_get_stats(&s);
+  if (s.bits == 0)
+  {
+    return;
+  }
+  steps = LED_BAM_LEVELS(s.bits) - 1;
+  refresh_mhz = (alt_u32)((alt_u64) SYS_CLK_TIMER_TICKS_PER_SEC * 1000 / steps);
+  per_period = s.slots ? (alt_u32)((alt_u64) s.writes * 100 * s.bits / s.slots) : 0;
+  max_hz = (alt_u32)((alt_u64) per_us * 1000000 /
+                     ((alt_u64)(s.max_cycles ? s.max_cycles : 1) * steps));
+
+  fmt_print("BENCH led_bam bits=%d levels=%lu refresh_hz=%lu.%03lu flicker_free=%s "
+    "periods=%lu t0_us=%lu period_us=%lu\n", s.bits, (unsigned long)(steps + 1),
+    (unsigned long)(refresh_mhz / 1000), (unsigned long)(refresh_mhz % 1000),
+    refresh_mhz >= LED_BAM_FLICKER_HZ * 1000 ? "yes" : "no",
+    (unsigned long) s.periods, (unsigned long)(s.first_cycles / per_us),
+    (unsigned long)(steps * timer_tick_us()));
+  fmt_print("BENCH led_bam bits=%d slots=%lu writes=%lu writes_per_period=%lu.%02lu "
+    "pwm_writes_per_period=%lu\n", s.bits, (unsigned long) s.slots,
+    (unsigned long) s.writes, (unsigned long)(per_period / 100),
+    (unsigned long)(per_period % 100), (unsigned long)(2 * steps));
+  fmt_print("BENCH led_bam bits=%d isr_min=%lu isr_avg=%lu isr_max=%lu "
+    "max_refresh_hz=%lu\n", s.bits,
+    (unsigned long)(s.slots ? s.min_cycles : 0),
+    (unsigned long)(s.slots ? s.cycles / s.slots : 0),
+    (unsigned long) s.max_cycles, (unsigned long) max_hz);
+  fmt_flush();
+}
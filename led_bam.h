@@ -0,0 +1,90 @@
+/******************************************************************************
+ *
+ * led_bam.h
+ *
+ * Brightness for the 26 board LEDs by bit-angle modulation, driven from the
+ * system clock tick.
+ *
+ * Each LED has a brightness of 0-255, shown at 2^bits levels.  A period is
+ * split into one slot per bit of the level, slot k lasting 2^k ticks, and
+ * in slot k an LED is lit if bit k of its level is set; so over a period
+ * of 2^bits - 1 ticks it is lit for exactly 'level' of them.  A period
+ * costs 'bits' slot changes, each at most one write per PIO, where PWM
+ * would need one change per level.
+ *
+ * The tick is the only timer in the system, so a slot is at least a tick
+ * and the refresh rate is SYS_CLK_TIMER_TICKS_PER_SEC / (2^bits - 1):
+ * 333 Hz at 2 bits, 143 Hz at 3, 67 Hz at 4 and 3.9 Hz at 8.
+ * led_bam_flicker_free_bits() is the deepest modulation that stays at or
+ * above LED_BAM_FLICKER_HZ.  The report gives the rate the slot change's
+ * cost would allow if a dedicated interval timer drove the slots.
+ *
+ * The strip layout is led_anim's: bits 0-7 green, 8-25 red.  Slots go out
+ * through pio_shadow, so led_bam_init() must be called before
+ * pio_shadow_init().  The engine owns both LED PIOs while it runs; stop any
+ * animation or count before starting it.
+ *
+ ******************************************************************************/
+
+#ifndef __LED_BAM_H__
+#define __LED_BAM_H__
+
+#include "alt_types.h"
+#include "led_anim.h"
+
+#define LED_BAM_MAX_BITS    8
+#define LED_BAM_FLICKER_HZ  100     /* slowest refresh that does not flicker */
+#define LED_BAM_SCAN_MS     40      /* scanner step, as the bounce animation */
+
+struct led_bam_stats
+{
+  int bits;
+  alt_u32 periods;      /* whole periods shown */
+  alt_u32 slots;        /* slot changes made */
+  alt_u32 writes;       /* PIO writes they needed */
+  alt_u64 cycles;       /* spent in the slot changes, timing removed */
+  alt_u32 min_cycles;
+  alt_u32 max_cycles;
+  alt_u64 first_cycles; /* start of the first period */
+};
+
+/* Register the tick hook; the engine starts stopped. */
+void led_bam_init( void );
+
+/*
+ * Show the brightness levels at 'bits' (1 to LED_BAM_MAX_BITS) bits, from
+ * the next tick until led_bam_stop(), which turns the strip off.
+ */
+void led_bam_start( int bits );
+void led_bam_stop( void );
+int led_bam_running( void );
+
+/*
+ * Set the brightness of every LED on the strip, index 0 first; it takes
+ * effect at the start of the next period.
+ */
+void led_bam_set( const alt_u8 brightness[LED_STRIP_BITS] );
+
+/*
+ * Knight Rider scanner with a fading tail: the head moves one LED every
+ * LED_BAM_SCAN_MS, back and forth, and each LED behind it is half as
+ * bright as the one before.  Starts the engine at 'bits'.
+ */
+void led_bam_scan( int bits );
+
+/* The level an LED of 'brightness' is shown at, 0 to 2^bits - 1. */
+alt_u32 led_bam_level( alt_u8 brightness, int bits );
+
+/* Deepest modulation the tick refreshes at LED_BAM_FLICKER_HZ or more. */
+int led_bam_flicker_free_bits( void );
+
+void led_bam_get_stats( struct led_bam_stats* out );
+
+/*
+ * Print BENCH lines for the current or last run: the refresh rate, the PIO
+ * writes per period against PWM's, and the cost of a slot change with the
+ * refresh rate it would allow.
+ */
+void led_bam_report( void );
+
+#endif /* __LED_BAM_H__ */
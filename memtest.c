@@ -0,0 +1,319 @@
+/******************************************************************************
+ *
+ * memtest.c
+ *
+ * On-chip memory tests.  See memtest.h.
+ *
+ * Every sweep goes through the region eight words per loop iteration, with
+ * the next word's pattern derived from the last (a constant step, a
+ * rotation or an xorshift step) so no table or division sits in the loop.
+ * A wrong word is recorded and the sweep carries on, so the error count
+ * says how widespread a fault is.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "io.h"
+
+#include "timer_service.h"
+#include "memtest.h"
+
+#define MT_RD(a)      IORD_32DIRECT((a), 0)
+#define MT_WR(a, v)   IOWR_32DIRECT((a), 0, (v))
+#define MT_BLOCK      32                /* bytes per unrolled iteration */
+
+#define MT_UNROLL8(s) s; s; s; s; s; s; s; s
+
+/* How the pattern moves from one word to the next. */
+#define MT_STEP       0                 /* v += step */
+#define MT_ROTATE     1                 /* v rotated left one bit */
+#define MT_XORSHIFT   2                 /* xorshift32 */
+
+#define MT_ROTL(v)    (((v) << 1) | ((v) >> 31))
+#define MT_XS(v)      ((v) ^= (v) << 13, (v) ^= (v) >> 17, (v) ^= (v) << 5)
+
+#define MT_RANDOM_SEED 0x2545f491
+
+struct mt_state
+{
+  alt_u32 base;
+  alt_u32 end;
+  struct memtest_result* r;
+};
+
+static const char* const mt_names[MEMTEST_NUM_ALGOS] =
+{
+  "march_c-", "walking_1", "addr", "random"
+};
+
+/* March C- data backgrounds; each is run as itself and its complement. */
+static const alt_u32 mt_backgrounds[] =
+{
+  0x00000000, 0x55555555, 0x33333333, 0x0f0f0f0f, 0x00ff00ff, 0x0000ffff
+};
+
+#define MT_NUM_BACKGROUNDS ((int)(sizeof(mt_backgrounds) / sizeof(mt_backgrounds[0])))
+
+static void mt_error( struct mt_state* s, alt_u32 a, alt_u32 expect, alt_u32 got )
+{
+  if (s->r->errors++ == 0)
+  {
+    s->r->first_addr = a;
+    s->r->first_expect = expect;
+    s->r->first_actual = got;
+  }
+}
+
+/* Write the pattern starting at 'v' to every word, ascending. */
+
+static void mt_write( struct mt_state* s, int kind, alt_u32 v, alt_u32 step,
+                      alt_u32 inv )
+{
+  alt_u32 a = s->base;
+  alt_u32 end = s->end;
+
+  switch (kind)
+  {
+    case MT_STEP:
+      for (; end - a >= MT_BLOCK; )
+      {
+        MT_UNROLL8(MT_WR(a, v ^ inv); a += 4; v += step);
+      }
+      for (; a < end; a += 4, v += step)
+        MT_WR(a, v ^ inv);
+      break;
+    case MT_ROTATE:
+      for (; end - a >= MT_BLOCK; )
+      {
+        MT_UNROLL8(MT_WR(a, v ^ inv); a += 4; v = MT_ROTL(v));
+      }
+      for (; a < end; a += 4, v = MT_ROTL(v))
+        MT_WR(a, v ^ inv);
+      break;
+    case MT_XORSHIFT:
+      for (; end - a >= MT_BLOCK; )
+      {
+        MT_UNROLL8(MT_WR(a, v ^ inv); a += 4; MT_XS(v));
+      }
+      for (; a < end; a += 4, MT_XS(v))
+        MT_WR(a, v ^ inv);
+      break;
+  }
+  s->r->bytes += end - s->base;
+}
+
+/* Read every word back against the same pattern, ascending. */
+
+#define MT_CHECK(a, want) \
+  do { alt_u32 got_ = MT_RD(a); \
+       if (got_ != (want)) mt_error(s, (a), (want), got_); } while (0)
+
+static void mt_check( struct mt_state* s, int kind, alt_u32 v, alt_u32 step,
+                      alt_u32 inv )
+{
+  alt_u32 a = s->base;
+  alt_u32 end = s->end;
+
+  switch (kind)
+  {
+    case MT_STEP:
+      for (; end - a >= MT_BLOCK; )
+      {
+        MT_UNROLL8(MT_CHECK(a, v ^ inv); a += 4; v += step);
+      }
+      for (; a < end; a += 4, v += step)
+        MT_CHECK(a, v ^ inv);
+      break;
+    case MT_ROTATE:
+      for (; end - a >= MT_BLOCK; )
+      {
+        MT_UNROLL8(MT_CHECK(a, v ^ inv); a += 4; v = MT_ROTL(v));
+      }
+      for (; a < end; a += 4, v = MT_ROTL(v))
+        MT_CHECK(a, v ^ inv);
+      break;
+    case MT_XORSHIFT:
+      for (; end - a >= MT_BLOCK; )
+      {
+        MT_UNROLL8(MT_CHECK(a, v ^ inv); a += 4; MT_XS(v));
+      }
+      for (; a < end; a += 4, MT_XS(v))
+        MT_CHECK(a, v ^ inv);
+      break;
+  }
+  s->r->bytes += end - s->base;
+}
+
+/* One march element: read 'expect' then write 'next' at each word. */
+
+#define MT_RW(a) \
+  do { MT_CHECK(a, expect); MT_WR(a, next); } while (0)
+
+static void mt_march_up( struct mt_state* s, alt_u32 expect, alt_u32 next )
+{
+  alt_u32 a = s->base;
+  alt_u32 end = s->end;
+
+  for (; end - a >= MT_BLOCK; a += MT_BLOCK)
+  {
+    MT_RW(a);      MT_RW(a + 4);  MT_RW(a + 8);  MT_RW(a + 12);
+    MT_RW(a + 16); MT_RW(a + 20); MT_RW(a + 24); MT_RW(a + 28);
+  }
+  for (; a < end; a += 4)
+    MT_RW(a);
+  s->r->bytes += 2 * (end - s->base);
+}
+
+static void mt_march_down( struct mt_state* s, alt_u32 expect, alt_u32 next )
+{
+  alt_u32 a = s->end;
+  alt_u32 base = s->base;
+
+  for (; a - base >= MT_BLOCK; )
+  {
+    a -= MT_BLOCK;
+    MT_RW(a + 28); MT_RW(a + 24); MT_RW(a + 20); MT_RW(a + 16);
+    MT_RW(a + 12); MT_RW(a + 8);  MT_RW(a + 4);  MT_RW(a);
+  }
+  while (a > base)
+  {
+    a -= 4;
+    MT_RW(a);
+  }
+  s->r->bytes += 2 * (s->end - base);
+}
+
+/*
+ * March C-: {w0} up(r0,w1) up(r1,w0) down(r0,w1) down(r1,w0) {r0}, with
+ * '0' the background and '1' its complement.
+ */
+
+static void mt_march_c( struct mt_state* s )
+{
+  alt_u32 d0, d1;
+  int i;
+
+  for (i = 0; i < MT_NUM_BACKGROUNDS; i++)
+  {
+    d0 = mt_backgrounds[i];
+    d1 = ~d0;
+    mt_write(s, MT_STEP, d0, 0, 0);
+    mt_march_up(s, d0, d1);
+    mt_march_up(s, d1, d0);
+    mt_march_down(s, d0, d1);
+    mt_march_down(s, d1, d0);
+    mt_check(s, MT_STEP, d0, 0, 0);
+  }
+}
+
+static void mt_walking_1( struct mt_state* s )
+{
+  int k;
+
+  for (k = 0; k < 32; k++)
+  {
+    mt_write(s, MT_ROTATE, 1u << k, 0, 0);
+    mt_check(s, MT_ROTATE, 1u << k, 0, 0);
+  }
+}
+
+static void mt_addr( struct mt_state* s )
+{
+  mt_write(s, MT_STEP, s->base, 4, 0);
+  mt_check(s, MT_STEP, s->base, 4, 0);
+  mt_write(s, MT_STEP, s->base, 4, 0xffffffff);
+  mt_check(s, MT_STEP, s->base, 4, 0xffffffff);
+}
+
+static void mt_random( struct mt_state* s )
+{
+  mt_write(s, MT_XORSHIFT, MT_RANDOM_SEED, 0, 0);
+  mt_check(s, MT_XORSHIFT, MT_RANDOM_SEED, 0, 0);
+  mt_write(s, MT_XORSHIFT, MT_RANDOM_SEED, 0, 0xffffffff);
+  mt_check(s, MT_XORSHIFT, MT_RANDOM_SEED, 0, 0xffffffff);
+}
+
+int memtest_region( alt_u32* base, alt_u32* len )
+{
+#ifdef ONCHIP_MEM_BASE
+  unsigned long lo = ONCHIP_MEM_BASE;
+  unsigned long hi = ONCHIP_MEM_BASE + ONCHIP_MEM_SPAN;
+  unsigned long heap = (unsigned long) sbrk(0);
+  unsigned long stack = (unsigned long) &lo;
+
+  if (heap >= lo && heap < hi)
+  {
+    lo = heap + MEMTEST_HEAP_GUARD;
+  }
+  if (stack >= ONCHIP_MEM_BASE && stack < hi)
+  {
+    hi = stack - MEMTEST_STACK_GUARD;
+  }
+  lo = (lo + 3) & ~3UL;
+  hi &= ~3UL;
+  if (hi <= lo)
+  {
+    return -1;
+  }
+  *base = (alt_u32) lo;
+  *len = (alt_u32)(hi - lo);
+  return 0;
+#else
+  (void) base;
+  (void) len;
+  return -1;
+#endif
+}
+
+const char* memtest_name( int algo )
+{
+  return (algo >= 0 && algo < MEMTEST_NUM_ALGOS) ? mt_names[algo] : "?";
+}
+
+alt_u32 memtest_run( int algo, alt_u32 base, alt_u32 len,
+                     struct memtest_result* out )
+{
+  struct mt_state s;
+  alt_u64 start;
+
+  s.base = base;
+  s.end = base + (len & ~3u);
+  s.r = out;
+  out->bytes = 0;
+  out->errors = 0;
+  out->first_addr = 0;
+  out->first_expect = 0;
+  out->first_actual = 0;
+
+  start = timer_now_cycles();
+  switch (algo)
+  {
+    case MEMTEST_MARCH_C:   mt_march_c(&s);   break;
+    case MEMTEST_WALKING_1: mt_walking_1(&s); break;
+    case MEMTEST_ADDR:      mt_addr(&s);      break;
+    case MEMTEST_RANDOM:    mt_random(&s);    break;
+  }
+  out->us = (alt_u32)((timer_now_cycles() - start) / timer_cycles_per_us());
+  return out->errors;
+}
+
+void memtest_report( int algo, const struct memtest_result* r )
+{
+  alt_u32 rate = r->us ? (alt_u32)((alt_u64) r->bytes * 100 / r->us) : 0;
+
+  printf("BENCH memtest algo=%s bytes=%lu us=%lu mb_per_s=%lu.%02lu errors=%lu",
+    memtest_name(algo), (unsigned long) r->bytes, (unsigned long) r->us,
+    (unsigned long)(rate / 100), (unsigned long)(rate % 100),
+    (unsigned long) r->errors);
+  if (r->errors)
+  {
+    printf(" first=0x%08lx expect=0x%08lx actual=0x%08lx",
+      (unsigned long) r->first_addr, (unsigned long) r->first_expect,
+      (unsigned long) r->first_actual);
+  }
+  printf(" status=%s\n", r->errors ? "fail" : "pass");
+}
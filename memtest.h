@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ * memtest.h
+ *
+ * Destructive tests of the on-chip memory (onchip_mem) with march and
+ * pattern algorithms.
+ *
+ * The running image sits in the same memory: code, data and the heap from
+ * the bottom, the stack from the top.  Only the gap in between is tested,
+ * less MEMTEST_HEAP_GUARD above the current heap top (for stdio buffers
+ * allocated while the test runs) and MEMTEST_STACK_GUARD below the current
+ * stack pointer (for this code and the interrupt handlers).  When the image
+ * is elsewhere, as in the host build, the whole memory is tested.
+ *
+ * All accesses are 32-bit IORD_32DIRECT/IOWR_32DIRECT, so they bypass any
+ * data cache, and the inner loops are unrolled eight words at a time so
+ * the bandwidth figure is the memory's rather than the loop's.
+ *
+ *   march_c-   March C- over six data backgrounds (solid, checkerboard,
+ *              and 2, 4, 8 and 16 bit stripes): stuck-at, transition,
+ *              address decoder and coupling faults between and within words
+ *   walking_1  each word holds a single one, rotated through all 32 bit
+ *              positions in 32 passes: stuck and shorted data lines
+ *   addr       each word holds its own address, then its complement:
+ *              address lines stuck or shorted, aliasing
+ *   random     xorshift32 pseudo-random data, then its complement
+ *
+ ******************************************************************************/
+
+#ifndef __MEMTEST_H__
+#define __MEMTEST_H__
+
+#include "alt_types.h"
+
+#define MEMTEST_HEAP_GUARD  8192
+#define MEMTEST_STACK_GUARD 4096
+
+#define MEMTEST_MARCH_C   0
+#define MEMTEST_WALKING_1 1
+#define MEMTEST_ADDR      2
+#define MEMTEST_RANDOM    3
+#define MEMTEST_NUM_ALGOS 4
+
+struct memtest_result
+{
+  alt_u32 bytes;        /* bytes read plus bytes written */
+  alt_u32 us;
+  alt_u32 errors;       /* words that read back wrong, every pass counted */
+  alt_u32 first_addr;   /* the first of them */
+  alt_u32 first_expect;
+  alt_u32 first_actual;
+};
+
+/*
+ * The testable region of onchip_mem as a bus address and a length in bytes,
+ * both word aligned.  Returns 0, or -1 if there is no room or no memory.
+ */
+int memtest_region( alt_u32* base, alt_u32* len );
+
+/* Short name of an algorithm, as printed in results. */
+const char* memtest_name( int algo );
+
+/* Run one algorithm over [base, base + len).  Returns the error count. */
+alt_u32 memtest_run( int algo, alt_u32 base, alt_u32 len,
+                     struct memtest_result* out );
+
+/* Print one BENCH line for a result. */
+void memtest_report( int algo, const struct memtest_result* r );
+
+#endif /* __MEMTEST_H__ */
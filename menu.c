@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * menu.c
+ *
+ * Menus declared as constant tables.  See menu.h.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "alt_types.h"
+
+#include "console.h"
+#include "fmt.h"
+#include "menu.h"
+
+#define MENU_ESC 27
+
+int menu_choose( const struct menu* m )
+{
+  char entry[4];
+  int len, ch;
+
+  if (m->banner != NULL)
+  {
+    m->banner();
+  }
+  fmt_write(m->screen, strlen(m->screen));
+  fmt_flush();
+
+  /* At the end of a redirected input (host build) every menu unwinds. */
+  len = console_read_line(entry, sizeof(entry));
+  if (len == CONSOLE_EOF)
+  {
+    return 'q';
+  }
+  ch = len > 0 ? (unsigned char) entry[0] : '\n';
+  if (ch >= 'A' && ch <= 'Z')
+  {
+    ch += 'a' - 'A';
+  }
+  if (ch == MENU_ESC)
+  {
+    ch = 'q';
+  }
+  return ch;
+}
+
+const struct menu_item* menu_find( const struct menu* m, int key )
+{
+  int i;
+
+  for (i = 0; i < m->count; i++)
+  {
+    if (m->items[i].key[0] == key)
+    {
+      return &m->items[i];
+    }
+  }
+  return NULL;
+}
+
+void menu_run( const struct menu* m )
+{
+  const struct menu_item* item;
+  int ch;
+
+  while ((ch = menu_choose(m)) != 'q')
+  {
+    item = menu_find(m, ch);
+    if (item != NULL)
+    {
+      item->handler();
+    }
+    else if (ch != '\n')
+    {
+      fmt_print("\n -ERROR: %c is an invalid entry.  Please try again\n",
+        ch);
+      fmt_flush();
+    }
+  }
+}
@@ -0,0 +1,165 @@
+/******************************************************************************
+ *
+ * menu.h
+ *
+ * Menus declared as constant tables.
+ *
+ * A menu is written once as a list of entries, each with the peripheral it
+ * needs, its letter, its label and its handler:
+ *
+ *   #define PERF_MENU(X) \
+ *     X(ALWAYS,  a, "Timer Accuracy", TimerAccuracy) \
+ *     X(LED_PIO, c, "LED Animations", LEDAnimations)
+ *
+ *   MENU_DEFINE(perf_menu, "Performance Menu", PERF_MENU);
+ *
+ * MENU_DEFINE expands the list into a const table of letters and handlers,
+ * and into one string literal holding the whole screen, header, entries
+ * and prompt; the prompt shows the first and last letters, "(a-n)".  An
+ * entry whose peripheral is not in system.h drops out of all of them,
+ * handler reference included, so no #ifdef appears around the entries and
+ * the letter is simply not accepted.  Letters go in alphabetical order, at
+ * most 16 to a menu.  Showing a menu is one
+ * write of the literal to the UART ring; choosing an entry is a scan of
+ * the table.
+ *
+ * Peripherals are named by their system.h prefix (LED_PIO for
+ * LED_PIO_NAME); ALWAYS marks an entry with no requirement.  To gate
+ * entries on a new peripheral, add its MENU_IF_ pair below.
+ *
+ ******************************************************************************/
+
+#ifndef __MENU_H__
+#define __MENU_H__
+
+#include <stddef.h>
+
+#include "system.h"
+
+struct menu_item
+{
+  char key[2];          /* the letter, as a string */
+  const char* label;
+  void (*handler)( void );
+};
+
+struct menu
+{
+  const char* screen;   /* pre-rendered, see MENU_DEFINE */
+  const struct menu_item* items;
+  int count;
+  void (*banner)( void ); /* printed above the screen, or NULL */
+};
+
+/* MENU_IF_<peripheral>(...) is its arguments when the peripheral exists. */
+#define MENU_IF_ALWAYS(...) __VA_ARGS__
+#ifdef LED_PIO_NAME
+#define MENU_IF_LED_PIO(...) __VA_ARGS__
+#else
+#define MENU_IF_LED_PIO(...)
+#endif
+#ifdef LCD_DISPLAY_NAME
+#define MENU_IF_LCD_DISPLAY(...) __VA_ARGS__
+#else
+#define MENU_IF_LCD_DISPLAY(...)
+#endif
+#ifdef BUTTON_PIO_NAME
+#define MENU_IF_BUTTON_PIO(...) __VA_ARGS__
+#else
+#define MENU_IF_BUTTON_PIO(...)
+#endif
+#ifdef SEVEN_SEG_PIO_NAME
+#define MENU_IF_SEVEN_SEG_PIO(...) __VA_ARGS__
+#else
+#define MENU_IF_SEVEN_SEG_PIO(...)
+#endif
+#ifdef JTAG_UART_NAME
+#define MENU_IF_JTAG_UART(...) __VA_ARGS__
+#else
+#define MENU_IF_JTAG_UART(...)
+#endif
+#ifdef KEY_NAME
+#define MENU_IF_KEY(...) __VA_ARGS__
+#else
+#define MENU_IF_KEY(...)
+#endif
+#ifdef ONCHIP_MEM_BASE
+#define MENU_IF_ONCHIP_MEM(...) __VA_ARGS__
+#else
+#define MENU_IF_ONCHIP_MEM(...)
+#endif
+
+#define MENU_RULE "----------------------------------\n"
+#define MENU_HEAD(title) \
+  "\n\n" MENU_RULE "Nios II Board Diagnostics\n" MENU_RULE " " title "\n"
+#define MENU_FOOT(range) \
+  "     q:  Exit\n" MENU_RULE "\nSelect Choice " range ": [Followed by <enter>]"
+
+/* The two expansions of a menu list. */
+#define MENU_LINE(req, key, label, handler) \
+  MENU_IF_##req("     " #key ":  " label "\n")
+#define MENU_ENTRY(req, key, label, handler) \
+  MENU_IF_##req({ #key, label, handler },)
+#define MENU_KEY(req, key, label, handler) \
+  MENU_IF_##req(key,)
+
+/*
+ * "(<first>-<last>)" from the letters left in: the list of keys ends in a
+ * ~, so the last letter is the one after skipping all but two arguments.
+ */
+#define MENU_STR_(x) #x
+#define MENU_STR(x) MENU_STR_(x)
+#define MENU_CAT_(a, b) a##b
+#define MENU_CAT(a, b) MENU_CAT_(a, b)
+#define MENU_FIRST(x, ...) x
+#define MENU_SKIPS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, \
+                    _14, _15, _16, _17, n, ...) n
+#define MENU_SKIPS(...) \
+  MENU_SKIPS_(__VA_ARGS__, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, ~)
+#define MENU_SKIP_0(...) __VA_ARGS__
+#define MENU_SKIP_1(x, ...) MENU_SKIP_0(__VA_ARGS__)
+#define MENU_SKIP_2(x, ...) MENU_SKIP_1(__VA_ARGS__)
+#define MENU_SKIP_3(x, ...) MENU_SKIP_2(__VA_ARGS__)
+#define MENU_SKIP_4(x, ...) MENU_SKIP_3(__VA_ARGS__)
+#define MENU_SKIP_5(x, ...) MENU_SKIP_4(__VA_ARGS__)
+#define MENU_SKIP_6(x, ...) MENU_SKIP_5(__VA_ARGS__)
+#define MENU_SKIP_7(x, ...) MENU_SKIP_6(__VA_ARGS__)
+#define MENU_SKIP_8(x, ...) MENU_SKIP_7(__VA_ARGS__)
+#define MENU_SKIP_9(x, ...) MENU_SKIP_8(__VA_ARGS__)
+#define MENU_SKIP_10(x, ...) MENU_SKIP_9(__VA_ARGS__)
+#define MENU_SKIP_11(x, ...) MENU_SKIP_10(__VA_ARGS__)
+#define MENU_SKIP_12(x, ...) MENU_SKIP_11(__VA_ARGS__)
+#define MENU_SKIP_13(x, ...) MENU_SKIP_12(__VA_ARGS__)
+#define MENU_SKIP_14(x, ...) MENU_SKIP_13(__VA_ARGS__)
+#define MENU_SKIP_15(x, ...) MENU_SKIP_14(__VA_ARGS__)
+#define MENU_FIRST_OF(...) MENU_FIRST(__VA_ARGS__)
+#define MENU_LAST(...) \
+  MENU_FIRST_OF(MENU_CAT(MENU_SKIP_, MENU_SKIPS(__VA_ARGS__))(__VA_ARGS__))
+#define MENU_RANGE_(...) \
+  "(" MENU_STR(MENU_FIRST(__VA_ARGS__)) "-" MENU_STR(MENU_LAST(__VA_ARGS__)) ")"
+#define MENU_RANGE(list) MENU_RANGE_(list(MENU_KEY) ~)
+
+#define MENU_DEFINE_BANNER(name, title, list, banner) \
+  static const struct menu_item name##_items[] = { list(MENU_ENTRY) }; \
+  static const struct menu name = \
+  { \
+    MENU_HEAD(title) list(MENU_LINE) MENU_FOOT(MENU_RANGE(list)), name##_items, \
+    (int)(sizeof(name##_items) / sizeof(name##_items[0])), banner \
+  }
+
+#define MENU_DEFINE(name, title, list) \
+  MENU_DEFINE_BANNER(name, title, list, NULL)
+
+/* Show the screen and read one choice: a letter, lower-cased, or 'q'. */
+int menu_choose( const struct menu* m );
+
+/* The entry for 'key', or NULL. */
+const struct menu_item* menu_find( const struct menu* m, int key );
+
+/*
+ * Show, read and dispatch until 'q' (or ESC, or the end of the input);
+ * an unknown letter is reported and the screen shown again.
+ */
+void menu_run( const struct menu* m );
+
+#endif /* __MENU_H__ */
@@ -0,0 +1,178 @@
+/******************************************************************************
+ *
+ * pio_shadow.c
+ *
+ * Write-coalescing shadow registers for the output PIOs.
+ * See pio_shadow.h.
+ *
+ * The main loop and tick hooks both write, so each update of a shadow entry
+ * is done with interrupts disabled; the flush runs from the tick hook or with
+ * interrupts disabled.
+ *
+ ******************************************************************************/
+
+#include "system.h"
+#include "alt_types.h"
+#include "altera_avalon_pio_regs.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "pio_shadow.h"
+#include "bus_prof.h"
+#include "io_trace.h"
+
+#define PIO_WIDTH_MASK(w) ((alt_u32)((1ULL << (w)) - 1))
+
+struct pio_shadow
+{
+  alt_u32 base;
+  alt_u32 mask;
+  alt_u32 value;        /* last value queued */
+  alt_u32 bus;          /* last value written to the PIO */
+  alt_u8 known;         /* 'bus' is valid */
+  alt_u8 dirty;         /* 'value' still has to be written */
+  struct pio_shadow_stats stats;
+};
+
+static struct pio_shadow pio_out[PIO_OUT_NUM] =
+{
+#ifdef LED_PIO_BASE
+  { .base = LED_PIO_BASE, .mask = PIO_WIDTH_MASK(LED_PIO_DATA_WIDTH) },
+#else
+  { .base = 0, .mask = 0 },
+#endif
+#ifdef RED_LED_BASE
+  { .base = RED_LED_BASE, .mask = PIO_WIDTH_MASK(RED_LED_DATA_WIDTH) },
+#else
+  { .base = 0, .mask = 0 },
+#endif
+#ifdef SEVEN_SEG_PIO_BASE
+  { .base = SEVEN_SEG_PIO_BASE, .mask = PIO_WIDTH_MASK(SEVEN_SEG_PIO_DATA_WIDTH) },
+#else
+  { .base = 0, .mask = 0 },
+#endif
+#ifdef SEVEN_SEG_PIO_1_BASE
+  { .base = SEVEN_SEG_PIO_1_BASE, .mask = PIO_WIDTH_MASK(SEVEN_SEG_PIO_1_DATA_WIDTH) },
+#else
+  { .base = 0, .mask = 0 },
+#endif
+};
+
+static int pio_through;
+
+static void pio_issue( struct pio_shadow* out )
+{
+  IOWR_ALTERA_AVALON_PIO_DATA(out->base, out->value);
+  out->bus = out->value;
+  out->known = 1;
+  out->dirty = 0;
+  out->stats.issued++;
+}
+
+static void pio_flush_all( void )
+{
+  int id;
+
+  for (id = 0; id < PIO_OUT_NUM; id++)
+  {
+    if (pio_out[id].dirty)
+    {
+      pio_issue(&pio_out[id]);
+    }
+  }
+}
+
+/* Tick hook: one write per dirty register. */
+
+static void pio_shadow_tick( void* context )
+{
+  (void) context;
+  pio_flush_all();
+}
+
+void pio_shadow_init( void )
+{
+  timer_add_tick_hook(pio_shadow_tick, NULL);
+}
+
+void pio_shadow_write( int id, alt_u32 value )
+{
+  struct pio_shadow* out = &pio_out[id];
+  alt_irq_context irq;
+
+  if (out->mask == 0)
+  {
+    return;
+  }
+  value &= out->mask;
+
+  irq = alt_irq_disable_all();
+  out->stats.requested++;
+  out->value = value;
+  if (pio_through)
+  {
+    pio_issue(out);
+  }
+  else
+  {
+    out->dirty = !out->known || value != out->bus;
+  }
+  alt_irq_enable_all(irq);
+}
+
+alt_u32 pio_shadow_read( int id )
+{
+  return pio_out[id].value;
+}
+
+void pio_shadow_flush( void )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  pio_flush_all();
+  alt_irq_enable_all(irq);
+}
+
+void pio_shadow_invalidate( void )
+{
+  alt_irq_context irq;
+  int id;
+
+  irq = alt_irq_disable_all();
+  for (id = 0; id < PIO_OUT_NUM; id++)
+  {
+    pio_out[id].known = 0;
+    pio_out[id].dirty = pio_out[id].mask != 0;
+  }
+  alt_irq_enable_all(irq);
+}
+
+void pio_shadow_set_write_through( int on )
+{
+  pio_shadow_flush();
+  pio_through = on;
+}
+
+void pio_shadow_get_stats( int id, struct pio_shadow_stats* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  *out = pio_out[id].stats;
+  alt_irq_enable_all(irq);
+}
+
+void pio_shadow_reset_stats( void )
+{
+  alt_irq_context irq;
+  int id;
+
+  irq = alt_irq_disable_all();
+  for (id = 0; id < PIO_OUT_NUM; id++)
+  {
+    pio_out[id].stats.requested = 0;
+    pio_out[id].stats.issued = 0;
+  }
+  alt_irq_enable_all(irq);
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+ *
+ * pio_shadow.h
+ *
+ * Write-coalescing shadow registers for the output PIOs.
+ *
+ * Every output PIO write goes through pio_shadow_write(), which only records
+ * the value.  A system clock tick hook then issues one Avalon write for each
+ * register whose value differs from what is on the bus, so rewriting the same
+ * value, or several values within one tick, costs no bus traffic beyond the
+ * final one.  Outputs therefore lag a write by at most one tick.
+ *
+ * Write-through mode issues every write immediately, as the code did before
+ * this layer existed, for comparison.
+ *
+ ******************************************************************************/
+
+#ifndef __PIO_SHADOW_H__
+#define __PIO_SHADOW_H__
+
+#include "alt_types.h"
+
+#define PIO_OUT_LED    0      /* led_pio (green) */
+#define PIO_OUT_RED    1      /* red_led */
+#define PIO_OUT_SEG    2      /* seven_seg_pio, left four digits */
+#define PIO_OUT_SEG_1  3      /* seven_seg_pio_1, right four digits */
+#define PIO_OUT_NUM    4
+
+struct pio_shadow_stats
+{
+  alt_u32 requested;    /* pio_shadow_write() calls */
+  alt_u32 issued;       /* Avalon writes actually made */
+};
+
+/*
+ * Register the flush tick hook.  Call after the init functions of modules
+ * that write outputs from their own tick hooks, so that the flush runs after
+ * them and their writes go out in the same tick.
+ */
+void pio_shadow_init( void );
+
+/* Queue a value for an output PIO; out-of-range bits are dropped. */
+void pio_shadow_write( int id, alt_u32 value );
+
+/* Value most recently queued for an output PIO. */
+alt_u32 pio_shadow_read( int id );
+
+/* Issue the dirty registers now instead of at the next tick. */
+void pio_shadow_flush( void );
+
+/*
+ * Forget what is on the bus, after code that wrote the PIOs directly, so
+ * the next flush rewrites every register from its shadow value.
+ */
+void pio_shadow_invalidate( void );
+
+/* 1 for write-through, 0 (the default) for coalescing. */
+void pio_shadow_set_write_through( int on );
+
+void pio_shadow_get_stats( int id, struct pio_shadow_stats* out );
+void pio_shadow_reset_stats( void );
+
+#endif /* __PIO_SHADOW_H__ */
@@ -0,0 +1,350 @@
+/******************************************************************************
+ *
+ * qsys_map.h
+ *
+ * Generated by tools/qsys_map.py from de2i_150_qsys.qsys; do not edit.
+ *
+ * The peripherals the CPU's data master reaches, as the .qsys declares them,
+ * and checks that the system.h this build uses agrees.  Every value is a
+ * constant, so QSYS_RED_LED_WRITE(v) and the like compile to a store to a
+ * fixed address with the PIO's width mask folded in.  They are macros over
+ * IORD/IOWR so that bus_prof.h and io_trace.h still see the accesses.
+ *
+ ******************************************************************************/
+
+#ifndef __QSYS_MAP_H__
+#define __QSYS_MAP_H__
+
+#define QSYS_CPU_FREQ                    50000000
+#define QSYS_NUM_SLAVES                  11
+
+/* button_pio: altera_avalon_pio */
+#define QSYS_BUTTON_PIO_BASE             0x00081050u
+#define QSYS_BUTTON_PIO_SPAN             16
+#define QSYS_BUTTON_PIO_IRQ              (-1)
+#define QSYS_BUTTON_PIO_WIDTH            18
+#define QSYS_BUTTON_PIO_MASK             0x0003ffffu
+#define QSYS_BUTTON_PIO_HAS_IN           1
+#define QSYS_BUTTON_PIO_HAS_OUT          0
+#define QSYS_BUTTON_PIO_CAPTURE          0
+#define QSYS_BUTTON_PIO_READ()           (IORD_ALTERA_AVALON_PIO_DATA(QSYS_BUTTON_PIO_BASE) & QSYS_BUTTON_PIO_MASK)
+
+/* jtag_uart: altera_avalon_jtag_uart */
+#define QSYS_JTAG_UART_BASE              0x00081098u
+#define QSYS_JTAG_UART_SPAN              8
+#define QSYS_JTAG_UART_IRQ               16
+
+/* key: altera_avalon_pio */
+#define QSYS_KEY_BASE                    0x00081020u
+#define QSYS_KEY_SPAN                    16
+#define QSYS_KEY_IRQ                     (-1)
+#define QSYS_KEY_WIDTH                   4
+#define QSYS_KEY_MASK                    0x0000000fu
+#define QSYS_KEY_HAS_IN                  1
+#define QSYS_KEY_HAS_OUT                 0
+#define QSYS_KEY_CAPTURE                 0
+#define QSYS_KEY_READ()                  (IORD_ALTERA_AVALON_PIO_DATA(QSYS_KEY_BASE) & QSYS_KEY_MASK)
+
+/* lcd_display: altera_avalon_lcd_16207 */
+#define QSYS_LCD_DISPLAY_BASE            0x00081080u
+#define QSYS_LCD_DISPLAY_SPAN            16
+#define QSYS_LCD_DISPLAY_IRQ             (-1)
+
+/* led_pio: altera_avalon_pio */
+#define QSYS_LED_PIO_BASE                0x00081070u
+#define QSYS_LED_PIO_SPAN                16
+#define QSYS_LED_PIO_IRQ                 (-1)
+#define QSYS_LED_PIO_WIDTH               8
+#define QSYS_LED_PIO_MASK                0x000000ffu
+#define QSYS_LED_PIO_HAS_IN              0
+#define QSYS_LED_PIO_HAS_OUT             1
+#define QSYS_LED_PIO_CAPTURE             0
+#define QSYS_LED_PIO_WRITE(v)            IOWR_ALTERA_AVALON_PIO_DATA(QSYS_LED_PIO_BASE, (v) & QSYS_LED_PIO_MASK)
+
+/* onchip_mem: altera_avalon_onchip_memory2 */
+#define QSYS_ONCHIP_MEM_BASE             0x00040000u
+#define QSYS_ONCHIP_MEM_SPAN             200480
+#define QSYS_ONCHIP_MEM_IRQ              (-1)
+#define QSYS_ONCHIP_MEM_SIZE             200480
+#define QSYS_ONCHIP_MEM_DATA_WIDTH       32
+
+/* red_led: altera_avalon_pio */
+#define QSYS_RED_LED_BASE                0x00081030u
+#define QSYS_RED_LED_SPAN                16
+#define QSYS_RED_LED_IRQ                 (-1)
+#define QSYS_RED_LED_WIDTH               18
+#define QSYS_RED_LED_MASK                0x0003ffffu
+#define QSYS_RED_LED_HAS_IN              0
+#define QSYS_RED_LED_HAS_OUT             1
+#define QSYS_RED_LED_CAPTURE             0
+#define QSYS_RED_LED_WRITE(v)            IOWR_ALTERA_AVALON_PIO_DATA(QSYS_RED_LED_BASE, (v) & QSYS_RED_LED_MASK)
+
+/* seven_seg_pio: altera_avalon_pio */
+#define QSYS_SEVEN_SEG_PIO_BASE          0x00081060u
+#define QSYS_SEVEN_SEG_PIO_SPAN          16
+#define QSYS_SEVEN_SEG_PIO_IRQ           (-1)
+#define QSYS_SEVEN_SEG_PIO_WIDTH         28
+#define QSYS_SEVEN_SEG_PIO_MASK          0x0fffffffu
+#define QSYS_SEVEN_SEG_PIO_HAS_IN        0
+#define QSYS_SEVEN_SEG_PIO_HAS_OUT       1
+#define QSYS_SEVEN_SEG_PIO_CAPTURE       0
+#define QSYS_SEVEN_SEG_PIO_WRITE(v)      IOWR_ALTERA_AVALON_PIO_DATA(QSYS_SEVEN_SEG_PIO_BASE, (v) & QSYS_SEVEN_SEG_PIO_MASK)
+
+/* seven_seg_pio_1: altera_avalon_pio */
+#define QSYS_SEVEN_SEG_PIO_1_BASE        0x00081040u
+#define QSYS_SEVEN_SEG_PIO_1_SPAN        16
+#define QSYS_SEVEN_SEG_PIO_1_IRQ         (-1)
+#define QSYS_SEVEN_SEG_PIO_1_WIDTH       28
+#define QSYS_SEVEN_SEG_PIO_1_MASK        0x0fffffffu
+#define QSYS_SEVEN_SEG_PIO_1_HAS_IN      0
+#define QSYS_SEVEN_SEG_PIO_1_HAS_OUT     1
+#define QSYS_SEVEN_SEG_PIO_1_CAPTURE     0
+#define QSYS_SEVEN_SEG_PIO_1_WRITE(v)    IOWR_ALTERA_AVALON_PIO_DATA(QSYS_SEVEN_SEG_PIO_1_BASE, (v) & QSYS_SEVEN_SEG_PIO_1_MASK)
+
+/* sys_clk_timer: altera_avalon_timer */
+#define QSYS_SYS_CLK_TIMER_BASE          0x00081000u
+#define QSYS_SYS_CLK_TIMER_SPAN          32
+#define QSYS_SYS_CLK_TIMER_IRQ           1
+#define QSYS_SYS_CLK_TIMER_FREQ          50000000
+#define QSYS_SYS_CLK_TIMER_PERIOD_US     1000
+#define QSYS_SYS_CLK_TIMER_TICKS_PER_SEC 1000
+#define QSYS_SYS_CLK_TIMER_SNAPSHOT      1
+#define QSYS_SYS_CLK_TIMER_COUNTER_SIZE  32
+
+/* sysid: altera_avalon_sysid_qsys */
+#define QSYS_SYSID_BASE                  0x00081090u
+#define QSYS_SYSID_SPAN                  8
+#define QSYS_SYSID_IRQ                   (-1)
+
+/*
+ * system.h against the .qsys.  A peripheral system.h leaves out is not
+ * checked; the firmware compiles the code for it out.  The host build's
+ * system.h gives button_pio an edge capture interrupt the .qsys does not
+ * have (see host/system.h), so IRQs are only checked on the board.
+ */
+
+#if defined(ALT_CPU_FREQ) && ALT_CPU_FREQ != QSYS_CPU_FREQ
+#error "cpu: ALT_CPU_FREQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+
+#ifdef BUTTON_PIO_BASE
+#if BUTTON_PIO_BASE != QSYS_BUTTON_PIO_BASE
+#error "button_pio: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if BUTTON_PIO_SPAN != QSYS_BUTTON_PIO_SPAN
+#error "button_pio: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if BUTTON_PIO_DATA_WIDTH != QSYS_BUTTON_PIO_WIDTH
+#error "button_pio: width in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if BUTTON_PIO_HAS_IN != QSYS_BUTTON_PIO_HAS_IN
+#error "button_pio: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if BUTTON_PIO_HAS_OUT != QSYS_BUTTON_PIO_HAS_OUT
+#error "button_pio: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if BUTTON_PIO_IRQ != QSYS_BUTTON_PIO_IRQ
+#error "button_pio: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef JTAG_UART_BASE
+#if JTAG_UART_BASE != QSYS_JTAG_UART_BASE
+#error "jtag_uart: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if JTAG_UART_SPAN != QSYS_JTAG_UART_SPAN
+#error "jtag_uart: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if JTAG_UART_IRQ != QSYS_JTAG_UART_IRQ
+#error "jtag_uart: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef KEY_BASE
+#if KEY_BASE != QSYS_KEY_BASE
+#error "key: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if KEY_SPAN != QSYS_KEY_SPAN
+#error "key: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if KEY_DATA_WIDTH != QSYS_KEY_WIDTH
+#error "key: width in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if KEY_HAS_IN != QSYS_KEY_HAS_IN
+#error "key: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if KEY_HAS_OUT != QSYS_KEY_HAS_OUT
+#error "key: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if KEY_IRQ != QSYS_KEY_IRQ
+#error "key: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef LCD_DISPLAY_BASE
+#if LCD_DISPLAY_BASE != QSYS_LCD_DISPLAY_BASE
+#error "lcd_display: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if LCD_DISPLAY_SPAN != QSYS_LCD_DISPLAY_SPAN
+#error "lcd_display: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if LCD_DISPLAY_IRQ != QSYS_LCD_DISPLAY_IRQ
+#error "lcd_display: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef LED_PIO_BASE
+#if LED_PIO_BASE != QSYS_LED_PIO_BASE
+#error "led_pio: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if LED_PIO_SPAN != QSYS_LED_PIO_SPAN
+#error "led_pio: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if LED_PIO_DATA_WIDTH != QSYS_LED_PIO_WIDTH
+#error "led_pio: width in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if LED_PIO_HAS_IN != QSYS_LED_PIO_HAS_IN
+#error "led_pio: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if LED_PIO_HAS_OUT != QSYS_LED_PIO_HAS_OUT
+#error "led_pio: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if LED_PIO_IRQ != QSYS_LED_PIO_IRQ
+#error "led_pio: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef ONCHIP_MEM_BASE
+#if ONCHIP_MEM_BASE != QSYS_ONCHIP_MEM_BASE
+#error "onchip_mem: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if ONCHIP_MEM_SPAN != QSYS_ONCHIP_MEM_SPAN
+#error "onchip_mem: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if ONCHIP_MEM_SIZE_VALUE != QSYS_ONCHIP_MEM_SIZE
+#error "onchip_mem: size in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if ONCHIP_MEM_IRQ != QSYS_ONCHIP_MEM_IRQ
+#error "onchip_mem: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef RED_LED_BASE
+#if RED_LED_BASE != QSYS_RED_LED_BASE
+#error "red_led: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if RED_LED_SPAN != QSYS_RED_LED_SPAN
+#error "red_led: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if RED_LED_DATA_WIDTH != QSYS_RED_LED_WIDTH
+#error "red_led: width in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if RED_LED_HAS_IN != QSYS_RED_LED_HAS_IN
+#error "red_led: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if RED_LED_HAS_OUT != QSYS_RED_LED_HAS_OUT
+#error "red_led: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if RED_LED_IRQ != QSYS_RED_LED_IRQ
+#error "red_led: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef SEVEN_SEG_PIO_BASE
+#if SEVEN_SEG_PIO_BASE != QSYS_SEVEN_SEG_PIO_BASE
+#error "seven_seg_pio: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_SPAN != QSYS_SEVEN_SEG_PIO_SPAN
+#error "seven_seg_pio: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_DATA_WIDTH != QSYS_SEVEN_SEG_PIO_WIDTH
+#error "seven_seg_pio: width in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_HAS_IN != QSYS_SEVEN_SEG_PIO_HAS_IN
+#error "seven_seg_pio: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_HAS_OUT != QSYS_SEVEN_SEG_PIO_HAS_OUT
+#error "seven_seg_pio: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if SEVEN_SEG_PIO_IRQ != QSYS_SEVEN_SEG_PIO_IRQ
+#error "seven_seg_pio: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef SEVEN_SEG_PIO_1_BASE
+#if SEVEN_SEG_PIO_1_BASE != QSYS_SEVEN_SEG_PIO_1_BASE
+#error "seven_seg_pio_1: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_1_SPAN != QSYS_SEVEN_SEG_PIO_1_SPAN
+#error "seven_seg_pio_1: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_1_DATA_WIDTH != QSYS_SEVEN_SEG_PIO_1_WIDTH
+#error "seven_seg_pio_1: width in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_1_HAS_IN != QSYS_SEVEN_SEG_PIO_1_HAS_IN
+#error "seven_seg_pio_1: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SEVEN_SEG_PIO_1_HAS_OUT != QSYS_SEVEN_SEG_PIO_1_HAS_OUT
+#error "seven_seg_pio_1: direction in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if SEVEN_SEG_PIO_1_IRQ != QSYS_SEVEN_SEG_PIO_1_IRQ
+#error "seven_seg_pio_1: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef SYS_CLK_TIMER_BASE
+#if SYS_CLK_TIMER_BASE != QSYS_SYS_CLK_TIMER_BASE
+#error "sys_clk_timer: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SYS_CLK_TIMER_SPAN != QSYS_SYS_CLK_TIMER_SPAN
+#error "sys_clk_timer: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SYS_CLK_TIMER_FREQ != QSYS_SYS_CLK_TIMER_FREQ
+#error "sys_clk_timer: clock in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SYS_CLK_TIMER_TICKS_PER_SEC != QSYS_SYS_CLK_TIMER_TICKS_PER_SEC
+#error "sys_clk_timer: period in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SYS_CLK_TIMER_SNAPSHOT != QSYS_SYS_CLK_TIMER_SNAPSHOT
+#error "sys_clk_timer: snapshot in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if SYS_CLK_TIMER_IRQ != QSYS_SYS_CLK_TIMER_IRQ
+#error "sys_clk_timer: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#ifdef SYSID_BASE
+#if SYSID_BASE != QSYS_SYSID_BASE
+#error "sysid: base address in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#if SYSID_SPAN != QSYS_SYSID_SPAN
+#error "sysid: span in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#ifndef BOARD_DIAG_HOST
+#if SYSID_IRQ != QSYS_SYSID_IRQ
+#error "sysid: IRQ in system.h differs from de2i_150_qsys.qsys; regenerate the BSP"
+#endif
+#endif
+#endif
+
+#endif /* __QSYS_MAP_H__ */
@@ -0,0 +1,175 @@
+/******************************************************************************
+ *
+ * red_count.c
+ *
+ * Binary counter on the red LEDs.  See red_count.h.
+ *
+ * The counter state is written by the main loop only with interrupts
+ * disabled, and otherwise only by the tick hook.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "pio_shadow.h"
+#include "fmt.h"
+#include "red_count.h"
+
+#ifndef RED_LED_BASE
+#error "red_count requires the red_led PIO"
+#endif
+
+#define RED_COUNT_ALL ((alt_u32) 1 << RED_LED_DATA_WIDTH)
+
+static const char* const red_count_names[] = { "up", "down", "gray" };
+
+static volatile int red_count_on;
+static alt_u32 red_count_limit;
+static alt_u32 red_count_index;     /* position in the up count */
+static alt_u32 red_count_phase;     /* accumulated rate, below ticks/s */
+static struct red_count_stats red_count_stats;
+
+static alt_u32 red_count_value( alt_u32 n )
+{
+  switch (red_count_stats.mode)
+  {
+    case RED_COUNT_DOWN:
+      return red_count_limit - 1 - n;
+    case RED_COUNT_GRAY:
+      return n ^ (n >> 1);
+    default:
+      return n;
+  }
+}
+
+static void red_count_show( void )
+{
+  red_count_stats.value = red_count_value(red_count_index);
+  pio_shadow_write(PIO_OUT_RED, red_count_stats.value);
+}
+
+/* Tick hook: add the rate to the phase and step once it wraps. */
+
+static void red_count_tick( void* context )
+{
+  (void) context;
+  if (!red_count_on)
+  {
+    return;
+  }
+  red_count_stats.ticks++;
+  red_count_phase += red_count_stats.rate_hz;
+  if (red_count_phase < SYS_CLK_TIMER_TICKS_PER_SEC)
+  {
+    return;
+  }
+  red_count_phase -= SYS_CLK_TIMER_TICKS_PER_SEC;
+  if (++red_count_index == red_count_limit)
+  {
+    red_count_index = 0;
+  }
+  red_count_show();
+  red_count_stats.last_cycles = timer_now_cycles();
+  if (red_count_stats.steps++ == 0)
+  {
+    red_count_stats.first_cycles = red_count_stats.last_cycles;
+  }
+}
+
+void red_count_init( void )
+{
+  red_count_stats.mode = RED_COUNT_UP;
+  timer_add_tick_hook(red_count_tick, NULL);
+}
+
+void red_count_start( int mode, alt_u32 hz, alt_u32 limit )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  memset(&red_count_stats, 0, sizeof(red_count_stats));
+  red_count_stats.mode = mode;
+  red_count_stats.requested_hz = hz;
+  red_count_stats.rate_hz = hz < RED_COUNT_MAX_HZ ? hz : RED_COUNT_MAX_HZ;
+  red_count_limit = (limit == 0 || limit > RED_COUNT_ALL) ? RED_COUNT_ALL : limit;
+  red_count_index = 0;
+  red_count_phase = 0;
+  red_count_show();
+  red_count_on = 1;
+  alt_irq_enable_all(irq);
+}
+
+void red_count_stop( void )
+{
+  red_count_on = 0;
+}
+
+int red_count_running( void )
+{
+  return red_count_on;
+}
+
+const char* red_count_mode_name( int mode )
+{
+  if (mode < 0 || mode >= (int)(sizeof(red_count_names) / sizeof(red_count_names[0])))
+  {
+    return NULL;
+  }
+  return red_count_names[mode];
+}
+
+int red_count_mode( const char* name )
+{
+  int i;
+
+  for (i = 0; red_count_mode_name(i) != NULL; i++)
+  {
+    if (strcmp(name, red_count_names[i]) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void red_count_get_stats( struct red_count_stats* out )
+{
+  alt_irq_context irq;
+
+  irq = alt_irq_disable_all();
+  *out = red_count_stats;
+  alt_irq_enable_all(irq);
+}
+
+alt_u32 red_count_achieved_mhz( const struct red_count_stats* s )
+{
+  alt_u64 span = s->last_cycles - s->first_cycles;
+
+  if (s->steps < 2 || span == 0)
+  {
+    return 0;
+  }
+  return (alt_u32)((alt_u64)(s->steps - 1) * 1000 *
+                   timer_cycles_per_us() * 1000000 / span);
+}
+
+void red_count_report( void )
+{
+  struct red_count_stats s;
+  alt_u32 mhz;
+
+  red_count_get_stats(&s);
+  mhz = red_count_achieved_mhz(&s);
+  fmt_print("BENCH red_count mode=%s requested_hz=%lu rate_hz=%lu "
+    "achieved_hz=%lu.%03lu steps=%lu ticks=%lu value=0x%05lx\n",
+    red_count_mode_name(s.mode), (unsigned long) s.requested_hz,
+    (unsigned long) s.rate_hz, (unsigned long)(mhz / 1000),
+    (unsigned long)(mhz % 1000), (unsigned long) s.steps,
+    (unsigned long) s.ticks, (unsigned long) s.value);
+  fmt_flush();
+}
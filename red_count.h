@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * red_count.h
+ *
+ * Binary counter on all 18 red LEDs, stepped from the system clock tick.
+ *
+ * The rate is set in steps per second and kept with a phase accumulator:
+ * every tick adds the rate, and every SYS_CLK_TIMER_TICKS_PER_SEC it holds
+ * is one step.  Over any run of ticks the number of steps is exact, so the
+ * count does not drift however long it runs, and the spacing of single
+ * steps is within one tick of 1/rate.  The tick is the only timer in the
+ * system, so the highest rate is one step per tick; asking for more gives
+ * that rate, and the report shows the difference.
+ *
+ *   up     0, 1, 2 ... limit - 1, then 0 again
+ *   down   limit - 1 ... 0, then limit - 1 again
+ *   gray   the Gray code of the up count, one LED changing per step (also
+ *          across the wrap when 'limit' is a power of two)
+ *
+ * Values go out through pio_shadow, so red_count_init() must be called
+ * before pio_shadow_init().  The counter owns red_led while it runs; stop
+ * any LED animation before starting it.
+ *
+ ******************************************************************************/
+
+#ifndef __RED_COUNT_H__
+#define __RED_COUNT_H__
+
+#include "system.h"
+#include "alt_types.h"
+
+#define RED_COUNT_UP    0
+#define RED_COUNT_DOWN  1
+#define RED_COUNT_GRAY  2
+
+/* Highest rate in steps per second: one step per tick. */
+#define RED_COUNT_MAX_HZ SYS_CLK_TIMER_TICKS_PER_SEC
+
+struct red_count_stats
+{
+  int mode;
+  alt_u32 requested_hz; /* as passed to red_count_start() */
+  alt_u32 rate_hz;      /* as run, after clamping */
+  alt_u32 steps;        /* values shown after the first */
+  alt_u32 ticks;        /* ticks since the start */
+  alt_u32 value;        /* on the LEDs now */
+  alt_u64 first_cycles; /* timestamps of the first and the last step */
+  alt_u64 last_cycles;
+};
+
+/* Register the tick hook; the counter starts stopped. */
+void red_count_init( void );
+
+/*
+ * Show the first value of 'mode' now and step it 'hz' times a second
+ * through 'limit' values (0 for all 2^18) until red_count_stop().
+ */
+void red_count_start( int mode, alt_u32 hz, alt_u32 limit );
+
+/* Stop stepping; the LEDs keep the last value. */
+void red_count_stop( void );
+
+int red_count_running( void );
+
+/* "up", "down" or "gray", or NULL. */
+const char* red_count_mode_name( int mode );
+
+/* The mode named 'name', or -1. */
+int red_count_mode( const char* name );
+
+/*
+ * Counts of the current or last run.  The achieved rate is measured by the
+ * timer between the first and the last step, in thousandths of a step per
+ * second; 0 before the second step.
+ */
+void red_count_get_stats( struct red_count_stats* out );
+alt_u32 red_count_achieved_mhz( const struct red_count_stats* s );
+
+/* Print a BENCH line for the current or last run. */
+void red_count_report( void );
+
+#endif /* __RED_COUNT_H__ */
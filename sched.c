@@ -0,0 +1,227 @@
+/******************************************************************************
+ *
+ * sched.c
+ *
+ * Cooperative periodic task scheduler on the system clock tick.
+ * See sched.h.
+ *
+ * Releases happen in the tick hook; steps only ever run from the main loop.
+ * A task's 'release', 'ready' and 'stats.misses' are shared with the tick
+ * hook, so the main loop updates them with interrupts disabled.  Tick
+ * comparisons use signed differences and survive the 32-bit count wrapping.
+ *
+ ******************************************************************************/
+
+#include <stddef.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "cpu_load.h"
+#include "sched.h"
+
+static struct sched_task* sched_tasks[SCHED_MAX_TASKS];
+static volatile alt_u32 sched_now;
+
+/* Tick hook: release every task whose time has come. */
+
+static void sched_tick( void* context )
+{
+  struct sched_task* t;
+  int i;
+
+  (void) context;
+  sched_now++;
+  for (i = 0; i < SCHED_MAX_TASKS; i++)
+  {
+    t = sched_tasks[i];
+    if (t == NULL)
+    {
+      continue;
+    }
+    if (!t->ready)
+    {
+      if ((alt_32)(sched_now - t->release) >= 0)
+      {
+        t->ready = 1;
+      }
+    }
+    else if ((alt_32)(sched_now - t->release) >= (alt_32) t->period)
+    {
+      /* Released again before the last release ran: drop that one. */
+      t->release += t->period;
+      t->stats.misses++;
+    }
+  }
+}
+
+void sched_init( void )
+{
+  timer_add_tick_hook(sched_tick, NULL);
+}
+
+alt_u32 sched_ticks( void )
+{
+  return sched_now;
+}
+
+int sched_add( struct sched_task* task )
+{
+  alt_irq_context irq;
+  int i;
+  int ret = -1;
+
+  if (task->deadline == 0)
+  {
+    task->deadline = task->period;
+  }
+  task->ready = 0;
+  task->stats.runs = 0;
+  task->stats.misses = 0;
+  task->stats.cycles = 0;
+  task->stats.max_cycles = 0;
+  task->stats.max_late = 0;
+
+  irq = alt_irq_disable_all();
+  task->release = sched_now + 1;
+  for (i = 0; i < SCHED_MAX_TASKS; i++)
+  {
+    if (sched_tasks[i] == NULL)
+    {
+      sched_tasks[i] = task;
+      ret = 0;
+      break;
+    }
+  }
+  alt_irq_enable_all(irq);
+  return ret;
+}
+
+void sched_remove( struct sched_task* task )
+{
+  alt_irq_context irq;
+  int i;
+
+  irq = alt_irq_disable_all();
+  for (i = 0; i < SCHED_MAX_TASKS; i++)
+  {
+    if (sched_tasks[i] == task)
+    {
+      sched_tasks[i] = NULL;
+    }
+  }
+  alt_irq_enable_all(irq);
+}
+
+/* The released task with the earliest absolute deadline, or NULL. */
+
+static struct sched_task* sched_pick( void )
+{
+  struct sched_task* best = NULL;
+  struct sched_task* t;
+  int i;
+
+  for (i = 0; i < SCHED_MAX_TASKS; i++)
+  {
+    t = sched_tasks[i];
+    if (t != NULL && t->ready &&
+        (best == NULL ||
+         (alt_32)((t->release + t->deadline) - (best->release + best->deadline)) < 0))
+    {
+      best = t;
+    }
+  }
+  return best;
+}
+
+int sched_run_once( void )
+{
+  struct sched_task* t;
+  alt_irq_context irq;
+  alt_u64 start;
+  alt_u32 cycles;
+  alt_u32 late;
+
+  t = sched_pick();
+  if (t == NULL)
+  {
+    return 0;
+  }
+
+  start = timer_now_cycles();
+  t->step(t->context);
+  cycles = (alt_u32)(timer_now_cycles() - start);
+
+  irq = alt_irq_disable_all();
+  late = sched_now - t->release;
+  t->stats.runs++;
+  t->stats.cycles += cycles;
+  if (cycles > t->stats.max_cycles)
+  {
+    t->stats.max_cycles = cycles;
+  }
+  if (late > t->stats.max_late)
+  {
+    t->stats.max_late = late;
+  }
+  if (late >= t->deadline)
+  {
+    t->stats.misses++;
+  }
+
+  /* Next release; any that have already gone by were missed. */
+  t->ready = 0;
+  t->release += t->period;
+  while ((alt_32)(sched_now - t->release) >= (alt_32) t->period)
+  {
+    t->release += t->period;
+    t->stats.misses++;
+  }
+  alt_irq_enable_all(irq);
+  return 1;
+}
+
+void sched_run( int (*done)( void ) )
+{
+  alt_u32 seen;
+  int prev;
+
+  while (!done())
+  {
+    seen = sched_now;
+    if (!sched_run_once())
+    {
+      /* Nothing released: idle until the next tick. */
+      prev = cpu_load_enter(CPU_LOAD_IDLE);
+      while (sched_now == seen && !done())
+      {
+        timer_idle();
+      }
+      cpu_load_leave(prev);
+    }
+  }
+}
+
+void sched_reset_stats( void )
+{
+  alt_irq_context irq;
+  struct sched_task* t;
+  int i;
+
+  irq = alt_irq_disable_all();
+  for (i = 0; i < SCHED_MAX_TASKS; i++)
+  {
+    t = sched_tasks[i];
+    if (t != NULL)
+    {
+      t->stats.runs = 0;
+      t->stats.misses = 0;
+      t->stats.cycles = 0;
+      t->stats.max_cycles = 0;
+      t->stats.max_late = 0;
+    }
+  }
+  alt_irq_enable_all(irq);
+}
@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ * sched.h
+ *
+ * Cooperative periodic task scheduler on the system clock tick.
+ *
+ * Each task is a step function that does one short piece of work and
+ * returns, keeping whatever it needs to resume in its context.  The tick
+ * hook releases a task every 'period' ticks; the main loop, in sched_run(),
+ * runs the released task with the earliest absolute deadline, then the
+ * next, and idles until the following tick once none is left.  Nothing is
+ * preempted, so a step that runs long delays every other task, and that
+ * shows up as deadline misses:
+ *
+ *   - a task misses its deadline when its step finishes more than
+ *     'deadline' ticks after its release;
+ *   - a release that comes round again while the task is still waiting to
+ *     run is dropped and counted as a miss too.
+ *
+ * CPU time per task is measured with timer_now_cycles().
+ *
+ ******************************************************************************/
+
+#ifndef __SCHED_H__
+#define __SCHED_H__
+
+#include "alt_types.h"
+
+#define SCHED_MAX_TASKS 8
+
+typedef void (*sched_step_fn)( void* context );
+
+struct sched_stats
+{
+  alt_u32 runs;         /* steps completed */
+  alt_u32 misses;       /* late steps plus dropped releases */
+  alt_u64 cycles;       /* CPU time in its steps */
+  alt_u32 max_cycles;   /* longest single step */
+  alt_u32 max_late;     /* worst release-to-completion time, in ticks */
+};
+
+struct sched_task
+{
+  const char* name;
+  sched_step_fn step;
+  void* context;
+  alt_u32 period;       /* ticks between releases */
+  alt_u32 deadline;     /* ticks after a release; 0 means 'period' */
+
+  /* Owned by the scheduler. */
+  alt_u32 release;      /* tick of the current or next release */
+  volatile int ready;   /* released, step not yet run */
+  struct sched_stats stats;
+};
+
+/* Register the tick hook.  Call once after timer_init(). */
+void sched_init( void );
+
+/*
+ * Add a task; its first release is on the next tick.  The task structure is
+ * used in place and must stay valid until sched_remove().  Returns 0, or -1
+ * when SCHED_MAX_TASKS tasks are already registered.
+ */
+int sched_add( struct sched_task* task );
+void sched_remove( struct sched_task* task );
+
+/* Run the earliest-deadline released task.  Returns 0 if none was ready. */
+int sched_run_once( void );
+
+/*
+ * Run tasks until 'done' returns non-zero, checked after every step and
+ * every idle tick.  Between ticks the timer idle hook runs.
+ */
+void sched_run( int (*done)( void ) );
+
+/* Ticks since sched_init(). */
+alt_u32 sched_ticks( void );
+
+void sched_reset_stats( void );
+
+#endif /* __SCHED_H__ */
@@ -0,0 +1,245 @@
+/******************************************************************************
+ *
+ * seg_text.c
+ *
+ * Text on the eight seven-segment digits.  See seg_text.h.
+ *
+ * The font is stored active-high (bit 0 = a ... bit 6 = g) so that unlisted
+ * characters default to blank; glyphs are inverted when a string is set.
+ * The scroll state is changed by the main loop only with interrupts
+ * disabled, and otherwise only by the tick hook.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "system.h"
+#include "qsys_map.h"
+#include "alt_types.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "pio_shadow.h"
+#include "seg_text.h"
+
+#define SEG_A 0x01
+#define SEG_B 0x02
+#define SEG_C 0x04
+#define SEG_D 0x08
+#define SEG_E 0x10
+#define SEG_F 0x20
+#define SEG_G 0x40
+#define SEG_ALL 0x7f
+
+/* Each PIO drives four digits of seven segments. */
+#if QSYS_SEVEN_SEG_PIO_WIDTH != 4 * 7 || QSYS_SEVEN_SEG_PIO_1_WIDTH != 4 * 7
+#error "seg_text: seven_seg_pio and seven_seg_pio_1 must be 28 bits wide"
+#endif
+
+/* Blanks between the end of a scrolling string and its next start. */
+#define SEG_TEXT_GAP 4
+
+static const alt_u8 seg_font[128] =
+{
+  ['0'] = SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,
+  ['1'] = SEG_B | SEG_C,
+  ['2'] = SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,
+  ['3'] = SEG_A | SEG_B | SEG_C | SEG_D | SEG_G,
+  ['4'] = SEG_B | SEG_C | SEG_F | SEG_G,
+  ['5'] = SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,
+  ['6'] = SEG_A | SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
+  ['7'] = SEG_A | SEG_B | SEG_C,
+  ['8'] = SEG_ALL,
+  ['9'] = SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,
+
+  ['A'] = SEG_A | SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,
+  ['B'] = SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
+  ['C'] = SEG_A | SEG_D | SEG_E | SEG_F,
+  ['D'] = SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,
+  ['E'] = SEG_A | SEG_D | SEG_E | SEG_F | SEG_G,
+  ['F'] = SEG_A | SEG_E | SEG_F | SEG_G,
+  ['G'] = SEG_A | SEG_C | SEG_D | SEG_E | SEG_F,
+  ['H'] = SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,
+  ['I'] = SEG_E | SEG_F,
+  ['J'] = SEG_B | SEG_C | SEG_D | SEG_E,
+  ['K'] = SEG_A | SEG_C | SEG_E | SEG_F | SEG_G,
+  ['L'] = SEG_D | SEG_E | SEG_F,
+  ['M'] = SEG_A | SEG_C | SEG_E,
+  ['N'] = SEG_A | SEG_B | SEG_C | SEG_E | SEG_F,
+  ['O'] = SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,
+  ['P'] = SEG_A | SEG_B | SEG_E | SEG_F | SEG_G,
+  ['Q'] = SEG_A | SEG_B | SEG_D | SEG_F | SEG_G,
+  ['R'] = SEG_A | SEG_B | SEG_E | SEG_F,
+  ['S'] = SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,
+  ['T'] = SEG_D | SEG_E | SEG_F | SEG_G,
+  ['U'] = SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,
+  ['V'] = SEG_B | SEG_C | SEG_D | SEG_E | SEG_F,
+  ['W'] = SEG_B | SEG_D | SEG_F,
+  ['X'] = SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,
+  ['Y'] = SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,
+  ['Z'] = SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,
+
+  ['a'] = SEG_A | SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,
+  ['b'] = SEG_C | SEG_D | SEG_E | SEG_F | SEG_G,
+  ['c'] = SEG_D | SEG_E | SEG_G,
+  ['d'] = SEG_B | SEG_C | SEG_D | SEG_E | SEG_G,
+  ['e'] = SEG_A | SEG_B | SEG_D | SEG_E | SEG_F | SEG_G,
+  ['f'] = SEG_A | SEG_E | SEG_F | SEG_G,
+  ['g'] = SEG_A | SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,
+  ['h'] = SEG_C | SEG_E | SEG_F | SEG_G,
+  ['i'] = SEG_E,
+  ['j'] = SEG_C | SEG_D,
+  ['k'] = SEG_A | SEG_C | SEG_E | SEG_F | SEG_G,
+  ['l'] = SEG_E | SEG_F,
+  ['m'] = SEG_C | SEG_E,
+  ['n'] = SEG_C | SEG_E | SEG_G,
+  ['o'] = SEG_C | SEG_D | SEG_E | SEG_G,
+  ['p'] = SEG_A | SEG_B | SEG_E | SEG_F | SEG_G,
+  ['q'] = SEG_A | SEG_B | SEG_C | SEG_F | SEG_G,
+  ['r'] = SEG_E | SEG_G,
+  ['s'] = SEG_A | SEG_C | SEG_D | SEG_F | SEG_G,
+  ['t'] = SEG_D | SEG_E | SEG_F | SEG_G,
+  ['u'] = SEG_C | SEG_D | SEG_E,
+  ['v'] = SEG_C | SEG_D | SEG_E,
+  ['w'] = SEG_C | SEG_E,
+  ['x'] = SEG_B | SEG_C | SEG_E | SEG_F | SEG_G,
+  ['y'] = SEG_B | SEG_C | SEG_D | SEG_F | SEG_G,
+  ['z'] = SEG_A | SEG_B | SEG_D | SEG_E | SEG_G,
+
+  ['-'] = SEG_G,
+  ['_'] = SEG_D,
+  ['='] = SEG_D | SEG_G,
+  ['"'] = SEG_B | SEG_F,
+  ['\''] = SEG_F,
+  ['['] = SEG_A | SEG_D | SEG_E | SEG_F,
+  [']'] = SEG_A | SEG_B | SEG_C | SEG_D,
+  ['?'] = SEG_A | SEG_B | SEG_E | SEG_G,
+};
+
+static char seg_str[SEG_TEXT_MAX + 1];
+static int seg_valid;
+
+/* Active-low glyphs of the current string, plus the scroll gap. */
+static alt_u8 seg_codes[SEG_TEXT_MAX + SEG_TEXT_GAP];
+static int seg_len;
+static int seg_pos;
+static volatile int seg_scrolling;
+static alt_u32 seg_step = 300 * SYS_CLK_TIMER_TICKS_PER_SEC / 1000;
+static alt_u32 seg_left;
+
+alt_u8 seg_text_glyph( char c )
+{
+  return ~seg_font[c & 0x7f] & SEG_ALL;
+}
+
+alt_u32 seg_text_encode4( const char* text )
+{
+  alt_u32 word = 0;
+  int i;
+
+  for (i = 0; i < 4; i++)
+  {
+    word = (word << 7) | seg_text_glyph(*text ? *text++ : ' ');
+  }
+  return word;
+}
+
+/* Write the eight digits starting at seg_pos in the (circular) glyph list. */
+
+static void seg_render( void )
+{
+  alt_u32 left = 0, right = 0;
+  int i, at = seg_pos;
+
+  for (i = 0; i < SEG_TEXT_DIGITS; i++)
+  {
+    if (i < 4)
+      left = (left << 7) | seg_codes[at];
+    else
+      right = (right << 7) | seg_codes[at];
+    if (++at == seg_len)
+      at = 0;
+  }
+  pio_shadow_write(PIO_OUT_SEG, left);
+  pio_shadow_write(PIO_OUT_SEG_1, right);
+}
+
+/* Tick hook: advance a scrolling string. */
+
+static void seg_text_tick( void* context )
+{
+  (void) context;
+  if (!seg_scrolling || --seg_left > 0)
+  {
+    return;
+  }
+  seg_left = seg_step;
+  if (++seg_pos == seg_len)
+  {
+    seg_pos = 0;
+  }
+  seg_render();
+}
+
+void seg_text_init( void )
+{
+  seg_text_show("");
+  timer_add_tick_hook(seg_text_tick, NULL);
+}
+
+void seg_text_show( const char* text )
+{
+  alt_irq_context irq;
+  int n, i;
+
+  if (seg_valid && strncmp(text, seg_str, SEG_TEXT_MAX) == 0)
+  {
+    return;
+  }
+
+  irq = alt_irq_disable_all();
+  strncpy(seg_str, text, SEG_TEXT_MAX);
+  n = strlen(seg_str);
+  for (i = 0; i < n; i++)
+  {
+    seg_codes[i] = seg_text_glyph(seg_str[i]);
+  }
+  if (n > SEG_TEXT_DIGITS)
+  {
+    seg_len = n + SEG_TEXT_GAP;
+    seg_scrolling = 1;
+    seg_left = seg_step;
+  }
+  else
+  {
+    seg_len = SEG_TEXT_DIGITS;
+    seg_scrolling = 0;
+  }
+  for (; i < seg_len; i++)
+  {
+    seg_codes[i] = SEG_ALL;
+  }
+  seg_pos = 0;
+  seg_valid = 1;
+  seg_render();
+  alt_irq_enable_all(irq);
+}
+
+void seg_text_clear( void )
+{
+  seg_text_show("");
+}
+
+void seg_text_set_scroll_ms( alt_u32 ms )
+{
+  seg_step = ms * SYS_CLK_TIMER_TICKS_PER_SEC / 1000;
+  if (seg_step == 0)
+  {
+    seg_step = 1;
+  }
+}
+
+void seg_text_invalidate( void )
+{
+  seg_valid = 0;
+}
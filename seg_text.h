@@ -0,0 +1,53 @@
+/******************************************************************************
+ *
+ * seg_text.h
+ *
+ * Text on the eight seven-segment digits.
+ *
+ * seven_seg_pio drives the left four digits and seven_seg_pio_1 the right
+ * four; each digit is 7 active-low bits (bit 0 = segment a ... bit 6 = g)
+ * with the leftmost digit of a PIO in bits 21-27.  Characters are encoded
+ * from a constant font covering digits, letters (upper and lower case
+ * forms) and the punctuation that can be drawn; anything else is blank.
+ *
+ * The encoded glyphs are cached, so showing the string that is already up
+ * costs no writes at all.  Strings longer than eight characters scroll
+ * from the system clock tick.
+ *
+ ******************************************************************************/
+
+#ifndef __SEG_TEXT_H__
+#define __SEG_TEXT_H__
+
+#include "alt_types.h"
+
+#define SEG_TEXT_DIGITS  8
+#define SEG_TEXT_MAX     64     /* longest string kept for scrolling */
+
+/* Blank the display and register the scroll tick hook. */
+void seg_text_init( void );
+
+/*
+ * Show a string, left-aligned and blank-padded.  A string longer than
+ * SEG_TEXT_DIGITS scrolls left one digit per scroll step, with a gap of
+ * blanks before it repeats; beyond SEG_TEXT_MAX characters it is cut off.
+ */
+void seg_text_show( const char* text );
+void seg_text_clear( void );
+
+/* Scroll step in milliseconds (default 300). */
+void seg_text_set_scroll_ms( alt_u32 ms );
+
+/* Active-low segment pattern for one character. */
+alt_u8 seg_text_glyph( char c );
+
+/* PIO word for up to four characters, leftmost digit in bits 21-27. */
+alt_u32 seg_text_encode4( const char* text );
+
+/*
+ * Forget the cached text, for when something has written the segment PIOs
+ * directly; the next seg_text_show() rewrites the display.
+ */
+void seg_text_invalidate( void );
+
+#endif /* __SEG_TEXT_H__ */
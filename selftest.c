@@ -0,0 +1,512 @@
+/******************************************************************************
+ *
+ * selftest.c
+ *
+ * Operator-free self-test of the compiled-in peripherals.  See selftest.h.
+ *
+ * The output PIOs have no readback, so the LED and seven-segment tests
+ * check that every pattern that should have reached the bus was issued by
+ * pio_shadow, and hold each pattern long enough for a camera or a person
+ * at the station to see it.  The button test cannot press anything; it
+ * fails a key that reads as held, or an input that produces edges while
+ * nobody is touching the board.
+ *
+ * Result lines go through uart_tx; stdout shares the JTAG UART, so it is
+ * flushed first.  If the UART could not be opened they go to stdout.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "io.h"
+
+#include "timer_service.h"
+#include "cpu_load.h"
+#include "pio_shadow.h"
+#include "led_anim.h"
+#include "red_count.h"
+#include "led_bam.h"
+#include "seg_text.h"
+#include "lcd_fb.h"
+#include "input_events.h"
+#include "buttons.h"
+#include "uart_tx.h"
+#include "memtest.h"
+#include "selftest.h"
+#include "bus_prof.h"
+#include "io_trace.h"
+
+#define SELFTEST_LINE_MAX     256
+#define SELFTEST_LOAD_MAX     96
+#define SELFTEST_LED_STEP_US  10000     /* each LED pattern is held this long */
+#define SELFTEST_SEG_STEP_US  50000     /* each digit is lit this long */
+#define SELFTEST_LCD_HOLD_US  200000
+#define SELFTEST_IDLE_US      250000    /* quiet time the inputs are watched */
+
+struct selftest_ctx
+{
+  alt_u64 deadline;                     /* timer_now_us() limit */
+  char detail[SELFTEST_DETAIL_MAX];     /* no quotes or backslashes */
+};
+
+struct selftest_entry
+{
+  const char* name;
+  alt_u32 timeout_ms;
+  int (*run)( struct selftest_ctx* ctx );
+};
+
+static const char* const selftest_status[] = { "pass", "fail", "timeout" };
+
+static int selftest_expired( const struct selftest_ctx* ctx )
+{
+  return timer_now_us() > ctx->deadline;
+}
+
+/* One JSON object, one line. */
+
+static void selftest_emit( const char* fmt, ... )
+{
+  char line[SELFTEST_LINE_MAX];
+  va_list ap;
+  int len;
+
+  va_start(ap, fmt);
+  len = vsnprintf(line, sizeof(line) - 1, fmt, ap);
+  va_end(ap);
+  if (len > (int) sizeof(line) - 2)
+  {
+    len = sizeof(line) - 2;
+  }
+  line[len++] = '\n';
+  if (uart_tx_write(line, len) < 0)
+  {
+    fwrite(line, 1, len, stdout);
+  }
+}
+
+/* The CPU's time over a span between 'a' and now, as a JSON object. */
+
+static void selftest_load( char* buf, int size, const struct cpu_load_sample* a )
+{
+  struct cpu_load_sample b, d;
+  alt_u32 pm[CPU_LOAD_STATES];
+  int i;
+
+  cpu_load_total(&b);
+  cpu_load_diff(a, &b, &d);
+  for (i = 0; i < CPU_LOAD_STATES; i++)
+  {
+    pm[i] = cpu_load_permille(&d, i);
+  }
+  snprintf(buf, size, "{\"busy\":%lu.%lu,\"idle\":%lu.%lu,\"io_wait\":%lu.%lu,\"isr\":%lu.%lu}",
+    (unsigned long)(pm[CPU_LOAD_BUSY] / 10), (unsigned long)(pm[CPU_LOAD_BUSY] % 10),
+    (unsigned long)(pm[CPU_LOAD_IDLE] / 10), (unsigned long)(pm[CPU_LOAD_IDLE] % 10),
+    (unsigned long)(pm[CPU_LOAD_IO_WAIT] / 10), (unsigned long)(pm[CPU_LOAD_IO_WAIT] % 10),
+    (unsigned long)(pm[CPU_LOAD_ISR] / 10), (unsigned long)(pm[CPU_LOAD_ISR] % 10));
+}
+
+#if defined(LED_PIO_BASE) || defined(SEVEN_SEG_PIO_BASE)
+
+/*
+ * Registers whose queued value differs from 'snap', which is brought up to
+ * date: the number of bus writes the next flush ought to issue.
+ */
+
+static alt_u32 selftest_changed( alt_u32* snap )
+{
+  alt_u32 n = 0;
+  alt_u32 v;
+  int id;
+
+  for (id = 0; id < PIO_OUT_NUM; id++)
+  {
+    v = pio_shadow_read(id);
+    if (v != snap[id])
+    {
+      snap[id] = v;
+      n++;
+    }
+  }
+  return n;
+}
+
+static void selftest_snapshot( alt_u32* snap )
+{
+  int id;
+
+  for (id = 0; id < PIO_OUT_NUM; id++)
+  {
+    snap[id] = pio_shadow_read(id);
+  }
+}
+
+/* Bus writes issued across 'first'..'last' since the stats were reset. */
+
+static alt_u32 selftest_issued( int first, int last )
+{
+  struct pio_shadow_stats st;
+  alt_u32 n = 0;
+  int id;
+
+  for (id = first; id <= last; id++)
+  {
+    pio_shadow_get_stats(id, &st);
+    n += st.issued;
+  }
+  return n;
+}
+
+static int selftest_check_issued( struct selftest_ctx* ctx, alt_u32 expect,
+                                  alt_u32 issued, int steps )
+{
+  if (issued != expect)
+  {
+    snprintf(ctx->detail, sizeof(ctx->detail), "%lu of %lu writes issued",
+      (unsigned long) issued, (unsigned long) expect);
+    return SELFTEST_FAIL;
+  }
+  snprintf(ctx->detail, sizeof(ctx->detail), "%d patterns, %lu writes",
+    steps, (unsigned long) issued);
+  return SELFTEST_PASS;
+}
+
+#endif
+
+#ifdef LED_PIO_BASE
+
+/* Walk a single lit LED across the green, then the red, LEDs. */
+
+static int selftest_led( struct selftest_ctx* ctx )
+{
+  alt_u32 snap[PIO_OUT_NUM];
+  alt_u32 expect = 0;
+  int steps = 0;
+  int bit;
+
+  red_count_stop();
+  led_bam_stop();
+  led_anim_show(0x00000000);
+  pio_shadow_flush();
+  selftest_snapshot(snap);
+  pio_shadow_reset_stats();
+
+  for (bit = 0; bit < LED_PIO_DATA_WIDTH; bit++, steps++)
+  {
+    pio_shadow_write(PIO_OUT_LED, 1u << bit);
+    expect += selftest_changed(snap);
+    pio_shadow_flush();
+    timer_delay_us(SELFTEST_LED_STEP_US);
+  }
+  pio_shadow_write(PIO_OUT_LED, 0);
+#ifdef RED_LED_BASE
+  for (bit = 0; bit < RED_LED_DATA_WIDTH; bit++, steps++)
+  {
+    pio_shadow_write(PIO_OUT_RED, 1u << bit);
+    expect += selftest_changed(snap);
+    pio_shadow_flush();
+    timer_delay_us(SELFTEST_LED_STEP_US);
+  }
+  pio_shadow_write(PIO_OUT_RED, 0);
+#endif
+  expect += selftest_changed(snap);
+  pio_shadow_flush();
+
+  if (selftest_expired(ctx))
+  {
+    return SELFTEST_TIMEOUT;
+  }
+  return selftest_check_issued(ctx, expect,
+    selftest_issued(PIO_OUT_LED, PIO_OUT_RED), steps);
+}
+
+#endif
+
+#ifdef SEVEN_SEG_PIO_BASE
+
+/* Light all segments of one digit at a time, left to right. */
+
+static int selftest_seg( struct selftest_ctx* ctx )
+{
+  char text[SEG_TEXT_DIGITS + 1];
+  alt_u32 snap[PIO_OUT_NUM];
+  alt_u32 expect = 0;
+  int digit;
+
+  seg_text_clear();
+  pio_shadow_flush();
+  selftest_snapshot(snap);
+  pio_shadow_reset_stats();
+
+  for (digit = 0; digit < SEG_TEXT_DIGITS; digit++)
+  {
+    memset(text, ' ', SEG_TEXT_DIGITS);
+    text[digit] = '8';
+    text[SEG_TEXT_DIGITS] = '\0';
+    seg_text_show(text);
+    expect += selftest_changed(snap);
+    pio_shadow_flush();
+    timer_delay_us(SELFTEST_SEG_STEP_US);
+  }
+  seg_text_clear();
+  expect += selftest_changed(snap);
+  pio_shadow_flush();
+
+  if (selftest_expired(ctx))
+  {
+    return SELFTEST_TIMEOUT;
+  }
+  return selftest_check_issued(ctx, expect,
+    selftest_issued(PIO_OUT_SEG, PIO_OUT_SEG_1), SEG_TEXT_DIGITS);
+}
+
+#endif
+
+#ifdef LCD_DISPLAY_BASE
+
+/* Fill both rows, time the update through the driver, then clear. */
+
+static int selftest_lcd( struct selftest_ctx* ctx )
+{
+  FILE* fp = lcd_fb_stream();
+  alt_u64 start;
+  alt_u32 us;
+  int sent;
+
+  if (fp == NULL)
+  {
+    snprintf(ctx->detail, sizeof(ctx->detail), "cannot open the LCD");
+    return SELFTEST_FAIL;
+  }
+  lcd_fb_reset();
+  lcd_fb_puts(0, "0123456789ABCDEF");
+  lcd_fb_puts(1, "SELF TEST");
+  start = timer_now_cycles();
+  sent = lcd_fb_update();
+  fflush(fp);
+  us = (alt_u32)((timer_now_cycles() - start) / timer_cycles_per_us());
+  if (ferror(fp) || sent == 0)
+  {
+    clearerr(fp);
+    snprintf(ctx->detail, sizeof(ctx->detail), "write failed after %d bytes", sent);
+    return SELFTEST_FAIL;
+  }
+  timer_delay_us(SELFTEST_LCD_HOLD_US);
+  lcd_fb_clear();
+  lcd_fb_update();
+  fflush(fp);
+
+  if (selftest_expired(ctx))
+  {
+    return SELFTEST_TIMEOUT;
+  }
+  snprintf(ctx->detail, sizeof(ctx->detail), "%d bytes in %lu us",
+    sent, (unsigned long) us);
+  return SELFTEST_PASS;
+}
+
+#endif
+
+#if defined(KEY_BASE) || defined(BUTTON_PIO_BASE)
+
+/* Nobody is at the board: no key may read as held, and no input may move. */
+
+static int selftest_buttons( struct selftest_ctx* ctx )
+{
+  struct button_stats st;
+  alt_u32 keys;
+
+  buttons_reset_stats();
+  timer_delay_us(SELFTEST_IDLE_US);
+  buttons_get_stats(&st);
+  buttons_flush();
+  keys = buttons_pressed(INPUT_SRC_KEY);
+
+  if (keys != 0)
+  {
+    snprintf(ctx->detail, sizeof(ctx->detail), "KEY 0x%lx held",
+      (unsigned long) keys);
+    return SELFTEST_FAIL;
+  }
+  if (st.raw_edges != 0)
+  {
+    snprintf(ctx->detail, sizeof(ctx->detail), "%lu edges while idle",
+      (unsigned long) st.raw_edges);
+    return SELFTEST_FAIL;
+  }
+  if (selftest_expired(ctx))
+  {
+    return SELFTEST_TIMEOUT;
+  }
+  snprintf(ctx->detail, sizeof(ctx->detail), "idle, switches 0x%05lx",
+    (unsigned long) buttons_pressed(INPUT_SRC_SWITCH));
+  return SELFTEST_PASS;
+}
+
+#endif
+
+#ifdef JTAG_UART_BASE
+
+/* Everything reported so far must have drained from the ring to the driver. */
+
+static int selftest_uart( struct selftest_ctx* ctx )
+{
+  struct uart_tx_stats st;
+
+  if (uart_tx_write("", 0) < 0)
+  {
+    snprintf(ctx->detail, sizeof(ctx->detail), "cannot open the JTAG UART");
+    return SELFTEST_FAIL;
+  }
+  while (uart_tx_pending() > 0)
+  {
+    uart_tx_poll();
+    if (selftest_expired(ctx))
+    {
+      snprintf(ctx->detail, sizeof(ctx->detail), "%d bytes stuck",
+        uart_tx_pending());
+      return SELFTEST_TIMEOUT;
+    }
+  }
+  uart_tx_get_stats(&st);
+  snprintf(ctx->detail, sizeof(ctx->detail), "%lu bytes sent, %lu stalls",
+    (unsigned long) st.sent, (unsigned long) st.stalls);
+  return SELFTEST_PASS;
+}
+
+#endif
+
+#ifdef ONCHIP_MEM_BASE
+
+/* Every memory test algorithm over the free part of onchip_mem. */
+
+static int selftest_mem( struct selftest_ctx* ctx )
+{
+  struct memtest_result r;
+  alt_u32 base, len;
+  alt_u32 bytes = 0;
+  alt_u32 us = 0;
+  alt_u32 rate;
+  int algo;
+
+  if (memtest_region(&base, &len) < 0)
+  {
+    snprintf(ctx->detail, sizeof(ctx->detail), "no free memory to test");
+    return SELFTEST_FAIL;
+  }
+  for (algo = 0; algo < MEMTEST_NUM_ALGOS; algo++)
+  {
+    if (memtest_run(algo, base, len, &r) != 0)
+    {
+      snprintf(ctx->detail, sizeof(ctx->detail), "%s: %lu errors, first 0x%08lx",
+        memtest_name(algo), (unsigned long) r.errors, (unsigned long) r.first_addr);
+      return SELFTEST_FAIL;
+    }
+    bytes += r.bytes;
+    us += r.us;
+  }
+  rate = us ? (alt_u32)((alt_u64) bytes * 100 / us) : 0;
+  snprintf(ctx->detail, sizeof(ctx->detail), "%lu bytes at 0x%08lx, %lu.%02lu MB/s",
+    (unsigned long) len, (unsigned long) base,
+    (unsigned long)(rate / 100), (unsigned long)(rate % 100));
+  return SELFTEST_PASS;
+}
+
+#endif
+
+#ifdef SYSID_BASE
+
+/* The hardware must be the system this software was built for. */
+
+static int selftest_sysid( struct selftest_ctx* ctx )
+{
+  alt_u32 id = IORD(SYSID_BASE, 0);
+  alt_u32 stamp = IORD(SYSID_BASE, 1);
+
+  snprintf(ctx->detail, sizeof(ctx->detail), "id 0x%08lx timestamp %lu",
+    (unsigned long) id, (unsigned long) stamp);
+  if (id != (alt_u32) SYSID_ID || stamp != (alt_u32) SYSID_TIMESTAMP)
+  {
+    return SELFTEST_FAIL;
+  }
+  return SELFTEST_PASS;
+}
+
+#endif
+
+static const struct selftest_entry selftests[] =
+{
+#ifdef SYSID_BASE
+  { "sysid",    100,  selftest_sysid },
+#endif
+#ifdef ONCHIP_MEM_BASE
+  { "onchip_mem", 10000, selftest_mem },
+#endif
+#ifdef LED_PIO_BASE
+  { "led",      2000, selftest_led },
+#endif
+#ifdef SEVEN_SEG_PIO_BASE
+  { "sevenseg", 2000, selftest_seg },
+#endif
+#ifdef LCD_DISPLAY_BASE
+  { "lcd",      2000, selftest_lcd },
+#endif
+#if defined(KEY_BASE) || defined(BUTTON_PIO_BASE)
+  { "buttons",  1000, selftest_buttons },
+#endif
+#ifdef JTAG_UART_BASE
+  { "jtag_uart", 2000, selftest_uart },
+#endif
+};
+
+#define SELFTEST_NUM ((int)(sizeof(selftests) / sizeof(selftests[0])))
+
+int selftest_count( void )
+{
+  return SELFTEST_NUM;
+}
+
+int selftest_run_all( void )
+{
+  struct selftest_ctx ctx;
+  struct cpu_load_sample all, each;
+  char load[SELFTEST_LOAD_MAX];
+  int counts[3] = { 0, 0, 0 };
+  alt_u64 start = timer_now_cycles();
+  alt_u64 t0;
+  alt_u32 us;
+  int i, status;
+
+  fflush(stdout);
+  cpu_load_total(&all);
+  uart_tx_reset_stats();
+  selftest_emit("{\"selftest\":\"begin\",\"tests\":%d}", SELFTEST_NUM);
+  for (i = 0; i < SELFTEST_NUM; i++)
+  {
+    ctx.deadline = timer_now_us() + (alt_u64) selftests[i].timeout_ms * 1000;
+    ctx.detail[0] = '\0';
+    cpu_load_total(&each);
+    t0 = timer_now_cycles();
+    status = selftests[i].run(&ctx);
+    us = (alt_u32)((timer_now_cycles() - t0) / timer_cycles_per_us());
+    selftest_load(load, sizeof(load), &each);
+    if (status == SELFTEST_PASS && selftest_expired(&ctx))
+    {
+      status = SELFTEST_TIMEOUT;
+    }
+    counts[status]++;
+    selftest_emit("{\"test\":\"%s\",\"status\":\"%s\",\"us\":%lu,\"detail\":\"%s\",\"cpu\":%s}",
+      selftests[i].name, selftest_status[status], (unsigned long) us, ctx.detail, load);
+  }
+  us = (alt_u32)((timer_now_cycles() - start) / timer_cycles_per_us());
+  selftest_load(load, sizeof(load), &all);
+  selftest_emit("{\"selftest\":\"end\",\"pass\":%d,\"fail\":%d,\"us\":%lu,\"cpu\":%s}",
+    counts[SELFTEST_PASS], counts[SELFTEST_FAIL] + counts[SELFTEST_TIMEOUT],
+    (unsigned long) us, load);
+  uart_tx_flush();
+  return counts[SELFTEST_FAIL] + counts[SELFTEST_TIMEOUT];
+}
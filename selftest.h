@@ -0,0 +1,45 @@
+/******************************************************************************
+ *
+ * selftest.h
+ *
+ * Operator-free self-test of every peripheral compiled into the design.
+ *
+ * selftest_run_all() runs the sysid, on-chip memory, LED, seven-segment,
+ * LCD, button and JTAG UART tests back to back, each against its own time limit, and
+ * streams one compact JSON object per line on the JTAG UART (through
+ * uart_tx), for a test station to collect:
+ *
+ *   {"selftest":"begin","tests":7}
+ *   {"test":"led","status":"pass","us":260025,"detail":"26 patterns, 28 writes",
+ *    "cpu":{"busy":0.4,"idle":97.1,"io_wait":0.0,"isr":2.5}}  (one line)
+ *   ...
+ *   {"selftest":"end","pass":7,"fail":0,"us":1904148,"cpu":{...}}
+ *
+ * 'status' is "pass", "fail" or "timeout"; a test that runs past its limit
+ * counts as a failure.  'cpu' is where the CPU's time went during the test,
+ * in percent (see cpu_load.h).  Nothing is read from the console, and the outputs
+ * are left blank afterwards.
+ *
+ * Building with BOARD_DIAG_BATCH defined makes main() run the self-test at
+ * start-up and exit with the failure count instead of showing the menu.
+ *
+ ******************************************************************************/
+
+#ifndef __SELFTEST_H__
+#define __SELFTEST_H__
+
+#include "alt_types.h"
+
+#define SELFTEST_PASS    0
+#define SELFTEST_FAIL    1
+#define SELFTEST_TIMEOUT 2
+
+#define SELFTEST_DETAIL_MAX 64
+
+/* Run every compiled-in test.  Returns the number that did not pass. */
+int selftest_run_all( void );
+
+/* Number of compiled-in tests. */
+int selftest_count( void );
+
+#endif /* __SELFTEST_H__ */
@@ -0,0 +1,265 @@
+/******************************************************************************
+ *
+ * stress.c
+ *
+ * Timing stress.  See stress.h.
+ *
+ * Each round is STRESS_ROUND passes of the b2b and toggle patterns and one
+ * LCD burst; the clock is only looked at between rounds, so the PIO
+ * accesses within a pass follow each other as closely as the loop allows.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "system.h"
+#include "alt_types.h"
+#include "altera_avalon_pio_regs.h"
+
+#include "timer_service.h"
+#include "pio_shadow.h"
+#include "led_anim.h"
+#include "red_count.h"
+#include "led_bam.h"
+#include "seg_text.h"
+#include "lcd_fb.h"
+#include "stress.h"
+#include "bus_prof.h"
+#include "io_trace.h"
+
+#define STRESS_WIDTH_MASK(w) ((alt_u32)((1ULL << (w)) - 1))
+
+#define STRESS_XS(v) ((v) ^= (v) << 13, (v) ^= (v) >> 17, (v) ^= (v) << 5)
+
+#define STRESS_SEED  0x9e3779b9
+
+#define STRESS_B2B    0
+#define STRESS_TOGGLE 1
+#define STRESS_LCD    2
+
+struct stress_slot
+{
+  int kind;
+  alt_u32 base;
+  alt_u32 mask;
+  struct stress_path p;
+};
+
+#define STRESS_PIO(kind, pattern, prefix, name) \
+  { kind, prefix##_BASE, STRESS_WIDTH_MASK(prefix##_DATA_WIDTH), \
+    { pattern, name, 0, 0, 0, 0, 0 } }
+
+/* The b2b paths, then the others. */
+static struct stress_slot stress_slots[] =
+{
+#ifdef LED_PIO_BASE
+  STRESS_PIO(STRESS_B2B, "b2b", LED_PIO, "led_pio"),
+#endif
+#ifdef RED_LED_BASE
+  STRESS_PIO(STRESS_B2B, "b2b", RED_LED, "red_led"),
+#endif
+#ifdef SEVEN_SEG_PIO_BASE
+  STRESS_PIO(STRESS_B2B, "b2b", SEVEN_SEG_PIO, "seven_seg_pio"),
+#endif
+#ifdef SEVEN_SEG_PIO_1_BASE
+  STRESS_PIO(STRESS_B2B, "b2b", SEVEN_SEG_PIO_1, "seven_seg_pio_1"),
+#endif
+#ifdef RED_LED_BASE
+  STRESS_PIO(STRESS_TOGGLE, "toggle", RED_LED, "red_led"),
+#endif
+#ifdef LCD_DISPLAY_BASE
+  { STRESS_LCD, LCD_DISPLAY_BASE, 0, { "lcd", "lcd_display", 0, 0, 0, 0, 0 } },
+#endif
+};
+
+#define STRESS_NUM_SLOTS ((int)(sizeof(stress_slots) / sizeof(stress_slots[0])))
+
+#ifdef LCD_DISPLAY_BASE
+/* 'U' and '*' are complements in the seven bits the LCD takes. */
+static const char* const stress_screens[2] =
+{
+  "\x1b[1;0HUUUUUUUUUUUUUUUU\x1b[2;0HUUUUUUUUUUUUUUUU",
+  "\x1b[1;0H****************\x1b[2;0H****************"
+};
+#endif
+
+static int stress_num_b2b;
+static alt_u32 stress_us;
+
+static void stress_check( struct stress_path* p, alt_u32 expect, alt_u32 actual )
+{
+  p->checks++;
+  if (actual != expect && p->mismatches++ == 0)
+  {
+    p->first_expect = expect;
+    p->first_actual = actual;
+  }
+}
+
+static void stress_b2b( alt_u32* seed )
+{
+  alt_u32 sent[STRESS_MAX_PATHS];
+  alt_u32 v = *seed;
+  int n, i;
+
+  for (n = 0; n < STRESS_ROUND; n++)
+  {
+    for (i = 0; i < stress_num_b2b; i++)
+    {
+      STRESS_XS(v);
+      sent[i] = v & stress_slots[i].mask;
+      IOWR_ALTERA_AVALON_PIO_DATA(stress_slots[i].base, v);
+    }
+    for (i = 0; i < stress_num_b2b; i++)
+    {
+      stress_check(&stress_slots[i].p, sent[i],
+        IORD_ALTERA_AVALON_PIO_DATA(stress_slots[i].base) & stress_slots[i].mask);
+    }
+  }
+  for (i = 0; i < stress_num_b2b; i++)
+  {
+    stress_slots[i].p.writes += STRESS_ROUND;
+  }
+  *seed = v;
+}
+
+static void stress_toggle( struct stress_slot* s )
+{
+  int n;
+
+  for (n = 0; n < STRESS_ROUND; n++)
+  {
+    IOWR_ALTERA_AVALON_PIO_DATA(s->base, 0x00000000);
+    stress_check(&s->p, 0, IORD_ALTERA_AVALON_PIO_DATA(s->base) & s->mask);
+    IOWR_ALTERA_AVALON_PIO_DATA(s->base, 0xffffffff);
+    stress_check(&s->p, s->mask, IORD_ALTERA_AVALON_PIO_DATA(s->base) & s->mask);
+  }
+  s->p.writes += 2 * STRESS_ROUND;
+}
+
+#ifdef LCD_DISPLAY_BASE
+static void stress_lcd( struct stress_slot* s )
+{
+  FILE* lcd = lcd_fb_stream();
+  const char* screen = stress_screens[s->p.checks & 1];
+
+  if (lcd == NULL)
+  {
+    return;
+  }
+  fputs(screen, lcd);
+  fflush(lcd);
+  s->p.writes += strlen(screen);
+  stress_check(&s->p, 0, ferror(lcd) ? 1 : 0);
+  clearerr(lcd);
+}
+#endif
+
+static alt_u32 stress_total( void )
+{
+  alt_u32 total = 0;
+  int i;
+
+  for (i = 0; i < STRESS_NUM_SLOTS; i++)
+  {
+    total += stress_slots[i].p.mismatches;
+  }
+  return total;
+}
+
+int stress_count( void )
+{
+  return STRESS_NUM_SLOTS;
+}
+
+alt_u32 stress_run( alt_u32 ms, alt_u32 report_ms )
+{
+  struct stress_slot* s;
+  alt_u32 seed = STRESS_SEED;
+  alt_u64 start, now, next_report;
+  int i;
+
+  stress_num_b2b = 0;
+  for (i = 0; i < STRESS_NUM_SLOTS; i++)
+  {
+    s = &stress_slots[i];
+    s->p.writes = 0;
+    s->p.checks = 0;
+    s->p.mismatches = 0;
+    s->p.first_expect = 0;
+    s->p.first_actual = 0;
+    if (s->kind == STRESS_B2B)
+    {
+      stress_num_b2b++;
+    }
+  }
+
+  /* Nothing else may write the PIOs while their read-backs are checked. */
+  led_anim_stop();
+  red_count_stop();
+  led_bam_stop();
+  seg_text_clear();
+  pio_shadow_flush();
+
+  start = timer_now_us();
+  next_report = report_ms;
+  do
+  {
+    stress_b2b(&seed);
+    for (i = stress_num_b2b; i < STRESS_NUM_SLOTS; i++)
+    {
+      s = &stress_slots[i];
+      if (s->kind == STRESS_TOGGLE)
+      {
+        stress_toggle(s);
+      }
+#ifdef LCD_DISPLAY_BASE
+      else
+      {
+        stress_lcd(s);
+      }
+#endif
+    }
+    now = (timer_now_us() - start) / 1000;
+    if (report_ms && now >= next_report)
+    {
+      printf("STRESS ms=%lu mismatches=%lu\n", (unsigned long) now,
+        (unsigned long) stress_total());
+      next_report += report_ms;
+    }
+  }
+  while (now < ms);
+  stress_us = (alt_u32)(timer_now_us() - start);
+
+  pio_shadow_invalidate();
+  pio_shadow_flush();
+  lcd_fb_reset();
+  return stress_total();
+}
+
+void stress_get( int i, struct stress_path* out )
+{
+  *out = stress_slots[i].p;
+}
+
+void stress_report( void )
+{
+  struct stress_path* p;
+  int i;
+
+  for (i = 0; i < STRESS_NUM_SLOTS; i++)
+  {
+    p = &stress_slots[i].p;
+    printf("BENCH stress path=%s/%s cpu_hz=%lu us=%lu writes=%lu checks=%lu "
+      "mismatches=%lu", p->pattern, p->target, (unsigned long) ALT_CPU_FREQ,
+      (unsigned long) stress_us, (unsigned long) p->writes,
+      (unsigned long) p->checks, (unsigned long) p->mismatches);
+    if (p->mismatches)
+    {
+      printf(" first_expect=0x%08lx first_actual=0x%08lx",
+        (unsigned long) p->first_expect, (unsigned long) p->first_actual);
+    }
+    printf(" status=%s\n", p->mismatches ? "fail" : "pass");
+  }
+}
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ * stress.h
+ *
+ * Timing stress: worst-case traffic to the output peripherals in a loop,
+ * with every PIO write read back and compared.
+ *
+ * The timing exercise in the README loosens the .SDC until two paths fail
+ * and reads their waveforms.  This is the measurement to go with it: build
+ * the system at a series of PLL settings and run the stress at each.  The
+ * lowest frequency at which a path reports mismatches is where that path
+ * really fails, as against where the analysis says it does.
+ *
+ *   b2b      xorshift values written to led_pio, red_led, seven_seg_pio and
+ *            seven_seg_pio_1 back to back, then the four read back back to
+ *            back
+ *   toggle   red_led written 0x00000000 and 0xffffffff in turn, each value
+ *            read back, so every output bit switches on every write
+ *   lcd      full-screen rewrites of lcd_display in two alternating
+ *            patterns, as aggressor traffic next to the PIO paths
+ *
+ * The PIO core generated for an output-only port returns its output
+ * register on a read of the data register; the IP user guide leaves that
+ * read undefined, which is why the self-test does not rely on it.  The LCD
+ * character driver is write-only, so the lcd path counts only the bursts
+ * the driver failed.
+ *
+ * A run takes the output PIOs over: the LED animation, the red LED
+ * counter and the seven-segment text are stopped first, and the shadow
+ * registers are written back to the PIOs at the end.
+ *
+ ******************************************************************************/
+
+#ifndef __STRESS_H__
+#define __STRESS_H__
+
+#include "alt_types.h"
+
+#define STRESS_MAX_PATHS 6
+#define STRESS_ROUND     256    /* PIO passes between LCD bursts */
+
+struct stress_path
+{
+  const char* pattern;  /* "b2b", "toggle" or "lcd" */
+  const char* target;   /* slave name from system.h */
+  alt_u32 writes;       /* PIO writes, or LCD bytes */
+  alt_u32 checks;       /* read-backs compared, or LCD bursts */
+  alt_u32 mismatches;
+  alt_u32 first_expect; /* the first mismatch */
+  alt_u32 first_actual;
+};
+
+/* Number of paths built for this system. */
+int stress_count( void );
+
+/*
+ * Run every path for 'ms' milliseconds, printing a progress line every
+ * 'report_ms' (0 for none).  Returns the total number of mismatches.
+ */
+alt_u32 stress_run( alt_u32 ms, alt_u32 report_ms );
+
+/* Counts of path 'i' from the last run. */
+void stress_get( int i, struct stress_path* out );
+
+/* Print one BENCH line per path for the last run. */
+void stress_report( void );
+
+#endif /* __STRESS_H__ */
@@ -0,0 +1,193 @@
+/******************************************************************************
+ *
+ * timer_service.c
+ *
+ * Timekeeping, delays and periodic tick hooks built on sys_clk_timer.
+ * See timer_service.h.
+ *
+ * The timestamp is
+ *
+ *   ticks * period + (period - 1 - snapshot)
+ *
+ * where 'ticks' is the HAL system clock tick count and 'snapshot' the down
+ * counter latched through the snapshot register.  Both are sampled with
+ * interrupts disabled; if the counter has wrapped but the tick interrupt has
+ * not been serviced yet (TO still set), the missing tick is added here.
+ *
+ ******************************************************************************/
+
+#include "system.h"
+#include "alt_types.h"
+#include "altera_avalon_timer_regs.h"
+#include "sys/alt_alarm.h"
+#include "sys/alt_irq.h"
+
+#include "timer_service.h"
+#include "cpu_load.h"
+
+#ifndef SYS_CLK_TIMER_BASE
+#error "timer_service requires the sys_clk_timer interval timer"
+#endif
+
+#define TIMER_BASE SYS_CLK_TIMER_BASE
+
+struct timer_hook
+{
+  timer_tick_fn fn;
+  void* context;
+};
+
+static alt_u32 timer_period;
+static alt_u32 timer_per_us;
+static alt_u32 timer_last_ticks;
+static alt_u32 timer_ticks_high;
+static timer_idle_fn timer_idle_hook;
+static alt_alarm timer_alarm;
+static struct timer_hook timer_hooks[TIMER_MAX_TICK_HOOKS];
+
+/* Alarm callback: runs every tick hook, then re-arms for the next tick. */
+
+static alt_u32 timer_tick( void* context )
+{
+  alt_u64 begin = cpu_load_isr_begin();
+  int i;
+
+  (void) context;
+  for (i = 0; i < TIMER_MAX_TICK_HOOKS; i++)
+  {
+    if (timer_hooks[i].fn != NULL)
+    {
+      timer_hooks[i].fn(timer_hooks[i].context);
+    }
+  }
+  cpu_load_isr_end(begin);
+  return 1;
+}
+
+void timer_init( void )
+{
+  timer_period = ((IORD_ALTERA_AVALON_TIMER_PERIODH(TIMER_BASE) << 16) |
+                  (IORD_ALTERA_AVALON_TIMER_PERIODL(TIMER_BASE) & 0xffff)) + 1;
+  timer_per_us = SYS_CLK_TIMER_FREQ / 1000000;
+  timer_last_ticks = alt_nticks();
+  alt_alarm_start(&timer_alarm, 1, timer_tick, NULL);
+}
+
+alt_u64 timer_now_cycles( void )
+{
+  alt_irq_context context;
+  alt_u32 ticks;
+  alt_u32 snap;
+  alt_u32 status;
+  alt_u32 elapsed;
+  alt_u64 now;
+
+  context = alt_irq_disable_all();
+  ticks = alt_nticks();
+  IOWR_ALTERA_AVALON_TIMER_SNAPL(TIMER_BASE, 0);
+  snap = (IORD_ALTERA_AVALON_TIMER_SNAPL(TIMER_BASE) & 0xffff) |
+         (IORD_ALTERA_AVALON_TIMER_SNAPH(TIMER_BASE) << 16);
+  status = IORD_ALTERA_AVALON_TIMER_STATUS(TIMER_BASE);
+
+  elapsed = timer_period - 1 - snap;
+  if ((status & ALTERA_AVALON_TIMER_STATUS_TO_MSK) && elapsed < timer_period / 2)
+  {
+    /* Wrapped after the last tick interrupt was taken. */
+    ticks++;
+  }
+
+  /* Extend the 32-bit tick count so timestamps never wrap. */
+  if (ticks < timer_last_ticks)
+  {
+    timer_ticks_high++;
+  }
+  timer_last_ticks = ticks;
+  now = (((alt_u64) timer_ticks_high << 32) | ticks) * timer_period + elapsed;
+  alt_irq_enable_all(context);
+
+  return now;
+}
+
+alt_u64 timer_now_us( void )
+{
+  return timer_now_cycles() / timer_per_us;
+}
+
+alt_u32 timer_cycles_per_us( void )
+{
+  return timer_per_us;
+}
+
+alt_u32 timer_tick_us( void )
+{
+  return timer_period / timer_per_us;
+}
+
+void timer_set_idle_hook( timer_idle_fn hook )
+{
+  timer_idle_hook = hook;
+}
+
+void timer_idle( void )
+{
+  int prev = cpu_load_enter(CPU_LOAD_IDLE);
+
+  if (timer_idle_hook != NULL)
+  {
+    timer_idle_hook();
+  }
+  cpu_load_leave(prev);
+}
+
+void timer_delay_until( alt_u64 deadline_cycles )
+{
+  int prev = cpu_load_enter(CPU_LOAD_IDLE);
+
+  while (timer_now_cycles() < deadline_cycles)
+  {
+    timer_idle();
+  }
+  cpu_load_leave(prev);
+}
+
+void timer_delay_us( alt_u32 us )
+{
+  timer_delay_until(timer_now_cycles() + (alt_u64) us * timer_per_us);
+}
+
+int timer_add_tick_hook( timer_tick_fn fn, void* context )
+{
+  alt_irq_context irq;
+  int i;
+  int ret = -1;
+
+  irq = alt_irq_disable_all();
+  for (i = 0; i < TIMER_MAX_TICK_HOOKS; i++)
+  {
+    if (timer_hooks[i].fn == NULL)
+    {
+      timer_hooks[i].context = context;
+      timer_hooks[i].fn = fn;
+      ret = 0;
+      break;
+    }
+  }
+  alt_irq_enable_all(irq);
+  return ret;
+}
+
+void timer_remove_tick_hook( timer_tick_fn fn, void* context )
+{
+  alt_irq_context irq;
+  int i;
+
+  irq = alt_irq_disable_all();
+  for (i = 0; i < TIMER_MAX_TICK_HOOKS; i++)
+  {
+    if (timer_hooks[i].fn == fn && timer_hooks[i].context == context)
+    {
+      timer_hooks[i].fn = NULL;
+    }
+  }
+  alt_irq_enable_all(irq);
+}
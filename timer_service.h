@@ -0,0 +1,53 @@
+/******************************************************************************
+ *
+ * timer_service.h
+ *
+ * Timekeeping, delays and periodic tick hooks built on sys_clk_timer.
+ *
+ * The HAL system clock driver owns sys_clk_timer and counts one tick per
+ * timeout (1 ms in de2i_150_qsys.qsys).  This service combines that tick count
+ * with the timer's snapshot register to give a cycle-resolution, monotonic
+ * timestamp, so delays no longer depend on compiler optimisation or the Nios
+ * II core variant the way the old empty for-loop did.
+ *
+ ******************************************************************************/
+
+#ifndef __TIMER_SERVICE_H__
+#define __TIMER_SERVICE_H__
+
+#include "alt_types.h"
+
+#define TIMER_MAX_TICK_HOOKS 10
+
+typedef void (*timer_tick_fn)( void* context );
+typedef void (*timer_idle_fn)( void );
+
+/* Start the service.  Must be called once from main() before any other call. */
+void timer_init( void );
+
+/* Timer clock cycles / microseconds since the HAL system clock started. */
+alt_u64 timer_now_cycles( void );
+alt_u64 timer_now_us( void );
+alt_u32 timer_cycles_per_us( void );
+
+/* Busy-free delays: the idle hook runs until the deadline has passed. */
+void timer_delay_us( alt_u32 us );
+void timer_delay_until( alt_u64 deadline_cycles );
+
+/*
+ * Idle hook, called repeatedly while a delay is waiting.  Nios II has no
+ * wait-for-interrupt instruction, so this is where background work runs.
+ * Time in timer_idle() and in the delays is counted as idle by cpu_load.
+ */
+void timer_set_idle_hook( timer_idle_fn hook );
+void timer_idle( void );
+
+/*
+ * Tick hooks run from the system clock interrupt on every tick.  They must be
+ * short and must not call stdio.  Returns 0, or -1 when the table is full.
+ */
+int timer_add_tick_hook( timer_tick_fn fn, void* context );
+void timer_remove_tick_hook( timer_tick_fn fn, void* context );
+alt_u32 timer_tick_us( void );
+
+#endif /* __TIMER_SERVICE_H__ */
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""Replay contact bounce waveforms through the host build's debouncer.
+
+Builds a BOARD_DIAG_SCRIPT input timeline of random presses on the key and
+button_pio bits, each press and release shaped by a waveform from
+bounce_waves.txt, with short noise pulses mixed in.  Then runs
+Performance Menu > Debounce Stress once per debounce time and compares the
+reported events with what was played:
+
+    tools/bounce_replay.py ./board_diag_host --presses 300 --debounce 0,2,5,10,20
+
+A false trigger is a reported press beyond the number played; a miss is a
+played press that was not reported.
+"""
+
+import argparse
+import math
+import os
+import random
+import re
+import subprocess
+import sys
+import tempfile
+
+KEY_BITS = 4            # KEY_DATA_WIDTH, active low
+SWITCH_BITS = 18        # BUTTON_PIO_DATA_WIDTH, active high
+LONG_MS = 1000          # BUTTON_LONG_MS
+
+
+def load_waves(path):
+    waves = {}
+    name = None
+    with open(path) as f:
+        for line in f:
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+            if line[0] == "wave":
+                name = line[1]
+                waves[name] = []
+            else:
+                waves[name].append((int(line[0]), int(line[1])))
+    return waves
+
+
+def build(args, waves):
+    """Return (timeline, truth); timeline is [(time_us, pio, value)]."""
+    rng = random.Random(args.seed)
+    edges = []          # (time_us, source, bit, pressed)
+    free_at = {}        # (source, bit) -> time the bit is idle again
+    truth = {"presses": 0, "longs": 0, "glitches": 0}
+    t = 100000
+
+    for _ in range(args.presses):
+        t += int(rng.expovariate(1.0 / args.gap_us))
+        source = "key" if rng.random() < 0.25 else "button_pio"
+        bit = rng.randrange(KEY_BITS if source == "key" else SWITCH_BITS)
+        start = max(t, free_at.get((source, bit), 0))
+        if rng.random() < 0.1:
+            hold = rng.randint(LONG_MS + 200, LONG_MS + 800) * 1000
+            truth["longs"] += 1
+        else:
+            hold = rng.randint(40, 400) * 1000
+        wave = waves[rng.choice(sorted(waves))]
+        for dt, level in wave:
+            edges.append((start + dt, source, bit, level))
+        for dt, level in wave:
+            edges.append((start + hold + dt, source, bit, 1 - level))
+        free_at[(source, bit)] = start + hold + wave[-1][0] + 20000
+        truth["presses"] += 1
+
+    end = max(e[0] for e in edges) if edges else t
+    for _ in range(args.glitches):
+        source = "key" if rng.random() < 0.25 else "button_pio"
+        bit = rng.randrange(KEY_BITS if source == "key" else SWITCH_BITS)
+        start = rng.randint(100000, end)
+        width = rng.randint(200, 3000)
+        busy = any(e[1] == source and e[2] == bit and abs(e[0] - start) < 30000
+                   for e in edges)
+        if busy:
+            continue
+        # Pulse away from the bit's level at that time, then back.
+        level = 0
+        for e in sorted(e for e in edges if e[1] == source and e[2] == bit):
+            if e[0] <= start:
+                level = e[3]
+        edges.append((start, source, bit, 1 - level))
+        edges.append((start + width, source, bit, level))
+        truth["glitches"] += 1
+
+    pressed = {"key": 0, "button_pio": 0}
+    timeline = [(0, "key", 0xF), (0, "button_pio", 0)]
+    for time_us, source, bit, level in sorted(edges):
+        if level:
+            pressed[source] |= 1 << bit
+        else:
+            pressed[source] &= ~(1 << bit)
+        value = pressed[source]
+        if source == "key":
+            value = ~value & ((1 << KEY_BITS) - 1)
+        timeline.append((time_us, source, value))
+    return timeline, truth, end
+
+
+def run(binary, script, ms, secs):
+    env = dict(os.environ, BOARD_DIAG_SCRIPT=script)
+    menu = "g\ng\n%d\n%d\nq\nq\n" % (ms, secs)
+    out = subprocess.run([binary], input=menu.encode(), env=env,
+                         stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                         check=False).stdout.decode(errors="replace")
+    m = re.search(r"^BENCH debounce (.*)$", out, re.M)
+    if not m:
+        sys.exit("bounce_replay: no BENCH line from %s" % binary)
+    return {k: int(v) for k, v in (kv.split("=") for kv in m.group(1).split())}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("binary", help="host build of board_diag")
+    ap.add_argument("--waves", default=os.path.join(os.path.dirname(__file__),
+                                                    "bounce_waves.txt"))
+    ap.add_argument("--presses", type=int, default=200)
+    ap.add_argument("--glitches", type=int, default=50,
+                    help="noise pulses of 0.2-3 ms to mix in")
+    ap.add_argument("--gap-us", type=int, default=60000,
+                    help="mean time between press starts")
+    ap.add_argument("--debounce", default="0,2,5,10,20",
+                    help="comma-separated debounce times in ms")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--keep", metavar="FILE", help="also write the script here")
+    args = ap.parse_args()
+
+    timeline, truth, end = build(args, load_waves(args.waves))
+    text = "".join("%d %s 0x%x\n" % e for e in timeline)
+    if args.keep:
+        with open(args.keep, "w") as f:
+            f.write(text)
+    secs = int(math.ceil(end / 1e6)) + 2
+
+    print("played: %d presses (%d long), %d noise pulses, %d script lines, %d s"
+          % (truth["presses"], truth["longs"], truth["glitches"], len(timeline), secs))
+    print("%5s %9s %8s %6s %7s %6s %6s %8s %9s %10s"
+          % ("ms", "raw_edges", "presses", "false", "false%", "missed",
+             "longs", "glitches", "raw_per_s", "events_per_s"))
+    with tempfile.NamedTemporaryFile("w", suffix=".txt") as f:
+        f.write(text)
+        f.flush()
+        for ms in (int(x) for x in args.debounce.split(",")):
+            r = run(args.binary, f.name, ms, secs)
+            false = max(0, r["presses"] - truth["presses"])
+            missed = max(0, truth["presses"] - r["presses"])
+            print("%5d %9d %8d %6d %6.1f%% %6d %6d %8d %9d %10d"
+                  % (ms, r["raw_edges"], r["presses"], false,
+                     100.0 * false / max(1, truth["presses"]), missed,
+                     r["longs"], r["glitches"], r["raw_per_s"], r["events_per_s"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Check the CPU load accounting against the host build's simulated clock.
+
+Runs Performance Menu > CPU Load on the host build at several synthetic
+loads, with BOARD_DIAG_STATS on, and checks the BENCH cpu_load span=run
+line:
+
+  - the run lasted the time asked for and the shares add up to 100%,
+  - busy and idle are the load asked for and the rest, less the share
+    the interrupt handlers took out of each,
+  - the isr share agrees with the cycles host_hal.c charged inside
+    interrupt handlers over the whole process.
+
+    tools/cpu_load_check.py ./board_diag_host
+    tools/cpu_load_check.py ./board_diag_host --loads 0,33,100 --seconds 2
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+SHARES = ("busy", "idle", "io_wait", "isr")
+
+
+def run(binary, load, seconds):
+    menu = ("g\nl\n%d\n%d\nq\nq\n" % (load, seconds)).encode()
+    env = dict(os.environ, BOARD_DIAG_STATS="1")
+    out = subprocess.run([binary], input=menu, env=env, stdout=subprocess.PIPE,
+                         stderr=subprocess.STDOUT,
+                         check=False).stdout.decode(errors="replace")
+    m = re.search(r"BENCH cpu_load span=run ms=(\d+) " +
+                  " ".join(r"%s=([\d.]+)" % s for s in SHARES), out)
+    if m is None:
+        sys.exit("cpu_load_check: no BENCH cpu_load span=run line from %s" % binary)
+    host = re.search(r"host_hal: \d+ cycles \(([\d.]+)%\) in interrupt handlers", out)
+    if host is None:
+        sys.exit("cpu_load_check: no host_hal interrupt total; is %s a host build?"
+                 % binary)
+    shares = dict(zip(SHARES, (float(v) for v in m.groups()[1:])))
+    return int(m.group(1)), shares, float(host.group(1))
+
+
+def check(load, seconds, ms, shares, host_isr, tol):
+    """Returns a list of problems, empty when the figures agree."""
+    problems = []
+    if abs(ms - seconds * 1000) > 2:
+        problems.append("ran %d ms, asked for %d" % (ms, seconds * 1000))
+    total = sum(shares.values())
+    if abs(total - 100) > 0.25:
+        problems.append("shares add up to %.1f%%" % total)
+    rest = 1 - shares["isr"] / 100
+    for name, want in (("busy", load * rest), ("idle", (100 - load) * rest)):
+        if abs(shares[name] - want) > tol:
+            problems.append("%s %.1f%%, expected %.1f%%" % (name, shares[name], want))
+    if abs(shares["isr"] - host_isr) > max(0.05, host_isr * 0.1):
+        problems.append("isr %.1f%%, host_hal charged %.2f%%" % (shares["isr"], host_isr))
+    return problems
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("binary", help="host build of board_diag")
+    ap.add_argument("--loads", default="0,10,25,50,75,90,100")
+    ap.add_argument("--seconds", type=int, default=3)
+    ap.add_argument("--tolerance", type=float, default=0.3,
+                    help="allowed error in busy and idle, in percent")
+    args = ap.parse_args()
+
+    failed = 0
+    print("%5s %7s %7s %7s %7s %9s  %s" %
+          ("load", "busy", "idle", "io_wait", "isr", "host_isr", "result"))
+    for load in (int(l) for l in args.loads.split(",")):
+        ms, shares, host_isr = run(args.binary, load, args.seconds)
+        problems = check(load, args.seconds, ms, shares, host_isr, args.tolerance)
+        failed += bool(problems)
+        print("%4d%% %6.1f%% %6.1f%% %6.1f%% %6.1f%% %8.2f%%  %s" %
+              (load, shares["busy"], shares["idle"], shares["io_wait"],
+               shares["isr"], host_isr, "; ".join(problems) or "ok"))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""Compare what snprintf() and fmt_format() add to a program's image.
+
+Links three minimal programs that each format one report line and write it
+to stdout: one with no formatting at all as the baseline, one with
+snprintf(), one with fmt.c.  Prints .text, .data and .bss for each and the
+growth over the baseline.  Unused sections are garbage-collected, so the
+growth is what the formatter really pulls in.
+
+    # host C library
+    tools/fmt_size.py
+
+    # Nios II newlib, as the board build links it; the BSP supplies the
+    # HAL headers, and its start-up code and system calls are left out
+    tools/fmt_size.py --cc nios2-elf-gcc --cflags "-I$BSP/HAL/inc -I$BSP" \\
+        --ldflags "-nostartfiles -Wl,--unresolved-symbols=ignore-all"
+
+A static glibc program contains printf even when it formats nothing, so on
+the host only the fmt row means anything; newlib links printf on demand.
+
+The cycles per line are measured on the board by Performance Menu >
+Formatter Cost.
+"""
+
+import argparse
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+LINE = ('"BENCH memtest algo=%s bytes=%lu us=%lu errors=%lu status=%s\\n", '
+        '"march_c-", (unsigned long) argc * 4801, (unsigned long) argc * 37, '
+        '(unsigned long) 0, "pass"')
+
+PROGRAMS = {
+    "none": """
+#include <string.h>
+#include <unistd.h>
+int main(int argc, char** argv)
+{
+  (void) argv;
+  char buf[128] = "BENCH memtest";
+  buf[13] = '0' + argc;
+  return write(1, buf, strlen(buf)) < 0;
+}
+""",
+    "snprintf": """
+#include <stdio.h>
+#include <unistd.h>
+int main(int argc, char** argv)
+{
+  (void) argv;
+  char buf[128];
+  int len = snprintf(buf, sizeof(buf), %s);
+  return write(1, buf, len) < 0;
+}
+""" % LINE,
+    "fmt": """
+#include <unistd.h>
+#include "fmt.h"
+/* fmt_print() queues on the UART ring; only fmt_format() is used here. */
+int uart_tx_write(const char* buf, int len) { return write(1, buf, len); }
+void uart_tx_flush(void) { }
+int main(int argc, char** argv)
+{
+  (void) argv;
+  char buf[128];
+  int len = fmt_format(buf, sizeof(buf), %s);
+  return write(1, buf, len) < 0;
+}
+""" % LINE,
+}
+
+
+def build(cc, cflags, ldflags, size, tmp, name):
+    src = os.path.join(tmp, name + ".c")
+    exe = os.path.join(tmp, name)
+    with open(src, "w") as f:
+        f.write(PROGRAMS[name])
+    files = [src] + ([os.path.join(REPO, "fmt.c")] if name == "fmt" else [])
+    cmd = ([cc, "-std=gnu99", "-Os", "-ffunction-sections", "-fdata-sections",
+            "-I" + REPO] + cflags + files +
+           ["-Wl,--gc-sections", "-o", exe] + ldflags)
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if res.returncode != 0:
+        sys.exit("fmt_size: %s failed:\n%s" % (" ".join(cmd),
+                                             res.stdout.decode(errors="replace")))
+    out = subprocess.run([size, exe], stdout=subprocess.PIPE,
+                         check=True).stdout.decode()
+    text, data, bss = (int(x) for x in out.splitlines()[1].split()[:3])
+    return text, data, bss
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--cc", default=os.environ.get("CC", "cc"))
+    ap.add_argument("--size", help="size tool (default: next to --cc)")
+    ap.add_argument("--cflags", default="-I" + os.path.join(REPO, "host"))
+    ap.add_argument("--ldflags", default="-static")
+    args = ap.parse_args()
+
+    size = args.size or re.sub(r"(gcc|cc|clang)$", "size", args.cc)
+    if size == args.cc:
+        size = "size"
+
+    with tempfile.TemporaryDirectory() as tmp:
+        sizes = {name: build(args.cc, shlex.split(args.cflags),
+                             shlex.split(args.ldflags), size, tmp, name)
+                 for name in PROGRAMS}
+
+    base = sizes["none"]
+    print("%-10s %8s %8s %8s   %8s %8s %8s" %
+          ("program", "text", "data", "bss", "+text", "+data", "+bss"))
+    for name, s in sizes.items():
+        print("%-10s %8d %8d %8d   %8d %8d %8d" %
+              ((name,) + s + tuple(a - b for a, b in zip(s, base))))
+
+
+if __name__ == "__main__":
+    main()
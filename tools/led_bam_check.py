@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""Check the LED brightness engine's duty cycles against what reached the PIOs.
+
+Runs Performance Menu > LED Brightness on the host build once per depth,
+with BOARD_DIAG_PIO_LOG recording every value led_pio and red_led drive,
+and rebuilds each LED's on-time over the whole periods the BENCH line
+reports.  The menu shows a ramp, LED i at brightness i * 255 / 25, so every
+LED of the 26 checks a different level:
+
+  - each LED is lit for level / (2^bits - 1) of the time, level being
+    round(brightness * (2^bits - 1) / 255), to within --tolerance,
+  - the table also shows how far that is from brightness / 255, which is
+    the quantisation the depth costs and is not checked.
+
+    tools/led_bam_check.py ./board_diag_host
+    tools/led_bam_check.py ./board_diag_host --bits 3,8 --seconds 4 -v
+
+A depth of 8 bits refreshes at under 4 Hz from the 1 ms tick, so it needs a
+few seconds to cover enough periods.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+LEDS = 26
+GREEN = 8
+
+
+def ramp(i):
+    return i * 255 // (LEDS - 1)
+
+
+def level(b, bits):
+    return (b * ((1 << bits) - 1) + 127) // 255
+
+
+def run(binary, bits, seconds, log):
+    menu = ("g\nn\n%d\n%d\nq\nq\n" % (bits, seconds)).encode()
+    env = dict(os.environ, BOARD_DIAG_PIO_LOG=log)
+    out = subprocess.run([binary], input=menu, env=env, stdout=subprocess.PIPE,
+                         stderr=subprocess.DEVNULL,
+                         check=False).stdout.decode(errors="replace")
+    m = re.search(r"BENCH led_bam bits=(\d+) levels=\d+ refresh_hz=(\S+) \S+ "
+                  r"periods=(\d+) t0_us=(\d+) period_us=(\d+)", out)
+    if m is None:
+        sys.exit("led_bam_check: no BENCH led_bam line from %s" % binary)
+    bench = dict(bits=int(m.group(1)), refresh=m.group(2), periods=int(m.group(3)),
+                 t0_us=int(m.group(4)), period_us=int(m.group(5)))
+    writes = []
+    with open(log) as f:
+        for line in f:
+            cycle, dev, v = line.split()
+            if dev == "led_pio":
+                writes.append((int(cycle), 0, int(v, 16)))
+            elif dev == "red_led":
+                writes.append((int(cycle), 1, int(v, 16)))
+    return bench, writes
+
+
+def on_time(writes, start, end):
+    """Cycles each LED is lit in [start, end)."""
+    pio = [0, 0]
+    lit = [0] * LEDS
+    now = start
+    for cycle, which, v in writes + [(end, None, None)]:
+        if cycle > now:
+            span = min(cycle, end) - now
+            strip = pio[0] | pio[1] << GREEN
+            for i in range(LEDS):
+                if strip >> i & 1:
+                    lit[i] += span
+            now = min(cycle, end)
+        if cycle >= end:
+            break
+        if which is not None:
+            pio[which] = v
+    return lit
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("binary", help="host build of board_diag")
+    ap.add_argument("--bits", default="1,2,3,4,5,6,7,8")
+    ap.add_argument("--seconds", type=int, default=3)
+    ap.add_argument("--cpu-hz", type=int, default=50000000)
+    ap.add_argument("--tolerance", type=float, default=0.005,
+                    help="largest duty error allowed, as a fraction")
+    ap.add_argument("-v", "--verbose", action="store_true",
+                    help="print every LED's duty cycle")
+    args = ap.parse_args()
+
+    per_us = args.cpu_hz // 1000000
+    failed = 0
+    print("%4s %10s %7s %10s %10s  %s" %
+          ("bits", "refresh", "periods", "max_err", "quant_err", "result"))
+    with tempfile.TemporaryDirectory() as tmp:
+        log = os.path.join(tmp, "pio.log")
+        for bits in (int(b) for b in args.bits.split(",")):
+            bench, writes = run(args.binary, bits, args.seconds, log)
+            steps = (1 << bench["bits"]) - 1
+            # Slot changes land a few cycles after the tick; start at the
+            # first one so every slot is measured whole.
+            t0 = bench["t0_us"] * per_us
+            start = next((c for c, _, _ in writes if c >= t0), t0)
+            span = bench["periods"] * bench["period_us"] * per_us
+            problems = []
+            if bench["periods"] == 0:
+                problems.append("no whole periods")
+                span = 1
+            lit = on_time(writes, start, start + span)
+            worst = quant = 0.0
+            for i in range(LEDS):
+                b = ramp(i)
+                want = level(b, bench["bits"]) / steps
+                got = lit[i] / span
+                err = got - want
+                worst = max(worst, abs(err))
+                quant = max(quant, abs(want - b / 255))
+                if abs(err) > args.tolerance and len(problems) < 3:
+                    problems.append("led %d duty %.4f, expected %.4f" % (i, got, want))
+                if args.verbose:
+                    print("     led %2d b=%3d level=%3d duty=%.4f want=%.4f "
+                          "b/255=%.4f" % (i, b, level(b, bench["bits"]), got,
+                                          want, b / 255))
+            failed += bool(problems)
+            print("%4d %10s %7d %10.5f %10.5f  %s" %
+                  (bench["bits"], bench["refresh"], bench["periods"], worst,
+                   quant, "; ".join(problems) or "ok"))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Measure which memory test algorithms catch which injected faults.
+
+Runs Main Menu > On-Chip Memory Test on the host build once per fault, with
+the fault injected through BOARD_DIAG_MEM_FAULTS, and prints for each fault
+class how many of the faults each algorithm detected:
+
+    tools/memtest_faults.py ./board_diag_host --per-class 20
+
+Fault classes (see host/host_hal.c):
+    sa0, sa1   a single bit stuck at 0 or 1
+    ad         an address line stuck at 0
+    cf-inter   inversion coupling between bits of two nearby words
+    cf-intra   inversion coupling between two bits of the same word
+"""
+
+import argparse
+import os
+import random
+import re
+import subprocess
+import sys
+
+MENU = b"j\nq\n"
+
+
+def run(binary, faults):
+    env = dict(os.environ, BOARD_DIAG_MEM_FAULTS=faults)
+    out = subprocess.run([binary], input=MENU, env=env, stdout=subprocess.PIPE,
+                         stderr=subprocess.DEVNULL,
+                         check=False).stdout.decode(errors="replace")
+    region = re.search(r"^Testing 0x([0-9a-f]+)-0x([0-9a-f]+)", out, re.M)
+    results = {}
+    for m in re.finditer(r"^BENCH memtest algo=(\S+) .*errors=(\d+)", out, re.M):
+        results[m.group(1)] = int(m.group(2))
+    if region is None or not results:
+        sys.exit("memtest_faults: no memory test results from %s" % binary)
+    return (int(region.group(1), 16), int(region.group(2), 16) + 1), results
+
+
+def make_fault(cls, rng, lo, hi):
+    word = lambda: lo + 4 * rng.randrange((hi - lo) // 4)
+    if cls in ("sa0", "sa1"):
+        return "%s:0x%x:%d" % (cls, word(), rng.randrange(32))
+    if cls == "ad":
+        # Only lines whose alias still lands inside the tested span.
+        top = (hi - lo).bit_length() - 1
+        return "ad:%d" % rng.randrange(2, top)
+    if cls == "cf-inter":
+        a = word()
+        b = min(max(a + 4 * rng.randint(-8, 8), lo), hi - 4)
+        if b == a:
+            b = a + 4 if a + 4 < hi else a - 4
+        return "cf:0x%x:%d:0x%x:%d" % (a, rng.randrange(32), b, rng.randrange(32))
+    if cls == "cf-intra":
+        a = word()
+        x, y = rng.sample(range(32), 2)
+        return "cf:0x%x:%d:0x%x:%d" % (a, x, a, y)
+    raise ValueError(cls)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("binary", help="host build of board_diag")
+    ap.add_argument("--per-class", type=int, default=10)
+    ap.add_argument("--classes", default="sa0,sa1,ad,cf-inter,cf-intra")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    rng = random.Random(args.seed)
+    (lo, hi), clean = run(args.binary, "")
+    if any(clean.values()):
+        sys.exit("memtest_faults: errors without any fault injected: %s" % clean)
+    algos = list(clean)
+
+    print("region 0x%x-0x%x, %d faults per class" % (lo, hi - 1, args.per_class))
+    print("%-10s" % "class" + "".join("%11s" % a for a in algos))
+    for cls in args.classes.split(","):
+        caught = dict.fromkeys(algos, 0)
+        for _ in range(args.per_class):
+            _, res = run(args.binary, make_fault(cls, rng, lo, hi))
+            for a in algos:
+                caught[a] += res.get(a, 0) > 0
+        print("%-10s" % cls + "".join("%10d%%" % (100 * caught[a] // args.per_class)
+                                      for a in algos))
+
+
+if __name__ == "__main__":
+    main()
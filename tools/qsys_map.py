@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""Generate qsys_map.h, the compile-time peripheral map, from the .qsys.
+
+Reads de2i_150_qsys.qsys (plain XML; no Quartus needed) and writes a C
+header with every slave the CPU's data master can reach: its base address
+and span from the address map, its IRQ from the interrupt connections and,
+for a PIO, its width, the mask of its bits and its direction.  The header
+also checks, with #error, that the system.h it is compiled against (the
+BSP's, or host/system.h) agrees with the .qsys, so firmware built against
+a BSP generated from a different system fails to build.
+
+    # regenerate after changing the system in Platform Designer
+    tools/qsys_map.py > qsys_map.h
+
+    # fail if qsys_map.h or host/system.h has fallen behind the .qsys
+    tools/qsys_map.py --check
+
+The --check also lists the peripherals the firmware names (FOO_BASE in the
+sources) that the .qsys no longer has.
+"""
+
+import argparse
+import glob
+import os
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+QSYS = os.path.join(REPO, "de2i_150_qsys.qsys")
+HEADER = os.path.join(REPO, "qsys_map.h")
+HOST_SYSTEM_H = os.path.join(REPO, "host", "system.h")
+
+PERIOD_US = {"USEC": 1, "MSEC": 1000, "SEC": 1000000, "CLOCKS": None}
+
+
+class Slave:
+    def __init__(self, name, kind, params):
+        self.name = name
+        self.kind = kind
+        self.params = params
+        self.base = None
+        self.span = None
+        self.irq = -1
+
+    @property
+    def macro(self):
+        return "QSYS_" + self.name.upper()
+
+
+def load(path):
+    root = ET.parse(path).getroot()
+    modules = {}
+    for m in root.iter("module"):
+        params = {p.get("name"): p.get("value", p.text)
+                  for p in m.findall("parameter")}
+        modules[m.get("name")] = Slave(m.get("name"), m.get("kind"), params)
+
+    cpu = next(s for s in modules.values() if s.kind.startswith("altera_nios2"))
+    spans = {}
+    for s in re.finditer(r"<slave name='([\w.]+)' start='(\w+)' end='(\w+)'",
+                         cpu.params.get("dataSlaveMapParam", "")):
+        spans[s.group(1)] = (int(s.group(2), 16), int(s.group(3), 16))
+
+    slaves = []
+    for c in root.iter("connection"):
+        params = {p.get("name"): p.get("value") for p in c.findall("parameter")}
+        start, end = c.get("start"), c.get("end")
+        name = end.split(".")[0]
+        if c.get("kind") == "avalon" and start == cpu.name + ".data_master":
+            s = modules[name]
+            if s is cpu:
+                continue        # the debug slave
+            s.base = int(params["baseAddress"], 16)
+            if end not in spans or spans[end][0] != s.base:
+                sys.exit("qsys_map: %s is at 0x%x in the connection but not "
+                         "in %s's address map; regenerate the system" %
+                         (end, s.base, cpu.name))
+            s.span = spans[end][1] - spans[end][0]
+            slaves.append(s)
+        elif c.get("kind") == "interrupt" and start == cpu.name + ".irq":
+            modules[name].irq = int(params["irqNumber"])
+    clocks = [s for s in modules.values() if s.kind == "clock_source"]
+    return cpu, clocks[0], sorted(slaves, key=lambda s: s.name)
+
+
+def flag(s, name):
+    return s.params.get(name) == "true"
+
+
+def pio_lines(s):
+    width = int(s.params["width"])
+    direction = s.params["direction"]
+    has_in = int(direction in ("Input", "InOut", "Bidir"))
+    has_out = int(direction in ("Output", "InOut", "Bidir"))
+    p = s.macro
+    out = [
+        ("_WIDTH", "%d" % width),
+        ("_MASK", "0x%08xu" % ((1 << width) - 1)),
+        ("_HAS_IN", "%d" % has_in),
+        ("_HAS_OUT", "%d" % has_out),
+        ("_CAPTURE", "%d" % flag(s, "captureEdge")),
+    ]
+    lines = ["#define %-32s %s" % (p + n, v) for n, v in out]
+    if has_in:
+        lines.append("#define %-32s (IORD_ALTERA_AVALON_PIO_DATA(%s_BASE) & %s_MASK)"
+                     % (p + "_READ()", p, p))
+    if has_out:
+        lines.append("#define %-32s IOWR_ALTERA_AVALON_PIO_DATA(%s_BASE, (v) & %s_MASK)"
+                     % (p + "_WRITE(v)", p, p))
+    checks = [("_DATA_WIDTH", "_WIDTH", "width"),
+              ("_HAS_IN", "_HAS_IN", "direction"),
+              ("_HAS_OUT", "_HAS_OUT", "direction")]
+    return lines, checks
+
+
+def timer_lines(s):
+    p = s.macro
+    lines = ["#define %-32s %s" % (p + "_FREQ", s.params["systemFrequency"])]
+    checks = [("_FREQ", "_FREQ", "clock")]
+    us = PERIOD_US.get(s.params.get("periodUnits"))
+    if us is not None:
+        period_us = int(s.params["period"]) * us
+        lines.append("#define %-32s %d" % (p + "_PERIOD_US", period_us))
+        if 1000000 % period_us == 0:
+            lines.append("#define %-32s %d" % (p + "_TICKS_PER_SEC",
+                                               1000000 // period_us))
+            checks.append(("_TICKS_PER_SEC", "_TICKS_PER_SEC", "period"))
+    lines.append("#define %-32s %d" % (p + "_SNAPSHOT", flag(s, "snapshot")))
+    lines.append("#define %-32s %s" % (p + "_COUNTER_SIZE", s.params["counterSize"]))
+    checks.append(("_SNAPSHOT", "_SNAPSHOT", "snapshot"))
+    return lines, checks
+
+
+def memory_lines(s):
+    p = s.macro
+    lines = ["#define %-32s %s" % (p + "_SIZE", s.params["memorySize"]),
+             "#define %-32s %s" % (p + "_DATA_WIDTH", s.params["dataWidth"])]
+    return lines, [("_SIZE_VALUE", "_SIZE", "size")]
+
+
+def generate(path):
+    cpu, clk, slaves = load(path)
+    cpu_hz = int(clk.params["clockFrequency"])
+    src = os.path.basename(path)
+    out = []
+    w = out.append
+    w("/******************************************************************************")
+    w(" *")
+    w(" * qsys_map.h")
+    w(" *")
+    w(" * Generated by tools/qsys_map.py from %s; do not edit." % src)
+    w(" *")
+    w(" * The peripherals the CPU's data master reaches, as the .qsys declares them,")
+    w(" * and checks that the system.h this build uses agrees.  Every value is a")
+    w(" * constant, so QSYS_RED_LED_WRITE(v) and the like compile to a store to a")
+    w(" * fixed address with the PIO's width mask folded in.  They are macros over")
+    w(" * IORD/IOWR so that bus_prof.h and io_trace.h still see the accesses.")
+    w(" *")
+    w(" ******************************************************************************/")
+    w("")
+    w("#ifndef __QSYS_MAP_H__")
+    w("#define __QSYS_MAP_H__")
+    w("")
+    w("#define %-32s %d" % ("QSYS_CPU_FREQ", cpu_hz))
+    w("#define %-32s %d" % ("QSYS_NUM_SLAVES", len(slaves)))
+
+    all_checks = []
+    for s in slaves:
+        w("")
+        w("/* %s: %s */" % (s.name, s.kind))
+        w("#define %-32s 0x%08xu" % (s.macro + "_BASE", s.base))
+        w("#define %-32s %d" % (s.macro + "_SPAN", s.span))
+        w("#define %-32s %s" % (s.macro + "_IRQ", "%d" % s.irq if s.irq >= 0 else "(-1)"))
+        checks = [("_BASE", "_BASE", "base address"), ("_SPAN", "_SPAN", "span")]
+        extra, more = [], []
+        if s.kind == "altera_avalon_pio":
+            extra, more = pio_lines(s)
+        elif s.kind == "altera_avalon_timer":
+            extra, more = timer_lines(s)
+        elif s.kind == "altera_avalon_onchip_memory2":
+            extra, more = memory_lines(s)
+        out.extend(extra)
+        all_checks.append((s, checks + more))
+
+    w("")
+    w("/*")
+    w(" * system.h against the .qsys.  A peripheral system.h leaves out is not")
+    w(" * checked; the firmware compiles the code for it out.  The host build's")
+    w(" * system.h gives button_pio an edge capture interrupt the .qsys does not")
+    w(" * have (see host/system.h), so IRQs are only checked on the board.")
+    w(" */")
+    w("")
+    w("#if defined(ALT_CPU_FREQ) && ALT_CPU_FREQ != QSYS_CPU_FREQ")
+    w("#error \"cpu: ALT_CPU_FREQ in system.h differs from %s; regenerate the BSP\"" % src)
+    w("#endif")
+    for s, checks in all_checks:
+        name = s.name.upper()
+        w("")
+        w("#ifdef %s_BASE" % name)
+        for sys_suffix, our_suffix, what in checks:
+            w("#if %s%s != %s%s" % (name, sys_suffix, s.macro, our_suffix))
+            w("#error \"%s: %s in system.h differs from %s; regenerate the BSP\""
+              % (s.name, what, src))
+            w("#endif")
+        w("#ifndef BOARD_DIAG_HOST")
+        w("#if %s_IRQ != %s_IRQ" % (name, s.macro))
+        w("#error \"%s: IRQ in system.h differs from %s; regenerate the BSP\""
+          % (s.name, src))
+        w("#endif")
+        w("#endif")
+        w("#endif")
+    w("")
+    w("#endif /* __QSYS_MAP_H__ */")
+    return "\n".join(out) + "\n", slaves, cpu_hz
+
+
+def firmware_peripherals():
+    """Peripheral names the firmware refers to as FOO_BASE."""
+    used, local = set(), set()
+    for path in glob.glob(os.path.join(REPO, "*.[ch]")):
+        if os.path.basename(path) == "qsys_map.h":
+            continue
+        with open(path) as f:
+            text = f.read()
+        used.update(re.findall(r"\b([A-Z][A-Z0-9_]*)_BASE\b", text))
+        local.update(re.findall(r"#define\s+([A-Z][A-Z0-9_]*)_BASE\b", text))
+    return used - local
+
+
+def host_defines():
+    defs = {}
+    with open(HOST_SYSTEM_H) as f:
+        for m in re.finditer(r"^#define (\w+) (.+)$", f.read(), re.M):
+            defs[m.group(1)] = m.group(2).strip()
+    return defs
+
+
+def check(text, slaves, cpu_hz):
+    problems = []
+    try:
+        with open(HEADER) as f:
+            if f.read() != text:
+                problems.append("qsys_map.h is out of date; run tools/qsys_map.py > qsys_map.h")
+    except FileNotFoundError:
+        problems.append("qsys_map.h is missing; run tools/qsys_map.py > qsys_map.h")
+
+    names = {s.name.upper() for s in slaves}
+    for p in sorted(firmware_peripherals() - names):
+        problems.append("the firmware uses %s_BASE, which the .qsys does not have" % p)
+
+    defs = host_defines()
+    value = lambda k: int(defs[k], 0) if k in defs else None
+    for s in slaves:
+        n = s.name.upper()
+        if n + "_BASE" not in defs:
+            continue
+        want = [("_BASE", s.base), ("_SPAN", s.span)]
+        if s.kind == "altera_avalon_pio":
+            want.append(("_DATA_WIDTH", int(s.params["width"])))
+        for suffix, v in want:
+            if value(n + suffix) != v:
+                problems.append("host/system.h: %s%s is %s, the .qsys has %s"
+                                % (n, suffix, defs.get(n + suffix), hex(v)
+                                   if suffix == "_BASE" else v))
+    if value("ALT_CPU_FREQ") != cpu_hz:
+        problems.append("host/system.h: ALT_CPU_FREQ is %s, the .qsys has %d"
+                        % (defs.get("ALT_CPU_FREQ"), cpu_hz))
+    return problems
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--qsys", default=QSYS, help="system to read (default %(default)s)")
+    ap.add_argument("--check", action="store_true",
+                    help="check qsys_map.h, host/system.h and the firmware against the .qsys")
+    args = ap.parse_args()
+
+    text, slaves, cpu_hz = generate(args.qsys)
+    if not args.check:
+        sys.stdout.write(text)
+        return
+    problems = check(text, slaves, cpu_hz)
+    for p in problems:
+        print("qsys_map: " + p)
+    if not problems:
+        print("qsys_map: %d slaves; qsys_map.h, host/system.h and the firmware agree"
+              % len(slaves))
+    sys.exit(1 if problems else 0)
+
+
+if __name__ == "__main__":
+    main()
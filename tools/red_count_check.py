@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Check the red LED counter against what reached the PIO.
+
+Runs Performance Menu > Red LED Counter on the host build once per mode and
+rate, with BOARD_DIAG_PIO_LOG recording every value red_led drives, and
+checks the recording exactly:
+
+  - every value is the successor of the one before in the mode's sequence,
+  - step j lands ceil(j * ticks_per_s / rate) ticks after the start, so
+    over the whole run the count neither drifts nor jitters by more than
+    the tick,
+  - the steps recorded agree with the BENCH line, and the number of steps
+    is floor(ticks * rate / ticks_per_s) for the ticks it ran.
+
+    tools/red_count_check.py ./board_diag_host
+    tools/red_count_check.py ./board_diag_host --modes gray --rates 7,999
+
+Rates above one step per tick are run at one step per tick; the report
+shows both.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+WIDTH = 18
+ALL = 1 << WIDTH
+
+
+def value(mode, n):
+    if mode == "down":
+        return ALL - 1 - n
+    if mode == "gray":
+        return n ^ (n >> 1)
+    return n
+
+
+def run(binary, mode, hz, seconds, log):
+    menu = ("g\nk\n%s\n%d\n%d\nq\nq\n" % (mode, hz, seconds)).encode()
+    env = dict(os.environ, BOARD_DIAG_PIO_LOG=log)
+    out = subprocess.run([binary], input=menu, env=env, stdout=subprocess.PIPE,
+                         stderr=subprocess.DEVNULL,
+                         check=False).stdout.decode(errors="replace")
+    m = re.search(r"BENCH red_count mode=(\S+) requested_hz=(\d+) rate_hz=(\d+) "
+                  r"achieved_hz=(\S+) steps=(\d+) ticks=(\d+) value=0x([0-9a-f]+)",
+                  out)
+    if m is None:
+        sys.exit("red_count_check: no BENCH red_count line from %s" % binary)
+    bench = dict(rate=int(m.group(3)), achieved=m.group(4), steps=int(m.group(5)),
+                 ticks=int(m.group(6)), value=int(m.group(7), 16))
+    writes = []
+    with open(log) as f:
+        for line in f:
+            cycle, dev, v = line.split()
+            if dev == "red_led":
+                writes.append((int(cycle), int(v, 16)))
+    return bench, writes
+
+
+def check(mode, bench, writes, tick_cycles, tps):
+    """Returns a list of problems, empty when the recording is exact."""
+    rate = bench["rate"]
+    start = value(mode, 0)
+    # The start-up code clears the LEDs; the counter's first value only
+    # shows up as a write when it differs from that.
+    while writes and writes[0][1] == 0 and start != 0:
+        writes = writes[1:]
+    if writes and writes[0][1] == start:
+        writes = writes[1:]
+    while start == 0 and writes and writes[0][1] == 0:
+        writes = writes[1:]
+    problems = []
+
+    if len(writes) != bench["steps"]:
+        problems.append("%d steps recorded, BENCH says %d" %
+                        (len(writes), bench["steps"]))
+    if bench["steps"] != bench["ticks"] * rate // tps:
+        problems.append("%d steps in %d ticks at %d/s" %
+                        (bench["steps"], bench["ticks"], rate))
+    for j, (_, v) in enumerate(writes, 1):
+        if v != value(mode, j % ALL):
+            problems.append("step %d is 0x%05x, expected 0x%05x" %
+                            (j, v, value(mode, j % ALL)))
+            break
+    if writes and writes[-1][1] != bench["value"]:
+        problems.append("last value 0x%05x, BENCH says 0x%05x" %
+                        (writes[-1][1], bench["value"]))
+    if writes:
+        first = writes[0][0]
+        due = lambda j: -(-j * tps // rate)
+        for j, (cycle, _) in enumerate(writes, 1):
+            ticks = round((cycle - first) / tick_cycles)
+            if ticks != due(j) - due(1):
+                problems.append("step %d after %d ticks, due after %d" %
+                                (j, ticks, due(j) - due(1)))
+                break
+    return problems
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("binary", help="host build of board_diag")
+    ap.add_argument("--modes", default="up,down,gray")
+    ap.add_argument("--rates", default="1,5,300,999,1000,2000")
+    ap.add_argument("--seconds", type=int, default=3)
+    ap.add_argument("--cpu-hz", type=int, default=50000000)
+    ap.add_argument("--ticks-per-s", type=int, default=1000)
+    args = ap.parse_args()
+
+    tick_cycles = args.cpu_hz // args.ticks_per_s
+    failed = 0
+    print("%-5s %6s %6s %12s %7s  %s" %
+          ("mode", "asked", "rate", "achieved", "steps", "result"))
+    with tempfile.TemporaryDirectory() as tmp:
+        log = os.path.join(tmp, "pio.log")
+        for mode in args.modes.split(","):
+            for hz in (int(r) for r in args.rates.split(",")):
+                bench, writes = run(args.binary, mode, hz, args.seconds, log)
+                problems = check(mode, bench, writes, tick_cycles,
+                                 args.ticks_per_s)
+                failed += bool(problems)
+                print("%-5s %6d %6d %12s %7d  %s" %
+                      (mode, hz, bench["rate"], bench["achieved"],
+                       bench["steps"], "; ".join(problems) or "exact"))
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""Decode a peripheral write trace dump and replay it.
+
+Reads the TRACE lines that the console's `trace dump` prints (from a
+nios2-terminal log or any other capture; other lines are ignored), decodes
+the records (see io_trace.h) and replays the writes into a register file
+with the semantics of host/host_hal.c: an output PIO's data register takes
+the value within the PIO's width, and its outset and outclear registers
+(4 and 5) set and clear bits of it.
+
+    # every write, with the time since the start of the trace
+    tools/trace_replay.py dump.txt
+
+    # the LEDs and digits as they were at these times (microseconds)
+    tools/trace_replay.py dump.txt --at 250000 --at 400000
+
+    # the LEDs and digits after every write that changed them
+    tools/trace_replay.py dump.txt --states
+
+    # host build: check the replay against what the PIOs really drove
+    BOARD_DIAG_PIO_LOG=pio.log ./board_diag_host < session.txt > dump.txt
+    tools/trace_replay.py dump.txt --check-log pio.log
+
+Times are relative to the oldest record still in the ring; t0 in the dump
+header gives it in CPU cycles since start-up.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+ESCAPE = 15
+OUTPUT_PIOS = ("led_pio", "red_led", "seven_seg_pio", "seven_seg_pio_1")
+REG_NAMES = {0: "data", 1: "direction", 2: "irq_mask", 3: "edge_cap",
+             4: "outset", 5: "outclear"}
+
+
+class Dump:
+    def __init__(self):
+        self.cpu_hz = 50000000
+        self.t0 = 0
+        self.t1 = 0
+        self.records = 0
+        self.dropped = 0
+        self.slaves = {}        # number -> (name, base, width)
+        self.data = bytearray()
+
+
+def parse(lines):
+    dump = None
+    for line in lines:
+        m = re.search(r"TRACE (\w+) ?(.*)", line)
+        if m is None:
+            continue
+        kind, rest = m.group(1), m.group(2).split()
+        if kind == "begin":
+            dump = Dump()
+            fields = dict(f.split("=", 1) for f in rest)
+            dump.cpu_hz = int(fields["cpu_hz"])
+            dump.t0 = int(fields["t0"])
+            dump.t1 = int(fields["t1"])
+            dump.records = int(fields["records"])
+            dump.dropped = int(fields["dropped"])
+        elif dump is None:
+            continue
+        elif kind == "slave":
+            dump.slaves[int(rest[0])] = (rest[1], int(rest[2], 16), int(rest[3]))
+        elif kind == "data":
+            dump.data += bytes.fromhex(rest[0])
+        elif kind == "end":
+            return dump
+    sys.exit("trace_replay: no complete TRACE dump in the input")
+
+
+def leb(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7f) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def decode(dump):
+    """Returns (cycle, name, base, width, reg, value) for every record."""
+    data, pos, t, out = dump.data, 0, dump.t0, []
+    while pos < len(data):
+        head = data[pos]
+        pos += 1
+        slave, reg = head & 0x0f, (head >> 4) & 7
+        if slave == ESCAPE:
+            base = int.from_bytes(data[pos:pos + 4], "little")
+            pos += 4
+            name, width = "0x%x" % base, 32
+        else:
+            name, base, width = dump.slaves[slave]
+        delta, pos = leb(data, pos)
+        value, pos = leb(data, pos)
+        t += delta
+        out.append((t, name, base, width, reg, value))
+    if len(out) != dump.records:
+        sys.exit("trace_replay: decoded %d records, the header says %d" %
+                 (len(out), dump.records))
+    return out
+
+
+def seg_font():
+    """Glyph (active high, bit 0 = a) -> character, from seg_text.c."""
+    bits = {s: 1 << i for i, s in enumerate("ABCDEFG")}
+    bits["ALL"] = 0x7f
+    font = {0: " "}
+    with open(os.path.join(REPO, "seg_text.c")) as f:
+        for m in re.finditer(r"\['(.)'\] = ([A-Z_ |]+),", f.read()):
+            glyph = 0
+            for seg in re.findall(r"SEG_(\w+)", m.group(2)):
+                glyph |= bits[seg]
+            font.setdefault(glyph, m.group(1))
+    return font
+
+
+class Replay:
+    """The output PIO registers, as host/host_hal.c keeps them."""
+
+    def __init__(self, font):
+        self.font = font
+        self.regs = {name: 0 for name in OUTPUT_PIOS}
+
+    def write(self, name, width, reg, value):
+        if name not in self.regs:
+            return False
+        mask = (1 << width) - 1
+        old = self.regs[name]
+        if reg == 0:
+            self.regs[name] = value & mask
+        elif reg == 4:
+            self.regs[name] |= value & mask
+        elif reg == 5:
+            self.regs[name] &= ~value
+        return self.regs[name] != old
+
+    def digits(self, word):
+        return "".join(self.font.get(~(word >> (7 * i)) & 0x7f, "?")
+                       for i in (3, 2, 1, 0))
+
+    def state(self):
+        lit = lambda v, n: "".join("*" if v >> b & 1 else "." for b in reversed(range(n)))
+        return "red %s  green %s  seg [%s%s]" % (
+            lit(self.regs["red_led"], 18), lit(self.regs["led_pio"], 8),
+            self.digits(self.regs["seven_seg_pio"]),
+            self.digits(self.regs["seven_seg_pio_1"]))
+
+
+def check_log(dump, records, path):
+    """Compare the replayed output PIO values with a BOARD_DIAG_PIO_LOG.
+
+    A record is stamped just before its write is made, so each logged write
+    must come at or up to a microsecond after its record.  The log is
+    compared from the first record to the start of the dump.
+    """
+    tol = dump.cpu_hz // 1000000
+    start = records[0][0] if records else dump.t1
+    want = []
+    with open(path) as f:
+        for line in f:
+            cycle, name, value = line.split()
+            if start <= int(cycle) < dump.t1 and name in OUTPUT_PIOS:
+                want.append((int(cycle), name, int(value, 16)))
+    replay = Replay({})
+    got = []
+    for t, name, base, width, reg, value in records:
+        if name in OUTPUT_PIOS and reg in (0, 4, 5):
+            replay.write(name, width, reg, value)
+            got.append((t, name, replay.regs[name]))
+    if len(got) != len(want):
+        return "%d output writes traced, %d in the log" % (len(got), len(want))
+    for i, (g, w) in enumerate(zip(got, want)):
+        if g[1:] != w[1:] or not 0 <= w[0] - g[0] <= tol:
+            return "write %d: traced %s 0x%x at %d, log %s 0x%x at %d" % (
+                i, g[1], g[2], g[0], w[1], w[2], w[0])
+    return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("dump", nargs="?", help="file holding the dump (default stdin)")
+    ap.add_argument("--at", type=int, action="append", default=[],
+                    help="show the state this many microseconds into the trace")
+    ap.add_argument("--states", action="store_true",
+                    help="show the state after every write that changed it")
+    ap.add_argument("--check-log", metavar="FILE",
+                    help="compare with a host BOARD_DIAG_PIO_LOG file")
+    args = ap.parse_args()
+
+    with (open(args.dump) if args.dump else sys.stdin) as f:
+        dump = parse(f)
+    records = decode(dump)
+    per_us = dump.cpu_hz / 1e6
+    print("%d records, %d dropped before them, t0 %d cycles" %
+          (len(records), dump.dropped, dump.t0))
+
+    if args.check_log:
+        problem = check_log(dump, records, args.check_log)
+        print("check against %s: %s" % (args.check_log, problem or "exact"))
+        sys.exit(1 if problem else 0)
+
+    replay = Replay(seg_font())
+    at = sorted(args.at)
+    for t, name, base, width, reg, value in records:
+        us = (t - dump.t0) / per_us
+        while at and at[0] < us:
+            print("%12.0f us  %s" % (at.pop(0), replay.state()))
+        changed = replay.write(name, width, reg, value)
+        if args.states:
+            if changed:
+                print("%12.1f us  %s" % (us, replay.state()))
+        elif not args.at:
+            print("%12.1f us  %-16s %-9s 0x%x" %
+                  (us, name, REG_NAMES.get(reg, reg), value))
+    for t in at:
+        print("%12.0f us  %s" % (t, replay.state()))
+
+
+if __name__ == "__main__":
+    main()
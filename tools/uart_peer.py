@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Host end of the board_diag JTAG UART benchmarks.
+
+Answers the @bench protocol described in uart_bench.h and passes every other
+byte from the board through to stdout, so BENCH result lines can be piped
+into a log or a regression check.
+
+    # host build: board_diag_host with BOARD_DIAG_UART_PTY=/tmp/bd_uart
+    tools/uart_peer.py /tmp/bd_uart
+
+    # hardware: run nios2-terminal underneath; local input goes to the board
+    tools/uart_peer.py --exec nios2-terminal
+"""
+
+import argparse
+import os
+import select
+import subprocess
+import sys
+import termios
+import time
+import tty
+
+PREFIX = b"@bench "
+
+
+class Peer:
+    def __init__(self, rfd, wfd, out):
+        self.rfd = rfd
+        self.wfd = wfd
+        self.out = out
+        self.line = b""
+        self.mode = None
+        self.count = 0
+
+    def send(self, data):
+        while data:
+            n = os.write(self.wfd, data)
+            data = data[n:]
+
+    def command(self, line):
+        try:
+            what, count = line[len(PREFIX):].split()
+            count = int(count)
+        except ValueError:
+            sys.stderr.write("uart_peer: bad command %r\n" % line)
+            return
+        if what == b"tx":
+            self.mode, self.count = "tx", count
+            if count == 0:
+                self.finish_tx()
+        elif what == b"rx":
+            pattern = bytes(ord("a") + i % 26 for i in range(count))
+            self.send(pattern)
+        elif what == b"echo":
+            self.mode, self.count = ("echo", count) if count else (None, 0)
+        else:
+            sys.stderr.write("uart_peer: unknown test %r\n" % what)
+
+    def finish_tx(self):
+        self.mode = None
+        self.send(b"!")
+
+    def text(self, data):
+        self.out.write(data)
+        self.out.flush()
+
+    def feed(self, data):
+        while data:
+            if self.mode == "tx":
+                n = min(self.count, len(data))
+                data = data[n:]
+                self.count -= n
+                if self.count == 0:
+                    self.finish_tx()
+            elif self.mode == "echo":
+                self.send(data[:1])
+                data = data[1:]
+                self.count -= 1
+                if self.count == 0:
+                    self.mode = None
+            else:
+                data = self.feed_text(data)
+
+    def feed_text(self, data):
+        """Pass text through until a complete @bench line; return the rest."""
+        nl = data.find(b"\n")
+        chunk, rest = (data, b"") if nl < 0 else (data[:nl + 1], data[nl + 1:])
+        self.line += chunk
+        if not self.line.startswith(PREFIX[:len(self.line)]):
+            # Not a command: show it now so prompts appear without a newline.
+            self.text(self.line)
+            self.line = b""
+        elif nl >= 0:
+            line, self.line = self.line.rstrip(b"\r\n"), b""
+            self.command(line)
+        return rest
+
+
+def open_pty(path, wait):
+    deadline = time.monotonic() + wait
+    while not os.path.exists(path):
+        if time.monotonic() > deadline:
+            sys.exit("uart_peer: %s did not appear" % path)
+        time.sleep(0.1)
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd, termios.TCSANOW)
+    return fd
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("device", nargs="?", help="pseudo-terminal of the host build")
+    ap.add_argument("--exec", dest="command", metavar="CMD",
+                    help="run CMD (e.g. nios2-terminal) as the link instead")
+    ap.add_argument("--wait", type=float, default=10.0,
+                    help="seconds to wait for DEVICE to appear (default 10)")
+    args = ap.parse_args()
+    if bool(args.device) == bool(args.command):
+        ap.error("give either a device or --exec")
+
+    out = sys.stdout.buffer
+    child = None
+    fds = []
+    if args.command:
+        child = subprocess.Popen(args.command, shell=True, stdin=subprocess.PIPE,
+                                 stdout=subprocess.PIPE, bufsize=0)
+        peer = Peer(child.stdout.fileno(), child.stdin.fileno(), out)
+        fds.append(sys.stdin.fileno())
+    else:
+        fd = open_pty(args.device, args.wait)
+        peer = Peer(fd, fd, out)
+    fds.append(peer.rfd)
+
+    try:
+        while True:
+            ready, _, _ = select.select(fds, [], [])
+            if peer.rfd in ready:
+                try:
+                    data = os.read(peer.rfd, 4096)
+                except OSError:
+                    data = b""
+                if not data:
+                    break
+                peer.feed(data)
+            if sys.stdin.fileno() in ready:
+                data = os.read(sys.stdin.fileno(), 4096)
+                if not data:
+                    fds.remove(sys.stdin.fileno())
+                    child.stdin.close()
+                else:
+                    peer.send(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if child:
+            child.terminate()
+            child.wait()
+
+
+if __name__ == "__main__":
+    main()
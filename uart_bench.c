@@ -0,0 +1,246 @@
+/******************************************************************************
+ *
+ * uart_bench.c
+ *
+ * JTAG UART bandwidth and echo latency benchmarks.  See uart_bench.h.
+ *
+ * Output goes through uart_tx; input is read from a second, non-blocking
+ * descriptor on the same device.  stdout shares the JTAG UART, so the ring
+ * is always empty before a result line is printed.
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "alt_types.h"
+
+#include "timer_service.h"
+#include "uart_tx.h"
+#include "cpu_load.h"
+#include "uart_bench.h"
+
+static int bench_fd = -1;
+static char bench_buf[UART_BENCH_MAX_BLOCK];
+static alt_u32 bench_lat[UART_BENCH_MAX_SAMPLES];
+
+static int bench_open( void )
+{
+#ifdef JTAG_UART_NAME
+  if (bench_fd < 0)
+  {
+    bench_fd = open(JTAG_UART_NAME, O_RDONLY | O_NONBLOCK);
+  }
+#endif
+  return bench_fd < 0 ? -1 : 0;
+}
+
+static alt_u64 bench_deadline( void )
+{
+  return timer_now_us() + UART_BENCH_TIMEOUT_US;
+}
+
+static alt_u32 bench_us( alt_u64 from_cycles, alt_u64 to_cycles )
+{
+  return (alt_u32)((to_cycles - from_cycles) / timer_cycles_per_us());
+}
+
+/* Throw away whatever input is already waiting. */
+
+static void bench_drain_input( void )
+{
+  while (read(bench_fd, bench_buf, sizeof(bench_buf)) > 0)
+  {
+  }
+}
+
+/* Queue 'len' bytes and wait until all of them are with the driver. */
+
+static int bench_send( const char* buf, int len, alt_u64 deadline )
+{
+  int n;
+
+  while (len > 0)
+  {
+    n = uart_tx_try_write(buf, len);
+    buf += n;
+    len -= n;
+    if (timer_now_us() > deadline)
+    {
+      return -1;
+    }
+  }
+  while (uart_tx_pending() > 0)
+  {
+    uart_tx_poll();
+    if (timer_now_us() > deadline)
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int bench_command( const char* what, int count, alt_u64 deadline )
+{
+  char line[32];
+  int len;
+
+  len = snprintf(line, sizeof(line), "@bench %s %d\n", what, count);
+  return bench_send(line, len, deadline);
+}
+
+/* Read up to 'len' bytes; -1 once the deadline has passed with nothing. */
+
+static int bench_read( char* buf, int len, alt_u64 deadline )
+{
+  int n;
+
+  while ((n = read(bench_fd, buf, len)) <= 0)
+  {
+    if (timer_now_us() > deadline)
+    {
+      return -1;
+    }
+  }
+  return n;
+}
+
+static void bench_result( const char* test, int block, alt_u32 bytes,
+                          alt_u32 us, int ok )
+{
+  printf("BENCH %s block=%d bytes=%lu us=%lu bytes_per_s=%lu status=%s\n",
+    test, block, (unsigned long) bytes, (unsigned long) us,
+    (unsigned long)(us ? (alt_u64) bytes * 1000000 / us : 0),
+    ok ? "ok" : "timeout");
+}
+
+int uart_bench_tx( int block, int total )
+{
+  alt_u64 deadline = bench_deadline();
+  alt_u64 start;
+  alt_u32 sent = 0;
+  int i, n, ok, prev;
+  char ack;
+
+  if (bench_open() < 0 || block <= 0 || block > UART_BENCH_MAX_BLOCK)
+  {
+    return -1;
+  }
+  for (i = 0; i < block; i++)
+  {
+    bench_buf[i] = 'A' + i % 26;
+  }
+
+  fflush(stdout);
+  prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+  bench_drain_input();
+  ok = bench_command("tx", total, deadline) == 0;
+  start = timer_now_cycles();
+  while (ok && sent < (alt_u32) total)
+  {
+    n = total - sent < (alt_u32) block ? (int)(total - sent) : block;
+    ok = bench_send(bench_buf, n, deadline) == 0;
+    sent += n;
+  }
+
+  /* The peer acknowledges once the last byte has crossed the link. */
+  ok = ok && bench_read(&ack, 1, deadline) == 1 && ack == '!';
+  cpu_load_leave(prev);
+  bench_result("uart_tx", block, sent, bench_us(start, timer_now_cycles()), ok);
+  return ok ? 0 : -1;
+}
+
+int uart_bench_rx( int block, int total )
+{
+  alt_u64 deadline = bench_deadline();
+  alt_u64 start = 0;
+  alt_u32 got = 0;
+  int n, ok, prev;
+
+  if (bench_open() < 0 || block <= 0 || block > UART_BENCH_MAX_BLOCK)
+  {
+    return -1;
+  }
+
+  fflush(stdout);
+  prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+  bench_drain_input();
+  ok = bench_command("rx", total, deadline) == 0;
+  while (ok && got < (alt_u32) total)
+  {
+    n = bench_read(bench_buf, block, deadline);
+    if (n < 0)
+    {
+      ok = 0;
+      break;
+    }
+    if (got == 0)
+    {
+      /* Time from the first byte, so the command's trip is not counted. */
+      start = timer_now_cycles();
+    }
+    got += n;
+  }
+  cpu_load_leave(prev);
+  bench_result("uart_rx", block, got,
+    got ? bench_us(start, timer_now_cycles()) : 0, ok);
+  return ok ? 0 : -1;
+}
+
+int uart_bench_echo( int samples )
+{
+  alt_u64 deadline = bench_deadline();
+  alt_u64 t0;
+  alt_u32 v;
+  int done = 0;
+  int i, j, ok, prev;
+  char c;
+
+  if (bench_open() < 0 || samples <= 0 || samples > UART_BENCH_MAX_SAMPLES)
+  {
+    return -1;
+  }
+
+  fflush(stdout);
+  prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+  bench_drain_input();
+  ok = bench_command("echo", samples, deadline) == 0;
+  for (i = 0; ok && i < samples; i++)
+  {
+    c = 'a' + i % 26;
+    t0 = timer_now_cycles();
+    ok = bench_send(&c, 1, deadline) == 0 && bench_read(&c, 1, deadline) == 1;
+    if (ok)
+    {
+      /* Insertion sort as we go; the sample count is small. */
+      v = bench_us(t0, timer_now_cycles());
+      for (j = done; j > 0 && bench_lat[j - 1] > v; j--)
+      {
+        bench_lat[j] = bench_lat[j - 1];
+      }
+      bench_lat[j] = v;
+      done++;
+    }
+  }
+  cpu_load_leave(prev);
+
+  if (done == 0)
+  {
+    printf("BENCH uart_echo samples=0 status=timeout\n");
+    return -1;
+  }
+  printf("BENCH uart_echo samples=%d min_us=%lu p50_us=%lu p90_us=%lu "
+    "p99_us=%lu max_us=%lu status=%s\n", done,
+    (unsigned long) bench_lat[0],
+    (unsigned long) bench_lat[done * 50 / 100],
+    (unsigned long) bench_lat[done * 90 / 100],
+    (unsigned long) bench_lat[done * 99 / 100],
+    (unsigned long) bench_lat[done - 1],
+    ok ? "ok" : "timeout");
+  return ok ? 0 : -1;
+}
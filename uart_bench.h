@@ -0,0 +1,44 @@
+/******************************************************************************
+ *
+ * uart_bench.h
+ *
+ * JTAG UART bandwidth and echo latency benchmarks.
+ *
+ * The benchmarks need a peer on the host side of the link that understands
+ * a small line protocol, sent on the UART ahead of each test:
+ *
+ *   @bench tx <bytes>     <bytes> of data follow; reply '!' once all arrived
+ *   @bench rx <bytes>     send <bytes> of data back
+ *   @bench echo <count>   echo the next <count> bytes back one at a time
+ *
+ * tools/uart_peer.py implements it, either around nios2-terminal or on the
+ * pseudo-terminal of the host build (BOARD_DIAG_UART_PTY).  Results are
+ * printed as one machine-readable line per test:
+ *
+ *   BENCH <test> key=value ...
+ *
+ * Times come from the timer service (sys_clk_timer).  A test that does not
+ * complete within UART_BENCH_TIMEOUT_US reports status=timeout.
+ *
+ ******************************************************************************/
+
+#ifndef __UART_BENCH_H__
+#define __UART_BENCH_H__
+
+#include "alt_types.h"
+
+#define UART_BENCH_MAX_BLOCK   1024
+#define UART_BENCH_MAX_SAMPLES 256
+#define UART_BENCH_TIMEOUT_US  10000000
+#define UART_BENCH_TOTAL       16384   /* bytes per bandwidth test in the menu */
+
+/* Sustained TX: 'total' bytes written 'block' bytes at a time. */
+int uart_bench_tx( int block, int total );
+
+/* Sustained RX: 'total' bytes from the peer, read 'block' bytes at a time. */
+int uart_bench_rx( int block, int total );
+
+/* Round-trip latency of 'samples' single-byte echoes, with percentiles. */
+int uart_bench_echo( int samples );
+
+#endif /* __UART_BENCH_H__ */
@@ -0,0 +1,164 @@
+/******************************************************************************
+ *
+ * uart_tx.c
+ *
+ * Buffered, non-blocking output to the JTAG UART.  See uart_tx.h.
+ *
+ * Everything here runs in the main loop (the idle hook included), never in
+ * interrupt context, so the ring needs no locking.
+ *
+ ******************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "system.h"
+#include "alt_types.h"
+
+#include "timer_service.h"
+#include "cpu_load.h"
+#include "uart_tx.h"
+
+#define UART_TX_MASK (UART_TX_RING_SIZE - 1)
+
+#if (UART_TX_RING_SIZE & UART_TX_MASK) != 0
+#error "UART_TX_RING_SIZE must be a power of two"
+#endif
+
+static char uart_ring[UART_TX_RING_SIZE];
+static alt_u32 uart_head;       /* next byte to queue */
+static alt_u32 uart_tail;       /* next byte to send */
+static int uart_fd = -1;
+static struct uart_tx_stats uart_stats;
+
+int uart_tx_init( void )
+{
+#ifdef JTAG_UART_NAME
+  uart_fd = open(JTAG_UART_NAME, O_WRONLY | O_NONBLOCK);
+#endif
+  return uart_fd < 0 ? -1 : 0;
+}
+
+static int uart_space( void )
+{
+  return UART_TX_RING_SIZE - (uart_head - uart_tail);
+}
+
+static void uart_put( const char* buf, int len )
+{
+  int i;
+
+  if (uart_stats.queued == 0)
+  {
+    uart_stats.first_cycles = timer_now_cycles();
+  }
+  for (i = 0; i < len; i++)
+  {
+    uart_ring[(uart_head + i) & UART_TX_MASK] = buf[i];
+  }
+  uart_head += len;
+  uart_stats.queued += len;
+}
+
+void uart_tx_poll( void )
+{
+  alt_u32 at;
+  int chunk;
+  int n;
+
+  while (uart_fd >= 0 && uart_tail != uart_head)
+  {
+    /* The largest piece that is contiguous in the ring. */
+    at = uart_tail & UART_TX_MASK;
+    chunk = uart_head - uart_tail;
+    if (chunk > UART_TX_RING_SIZE - (int) at)
+    {
+      chunk = UART_TX_RING_SIZE - at;
+    }
+
+    n = write(uart_fd, &uart_ring[at], chunk);
+    if (n <= 0)
+    {
+      uart_stats.would_block++;
+      return;
+    }
+    uart_tail += n;
+    uart_stats.sent += n;
+    if (uart_tail == uart_head)
+    {
+      uart_stats.last_cycles = timer_now_cycles();
+    }
+  }
+}
+
+int uart_tx_write( const char* buf, int len )
+{
+  int prev;
+
+  if (uart_fd < 0 || len > UART_TX_RING_SIZE)
+  {
+    return -1;
+  }
+  if (uart_space() < len)
+  {
+    uart_stats.stalls++;
+    prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+    while (uart_space() < len)
+    {
+      uart_tx_poll();
+      timer_idle();
+    }
+    cpu_load_leave(prev);
+  }
+  uart_put(buf, len);
+  uart_tx_poll();
+  return len;
+}
+
+int uart_tx_try_write( const char* buf, int len )
+{
+  if (uart_fd < 0)
+  {
+    return 0;
+  }
+  if (len > uart_space())
+  {
+    len = uart_space();
+  }
+  uart_put(buf, len);
+  uart_tx_poll();
+  return len;
+}
+
+void uart_tx_flush( void )
+{
+  int prev = cpu_load_enter(CPU_LOAD_IO_WAIT);
+
+  while (uart_fd >= 0 && uart_tail != uart_head)
+  {
+    uart_tx_poll();
+    timer_idle();
+  }
+  cpu_load_leave(prev);
+}
+
+int uart_tx_pending( void )
+{
+  return uart_head - uart_tail;
+}
+
+void uart_tx_get_stats( struct uart_tx_stats* out )
+{
+  *out = uart_stats;
+}
+
+void uart_tx_reset_stats( void )
+{
+  uart_stats.queued = 0;
+  uart_stats.sent = 0;
+  uart_stats.stalls = 0;
+  uart_stats.would_block = 0;
+  uart_stats.first_cycles = 0;
+  uart_stats.last_cycles = 0;
+}
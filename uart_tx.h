@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ * uart_tx.h
+ *
+ * Buffered, non-blocking output to the JTAG UART.
+ *
+ * Output is built into whole lines in a RAM ring and moved from there into
+ * the HAL's altera_avalon_jtag_uart driver through a non-blocking descriptor.
+ * The driver owns the JTAG UART interrupt (stdout shares the device), and its
+ * write-FIFO-space interrupt moves the bytes on to the hardware; the CPU
+ * only waits when the ring itself is full.  The ring is topped up on every
+ * call and from the timer idle hook, so a delay keeps the link busy.
+ *
+ ******************************************************************************/
+
+#ifndef __UART_TX_H__
+#define __UART_TX_H__
+
+#include "alt_types.h"
+
+/* Ring size; must be a power of two. */
+#define UART_TX_RING_SIZE 4096
+
+struct uart_tx_stats
+{
+  alt_u32 queued;       /* bytes accepted into the ring */
+  alt_u32 sent;         /* bytes handed to the driver */
+  alt_u32 stalls;       /* times a producer had to wait for ring space */
+  alt_u32 would_block;  /* driver calls that took nothing */
+  alt_u64 first_cycles; /* timer_now_cycles() of the first byte queued */
+  alt_u64 last_cycles;  /* timer_now_cycles() when the ring last emptied */
+};
+
+/* Open the JTAG UART.  Returns 0, or -1 if the device could not be opened. */
+int uart_tx_init( void );
+
+/*
+ * Queue 'len' bytes as one unit: the call waits until the ring has room for
+ * all of them, so a line is never split by another producer.  Returns 'len',
+ * or -1 if the UART is not open or 'len' exceeds the ring.
+ */
+int uart_tx_write( const char* buf, int len );
+
+/* Queue what fits without waiting; returns the number of bytes taken. */
+int uart_tx_try_write( const char* buf, int len );
+
+/* Hand as much of the ring to the driver as it will take.  Never waits. */
+void uart_tx_poll( void );
+
+/* Wait until the ring is empty. */
+void uart_tx_flush( void );
+
+/* Bytes waiting in the ring. */
+int uart_tx_pending( void );
+
+void uart_tx_get_stats( struct uart_tx_stats* out );
+void uart_tx_reset_stats( void );
+
+#endif /* __UART_TX_H__ */